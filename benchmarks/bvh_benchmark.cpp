@@ -0,0 +1,145 @@
+// Frustum culling of a 100k object scene: brute force scalar and SIMD tests over every box against the dynamic
+// BVH, plus the cost of keeping the tree up to date while a tenth of the objects move every frame.
+
+#include <bvh.h>
+
+#include <algorithm>
+#include <chrono>
+#include <iostream>
+#include <random>
+#include <vector>
+
+namespace {
+
+using Clock = std::chrono::steady_clock;
+
+constexpr std::size_t OBJECT_COUNT = 100000;
+constexpr int REPEATS = 20;
+constexpr float WORLD_SIZE = 2000.0f;
+
+template<typename Fn>
+double bestMicroseconds(Fn &&fn) {
+    double best = 1e300;
+    for (int r = 0; r < REPEATS; r++) {
+        const auto start = Clock::now();
+        fn();
+        best = std::min(best, std::chrono::duration<double, std::micro>(Clock::now() - start).count());
+    }
+    return best;
+}
+
+Aabb randomBox(std::mt19937 &random) {
+    std::uniform_real_distribution<float> position(-WORLD_SIZE * 0.5f, WORLD_SIZE * 0.5f);
+    std::uniform_real_distribution<float> height(0.0f, 50.0f);
+    std::uniform_real_distribution<float> size(0.5f, 4.0f);
+    const vec3 min{position(random), height(random), position(random)};
+    return {min, min + vec3{size(random), size(random), size(random)}};
+}
+
+// Camera on the ground in the middle of the world, 60 degree field of view and a 500 unit far plane
+Frustum cameraFrustum(float yaw) {
+    const mat4 projection = perspective(PI / 3.0f, 16.0f / 9.0f, 0.1f, 500.0f);
+    const vec3 eye{0.0f, 20.0f, 0.0f};
+    const mat4 view = lookAt(eye, eye + vec3{std::sin(yaw), 0.0f, -std::cos(yaw)}, {0.0f, 1.0f, 0.0f});
+    const mat4 viewProjection = projection * view;
+    return extractFrustum(&viewProjection.columns[0].x);
+}
+
+} // namespace
+
+int main() {
+    std::mt19937 random(42);
+    std::vector<Aabb> boxes(OBJECT_COUNT);
+    for (Aabb &box : boxes) {
+        box = randomBox(random);
+    }
+    const Frustum frustum = cameraFrustum(0.0f);
+
+    // Brute force, scalar
+    std::size_t scalarVisible = 0;
+    const double scalar = bestMicroseconds([&] {
+        scalarVisible = 0;
+        for (const Aabb &box : boxes) {
+            scalarVisible += classifyBox(frustum, box) != Containment::OUTSIDE;
+        }
+    });
+
+    // Brute force, SIMD over structure-of-arrays copies of the boxes
+    std::vector<float> soa[6];
+    for (std::vector<float> &values : soa) {
+        values.resize(OBJECT_COUNT);
+    }
+    for (std::size_t i = 0; i < OBJECT_COUNT; i++) {
+        const vec3 center = (boxes[i].min + boxes[i].max) * 0.5f, extent = (boxes[i].max - boxes[i].min) * 0.5f;
+        soa[0][i] = center.x;
+        soa[1][i] = center.y;
+        soa[2][i] = center.z;
+        soa[3][i] = extent.x;
+        soa[4][i] = extent.y;
+        soa[5][i] = extent.z;
+    }
+    const BoxArrays arrays{soa[0].data(), soa[1].data(), soa[2].data(), soa[3].data(), soa[4].data(), soa[5].data()};
+    std::vector<Containment> results(OBJECT_COUNT);
+    std::size_t simdVisible = 0;
+    const double simd = bestMicroseconds([&] {
+        classifyBoxes(frustum, arrays, results.data(), OBJECT_COUNT);
+        simdVisible = OBJECT_COUNT - static_cast<std::size_t>(std::count(results.begin(), results.end(),
+                                                                          Containment::OUTSIDE));
+    });
+
+    // BVH: incremental build, then a SAH rebuild
+    Bvh bvh;
+    bvh.margin = 1.0f;
+    std::vector<std::uint32_t> leaves(OBJECT_COUNT);
+    auto start = Clock::now();
+    for (std::size_t i = 0; i < OBJECT_COUNT; i++) {
+        leaves[i] = insertBvhLeaf(bvh, boxes[i], static_cast<std::uint32_t>(i));
+    }
+    const double insertTime = std::chrono::duration<double, std::milli>(Clock::now() - start).count();
+    const float insertedCost = bvhCost(bvh);
+    start = Clock::now();
+    rebuildBvh(bvh);
+    const double rebuildTime = std::chrono::duration<double, std::milli>(Clock::now() - start).count();
+    const float rebuiltCost = bvhCost(bvh);
+
+    std::vector<std::uint32_t> visible;
+    BvhQueryStats stats;
+    const double query = bestMicroseconds([&] { queryBvh(bvh, frustum, visible, &stats); });
+
+    // Every truly visible object must be among the results (fat boxes make the BVH slightly conservative)
+    std::vector<char> found(OBJECT_COUNT, 0);
+    for (std::uint32_t object : visible) {
+        found[object] = 1;
+    }
+    std::size_t missed = 0;
+    for (std::size_t i = 0; i < OBJECT_COUNT; i++) {
+        missed += results[i] != Containment::OUTSIDE && !found[i];
+    }
+
+    // Dynamic scene: 10% of the objects drift every frame
+    std::uniform_int_distribution<std::size_t> pick(0, OBJECT_COUNT - 1);
+    std::uniform_real_distribution<float> drift(-0.5f, 0.5f);
+    std::size_t reinserted = 0;
+    const double update = bestMicroseconds([&] {
+        for (std::size_t m = 0; m < OBJECT_COUNT / 10; m++) {
+            const std::size_t i = pick(random);
+            const vec3 step{drift(random), 0.0f, drift(random)};
+            boxes[i] = {boxes[i].min + step, boxes[i].max + step};
+            reinserted += moveBvhLeaf(bvh, leaves[i], boxes[i]);
+        }
+    });
+    const float movedCost = bvhCost(bvh);
+    const double movedQuery = bestMicroseconds([&] { queryBvh(bvh, frustum, visible, &stats); });
+
+    std::cout << OBJECT_COUNT << " objects, " << simdVisible << " visible" << std::endl;
+    std::cout << "brute force scalar: " << scalar << " us (" << scalarVisible << " visible)" << std::endl;
+    std::cout << "brute force simd:   " << simd << " us, speedup " << scalar / simd << "x" << std::endl;
+    std::cout << "bvh insert: " << insertTime << " ms, cost " << insertedCost << "; sah rebuild: " << rebuildTime
+              << " ms, cost " << rebuiltCost << std::endl;
+    std::cout << "bvh query: " << query << " us, " << stats.nodesTested << " nodes tested, " << visible.size()
+              << " returned, " << missed << " missed, speedup over simd brute force " << simd / query << "x"
+              << std::endl;
+    std::cout << "bvh update (10% moving): " << update << " us per frame, " << reinserted << " reinsertions over "
+              << REPEATS << " frames, cost " << movedCost << ", query " << movedQuery << " us" << std::endl;
+    return missed == 0 ? 0 : 1;
+}
@@ -0,0 +1,122 @@
+// Clustered light assignment of 4096 point lights: the SIMD slice kernels against a brute force sphere test of
+// every light against every froxel, for the orthographic view the demo renders and a perspective camera. Any
+// cluster whose light list differs from brute force fails the run.
+
+#include <clustered_lighting.h>
+#include <job_system.h>
+
+#include <algorithm>
+#include <chrono>
+#include <iostream>
+#include <random>
+#include <vector>
+
+namespace {
+
+using Clock = std::chrono::steady_clock;
+
+constexpr std::size_t LIGHT_COUNT = 4096;
+constexpr int REPEATS = 20;
+constexpr int RENDER_WIDTH = 1920;
+constexpr int RENDER_HEIGHT = 1080;
+
+struct Setup {
+    const char *name;
+    mat4 view;
+    mat4 projection;
+    float nearDepth;
+    float farDepth;
+    std::vector<PointLight> lights;
+};
+
+// The demo's setup: a slab of small lights around z = 0, seen straight on through a depth range of 9 to 11
+Setup orthographicSetup(std::mt19937 &random) {
+    std::uniform_real_distribution<float> unit(-1.0f, 1.0f);
+    Setup setup{"orthographic", translation({0.0f, 0.0f, -10.0f}), translation({0.0f, 0.0f, 10.0f}), 9.0f, 11.0f,
+                std::vector<PointLight>(LIGHT_COUNT)};
+    for (PointLight &light : setup.lights) {
+        light.position = {unit(random), unit(random), 0.1f + 0.1f * unit(random)};
+        light.radius = 0.07f + 0.03f * unit(random);
+        light.color = {1.0f, 1.0f, 1.0f};
+    }
+    return setup;
+}
+
+// Lights scattered over a 40 x 10 x 40 volume, seen from above its edge with a 60 unit far plane
+Setup perspectiveSetup(std::mt19937 &random) {
+    std::uniform_real_distribution<float> unit(-1.0f, 1.0f);
+    Setup setup{"perspective", lookAt({0.0f, 3.0f, 10.0f}, {0.0f, 0.0f, 0.0f}, {0.0f, 1.0f, 0.0f}),
+                perspective(1.0f, 16.0f / 9.0f, 0.5f, 60.0f), 0.5f, 60.0f, std::vector<PointLight>(LIGHT_COUNT)};
+    for (PointLight &light : setup.lights) {
+        light.position = {unit(random) * 20.0f, unit(random) * 5.0f, unit(random) * 20.0f};
+        light.radius = 1.5f + unit(random);
+        light.color = {1.0f, 1.0f, 1.0f};
+    }
+    return setup;
+}
+
+// Same test as the kernels: the sphere reaches the box when its center is closer than the radius
+bool touches(const ClusterBounds &box, const vec3 &center, float radius) {
+    auto distance = [](float min, float max, float value) {
+        return value < min ? min - value : (value > max ? value - max : 0.0f);
+    };
+    const float dx = distance(box.minX, box.maxX, center.x);
+    const float dy = distance(box.minY, box.maxY, center.y);
+    const float dz = distance(box.minZ, box.maxZ, center.z);
+    return dx * dx + dy * dy + dz * dz < radius * radius;
+}
+
+// Clusters whose light list differs from testing every light against every froxel
+std::size_t countMismatches(const ClusteredLighting &clusters, const Setup &setup, double &bruteForceMilliseconds) {
+    std::vector<vec3> viewPositions(setup.lights.size());
+    for (std::size_t i = 0; i < setup.lights.size(); i++) {
+        viewPositions[i] = transformPoint(setup.view, setup.lights[i].position);
+    }
+
+    std::size_t mismatches = 0;
+    std::vector<std::uint16_t> expected, assigned;
+    const auto start = Clock::now();
+    for (std::uint32_t cluster = 0; cluster < CLUSTER_COUNT; cluster++) {
+        expected.clear();
+        for (std::size_t i = 0; i < setup.lights.size(); i++) {
+            if (touches(clusters.bounds[cluster], viewPositions[i], setup.lights[i].radius)) {
+                expected.push_back(static_cast<std::uint16_t>(i));
+            }
+        }
+        const auto first = clusters.indices.begin() + clusters.ranges[cluster * 2];
+        assigned.assign(first, first + clusters.ranges[cluster * 2 + 1]);
+        std::ranges::sort(assigned);
+        mismatches += assigned != expected;
+    }
+    bruteForceMilliseconds = std::chrono::duration<double, std::milli>(Clock::now() - start).count();
+    return mismatches;
+}
+
+} // namespace
+
+int main() {
+    initJobSystem();
+    std::mt19937 random(7);
+    const Setup setups[] = {orthographicSetup(random), perspectiveSetup(random)};
+
+    std::size_t totalMismatches = 0;
+    for (const Setup &setup : setups) {
+        ClusteredLighting clusters;
+        double best = 1e300;
+        for (int r = 0; r < REPEATS; r++) {
+            assignClusters(clusters, setup.lights, setup.view, setup.projection, setup.nearDepth, setup.farDepth,
+                           RENDER_WIDTH, RENDER_HEIGHT);
+            best = std::min(best, clusters.stats.buildMilliseconds);
+        }
+
+        double bruteForce = 0.0;
+        const std::size_t mismatches = countMismatches(clusters, setup, bruteForce);
+        totalMismatches += mismatches;
+        std::cout << setup.name << ": " << LIGHT_COUNT << " lights into " << CLUSTER_COUNT << " clusters in " << best
+                  << " ms (brute force " << bruteForce << " ms, " << bruteForce / best << "x), "
+                  << clusters.stats.indices << " references, at most " << clusters.stats.maxClusterLights
+                  << " lights in a cluster, " << mismatches << " mismatched clusters" << std::endl;
+    }
+    shutdownJobSystem();
+    return totalMismatches == 0 ? 0 : 1;
+}
@@ -0,0 +1,113 @@
+// Scheduling overhead of the job system: submission and completion cost of empty jobs, parallelFor against a
+// serial loop, and a thread per task as the baseline the job system replaces.
+
+#include <job_system.h>
+
+#include <chrono>
+#include <cmath>
+#include <iostream>
+#include <thread>
+#include <vector>
+
+namespace {
+
+using Clock = std::chrono::steady_clock;
+
+double nanosecondsSince(Clock::time_point start) {
+    return std::chrono::duration<double, std::nano>(Clock::now() - start).count();
+}
+
+void report(const char *name, double nanoseconds, std::size_t count, const char *unit) {
+    std::cout << name << ": " << nanoseconds / static_cast<double>(count) << " ns/" << unit << std::endl;
+}
+
+void emptyJobs() {
+    constexpr std::size_t BATCH = 1024; // stays well under MAX_JOBS_PER_WORKER in flight
+    constexpr std::size_t BATCHES = 1000;
+    const auto start = Clock::now();
+    for (std::size_t b = 0; b < BATCHES; b++) {
+        JobCounter counter;
+        for (std::size_t i = 0; i < BATCH; i++) {
+            runJob([] {}, counter);
+        }
+        waitForCounter(counter);
+    }
+    report("empty job, submit + run + wait", nanosecondsSince(start), BATCH * BATCHES, "job");
+}
+
+void nestedJobs() {
+    // Every job fans out children from its own worker, so most of the work is spread by stealing
+    constexpr std::size_t ROOTS = 64;
+    constexpr std::size_t CHILDREN = 256;
+    std::atomic<std::size_t> done{0};
+    const auto start = Clock::now();
+    for (int repeat = 0; repeat < 20; repeat++) {
+        JobCounter roots;
+        for (std::size_t r = 0; r < ROOTS; r++) {
+            runJob([&done] {
+                JobCounter children;
+                for (std::size_t c = 0; c < CHILDREN; c++) {
+                    runJob([&done] { done.fetch_add(1, std::memory_order_relaxed); }, children);
+                }
+                waitForCounter(children);
+            }, roots);
+        }
+        waitForCounter(roots);
+    }
+    report("nested job, fan out from workers", nanosecondsSince(start), done.load(), "job");
+}
+
+float work(std::size_t i) {
+    return std::sqrt(static_cast<float>(i)) * 0.5f;
+}
+
+void parallelLoop() {
+    constexpr std::size_t COUNT = 1 << 24;
+    std::vector<float> out(COUNT);
+
+    auto start = Clock::now();
+    for (std::size_t i = 0; i < COUNT; i++) {
+        out[i] = work(i);
+    }
+    const double serial = nanosecondsSince(start);
+
+    start = Clock::now();
+    parallelFor(COUNT, 16 * 1024, [&](std::size_t begin, std::size_t end) {
+        for (std::size_t i = begin; i < end; i++) {
+            out[i] = work(i);
+        }
+    });
+    const double parallel = nanosecondsSince(start);
+
+    report("serial loop", serial, COUNT, "item");
+    report("parallelFor", parallel, COUNT, "item");
+    std::cout << "parallelFor speedup: " << serial / parallel << "x (checksum " << out[COUNT / 3] << ")" << std::endl;
+}
+
+void threadPerTask() {
+    constexpr std::size_t TASKS = 2000;
+    std::atomic<std::size_t> done{0};
+    const auto start = Clock::now();
+    for (std::size_t i = 0; i < TASKS; i += 8) {
+        std::vector<std::jthread> threads;
+        for (std::size_t t = 0; t < 8; t++) {
+            threads.emplace_back([&done] { done.fetch_add(1, std::memory_order_relaxed); });
+        }
+    }
+    report("thread per task (baseline)", nanosecondsSince(start), TASKS, "task");
+}
+
+} // namespace
+
+int main() {
+    initJobSystem();
+    std::cout << jobWorkerCount() << " workers" << std::endl;
+
+    emptyJobs();
+    nestedJobs();
+    parallelLoop();
+    threadPerTask();
+
+    shutdownJobSystem();
+    return 0;
+}
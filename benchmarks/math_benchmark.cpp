@@ -0,0 +1,156 @@
+// SIMD math kernels against straightforward scalar references: SoA point transforms, batched mat4 products
+// and fast sin/cos, with the largest deviation from the reference next to the timings.
+
+#include <vector_math.h>
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <iostream>
+#include <random>
+#include <vector>
+
+namespace {
+
+using Clock = std::chrono::steady_clock;
+
+constexpr int REPEATS = 20;
+
+template<typename Fn>
+double bestNanoseconds(Fn &&fn) {
+    double best = 1e300;
+    for (int r = 0; r < REPEATS; r++) {
+        const auto start = Clock::now();
+        fn();
+        best = std::min(best, std::chrono::duration<double, std::nano>(Clock::now() - start).count());
+    }
+    return best;
+}
+
+void report(const char *name, double scalar, double simd, std::size_t count, double maxError) {
+    std::cout << name << ": scalar " << scalar / static_cast<double>(count) << " ns, simd "
+              << simd / static_cast<double>(count) << " ns, speedup " << scalar / simd << "x, max error "
+              << maxError << std::endl;
+}
+
+mat4 randomMatrix(std::mt19937 &random) {
+    std::uniform_real_distribution<float> value(-2.0f, 2.0f);
+    return composeTransform({value(random), value(random), value(random)},
+                            axisAngle({value(random), value(random), 1.0f}, value(random)),
+                            {1.0f + value(random) * 0.25f, 1.0f, 1.0f});
+}
+
+void benchmarkTransformPoints(std::mt19937 &random) {
+    constexpr std::size_t COUNT = 1 << 20;
+    std::uniform_real_distribution<float> value(-100.0f, 100.0f);
+    std::vector<float> x(COUNT), y(COUNT), z(COUNT);
+    for (std::size_t i = 0; i < COUNT; i++) {
+        x[i] = value(random);
+        y[i] = value(random);
+        z[i] = value(random);
+    }
+    const mat4 m = randomMatrix(random);
+    std::vector<float> sx(COUNT), sy(COUNT), sz(COUNT), vx(COUNT), vy(COUNT), vz(COUNT);
+
+    const double scalar = bestNanoseconds([&] {
+        const float *c = &m.columns[0].x;
+        for (std::size_t i = 0; i < COUNT; i++) {
+            sx[i] = c[0] * x[i] + c[4] * y[i] + c[8] * z[i] + c[12];
+            sy[i] = c[1] * x[i] + c[5] * y[i] + c[9] * z[i] + c[13];
+            sz[i] = c[2] * x[i] + c[6] * y[i] + c[10] * z[i] + c[14];
+        }
+    });
+    const double simd = bestNanoseconds([&] {
+        transformPointsSoA(m, x.data(), y.data(), z.data(), vx.data(), vy.data(), vz.data(), COUNT);
+    });
+
+    double maxError = 0.0;
+    for (std::size_t i = 0; i < COUNT; i++) {
+        maxError = std::max({maxError, std::fabs(double(sx[i]) - vx[i]), std::fabs(double(sy[i]) - vy[i]),
+                             std::fabs(double(sz[i]) - vz[i])});
+    }
+    report("transformPointsSoA (per point)", scalar, simd, COUNT, maxError);
+}
+
+void benchmarkMatrixProducts(std::mt19937 &random) {
+    constexpr std::size_t COUNT = 1 << 16;
+    std::vector<mat4> a(COUNT), b(COUNT), scalarOut(COUNT), simdOut(COUNT);
+    for (std::size_t i = 0; i < COUNT; i++) {
+        a[i] = randomMatrix(random);
+        b[i] = randomMatrix(random);
+    }
+
+    const double scalar = bestNanoseconds([&] {
+        for (std::size_t i = 0; i < COUNT; i++) {
+            const float *l = &a[i].columns[0].x, *r = &b[i].columns[0].x;
+            float *o = &scalarOut[i].columns[0].x;
+            for (int column = 0; column < 4; column++) {
+                for (int row = 0; row < 4; row++) {
+                    float sum = 0.0f;
+                    for (int k = 0; k < 4; k++) {
+                        sum += l[k * 4 + row] * r[column * 4 + k];
+                    }
+                    o[column * 4 + row] = sum;
+                }
+            }
+        }
+    });
+    const double simd = bestNanoseconds([&] {
+        multiplyMatrices(a.data(), b.data(), simdOut.data(), COUNT);
+    });
+
+    double maxError = 0.0;
+    for (std::size_t i = 0; i < COUNT; i++) {
+        for (int k = 0; k < 16; k++) {
+            maxError = std::max(maxError, std::fabs(double((&scalarOut[i].columns[0].x)[k]) -
+                                                    (&simdOut[i].columns[0].x)[k]));
+        }
+    }
+    report("multiplyMatrices (per product)", scalar, simd, COUNT, maxError);
+}
+
+void benchmarkSinCos(std::mt19937 &random) {
+    constexpr std::size_t COUNT = 1 << 20;
+    std::uniform_real_distribution<float> value(-100.0f, 100.0f);
+    std::vector<float> angles(COUNT), scalarSin(COUNT), scalarCos(COUNT), simdSin(COUNT), simdCos(COUNT);
+    for (float &angle : angles) {
+        angle = value(random);
+    }
+
+    const double scalar = bestNanoseconds([&] {
+        for (std::size_t i = 0; i < COUNT; i++) {
+            scalarSin[i] = std::sin(angles[i]);
+            scalarCos[i] = std::cos(angles[i]);
+        }
+    });
+    const double simd = bestNanoseconds([&] {
+        sinCos(angles.data(), simdSin.data(), simdCos.data(), COUNT);
+    });
+
+    double maxError = 0.0;
+    for (std::size_t i = 0; i < COUNT; i++) {
+        maxError = std::max({maxError, std::fabs(double(scalarSin[i]) - simdSin[i]),
+                             std::fabs(double(scalarCos[i]) - simdCos[i])});
+    }
+    report("sinCos (per angle)", scalar, simd, COUNT, maxError);
+}
+
+} // namespace
+
+int main() {
+#if SIMD_AVX
+    std::cout << "lanes: AVX, 8 wide" << std::endl;
+#elif SIMD_SSE
+    std::cout << "lanes: SSE2, 4 wide" << std::endl;
+#elif SIMD_NEON
+    std::cout << "lanes: NEON, 4 wide" << std::endl;
+#else
+    std::cout << "lanes: scalar fallback" << std::endl;
+#endif
+
+    std::mt19937 random(42);
+    benchmarkTransformPoints(random);
+    benchmarkMatrixProducts(random);
+    benchmarkSinCos(random);
+    return 0;
+}
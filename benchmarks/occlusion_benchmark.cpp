@@ -0,0 +1,109 @@
+// Software occlusion culling of a 40 x 40 grid of boxes behind a wall: rasterizing the wall, building the
+// hierarchical-Z pyramid and testing every box, checked against exact ray casts from the eye through each box
+// corner. A visible box reported as occluded, or a pyramid that finds too few of the hidden ones, fails the run.
+
+#include <occlusion.h>
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <iostream>
+#include <vector>
+
+namespace {
+
+using Clock = std::chrono::steady_clock;
+
+constexpr int GRID_SIZE = 40;
+constexpr float GRID_SPACING = 1.0f;
+constexpr float BOX_SIZE = 0.5f;
+constexpr int REPEATS = 20;
+// The pyramid is conservative, but a wall this size should hide most of what is really behind it
+constexpr double MIN_DETECTED_FRACTION = 0.8;
+
+// The wall is a unit quad scaled and moved into place by its world matrix, like a mesh instance
+constexpr float WALL_POSITIONS[] = {-0.5f, -0.5f, 0.0f, 0.5f, -0.5f, 0.0f, 0.5f, 0.5f, 0.0f, -0.5f, 0.5f, 0.0f};
+constexpr unsigned int WALL_INDICES[] = {0, 1, 2, 0, 2, 3};
+constexpr float WALL_WIDTH = 12.0f;
+constexpr float WALL_HEIGHT = 6.0f;
+constexpr vec3 WALL_CENTER{0.0f, 2.0f, 0.0f};
+constexpr vec3 EYE{0.0f, 1.5f, 10.0f};
+
+template<typename Fn>
+double bestMicroseconds(Fn &&fn) {
+    double best = 1e300;
+    for (int r = 0; r < REPEATS; r++) {
+        const auto start = Clock::now();
+        fn();
+        best = std::min(best, std::chrono::duration<double, std::micro>(Clock::now() - start).count());
+    }
+    return best;
+}
+
+// Exact answer for a convex box behind a convex planar wall: hidden when the segment from the eye to every
+// corner crosses the wall's plane inside the wall
+bool hiddenByWall(const Aabb &box) {
+    for (int corner = 0; corner < 8; corner++) {
+        const vec3 point{corner & 1 ? box.max.x : box.min.x, corner & 2 ? box.max.y : box.min.y,
+                         corner & 4 ? box.max.z : box.min.z};
+        if (point.z >= WALL_CENTER.z) {
+            return false;
+        }
+        const float t = (EYE.z - WALL_CENTER.z) / (EYE.z - point.z);
+        const vec3 crossing = EYE + (point - EYE) * t;
+        if (std::abs(crossing.x - WALL_CENTER.x) > WALL_WIDTH * 0.5f ||
+            std::abs(crossing.y - WALL_CENTER.y) > WALL_HEIGHT * 0.5f) {
+            return false;
+        }
+    }
+    return true;
+}
+
+} // namespace
+
+int main() {
+    // Boxes resting on the ground from just in front of the wall to 40 units behind it
+    std::vector<Aabb> boxes;
+    for (int z = 0; z < GRID_SIZE; z++) {
+        for (int x = 0; x < GRID_SIZE; x++) {
+            const vec3 min{(static_cast<float>(x) - GRID_SIZE * 0.5f) * GRID_SPACING, 0.0f,
+                           2.0f - static_cast<float>(z) * GRID_SPACING};
+            boxes.push_back({min, min + vec3{BOX_SIZE, BOX_SIZE, BOX_SIZE}});
+        }
+    }
+
+    const mat4 viewProjection = perspective(PI / 3.0f,
+                                            static_cast<float>(OCCLUSION_WIDTH) / static_cast<float>(OCCLUSION_HEIGHT),
+                                            0.1f, 100.0f) *
+                                lookAt(EYE, {EYE.x, EYE.y, 0.0f}, {0.0f, 1.0f, 0.0f});
+    const mat4 wallWorld = translation(WALL_CENTER) * scaling({WALL_WIDTH, WALL_HEIGHT, 1.0f});
+
+    OcclusionBuffer occlusion;
+    std::vector<char> occluded(boxes.size());
+    const double frame = bestMicroseconds([&] {
+        beginOcclusionBuffer(occlusion);
+        rasterizeOccluder(occlusion, viewProjection * wallWorld, WALL_POSITIONS, WALL_INDICES, std::size(WALL_INDICES));
+        buildDepthPyramid(occlusion);
+        for (std::size_t i = 0; i < boxes.size(); i++) {
+            occluded[i] = isOccluded(occlusion, viewProjection, boxes[i]);
+        }
+    });
+
+    std::size_t hidden = 0, detected = 0, wronglyOccluded = 0;
+    for (std::size_t i = 0; i < boxes.size(); i++) {
+        const bool reallyHidden = hiddenByWall(boxes[i]);
+        hidden += reallyHidden;
+        detected += reallyHidden && occluded[i];
+        wronglyOccluded += !reallyHidden && occluded[i];
+    }
+    const double detectedFraction = hidden > 0 ? static_cast<double>(detected) / static_cast<double>(hidden) : 0.0;
+
+    std::cout << boxes.size() << " boxes, " << hidden << " hidden by the wall, " << boxes.size() - hidden
+              << " visible" << std::endl;
+    std::cout << "raster + pyramid + tests: " << frame << " us, " << occlusion.stats.occluderTriangles
+              << " occluder triangles, " << occlusion.stats.occluded << " of " << occlusion.stats.tested
+              << " occluded" << std::endl;
+    std::cout << "hidden boxes found: " << detected << " (" << detectedFraction * 100.0 << "%), visible boxes "
+              << "reported occluded: " << wronglyOccluded << std::endl;
+    return wronglyOccluded == 0 && detectedFraction >= MIN_DETECTED_FRACTION ? 0 : 1;
+}
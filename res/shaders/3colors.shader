@@ -1,19 +1,58 @@
+#keywords COLOR_SHIFT CLUSTERED_LIGHTING
 #shader vertex
 #version 330 core
 layout (location = 0) in vec3 aPos;
 layout (location = 1) in vec3 aColor;
-uniform vec2 offset;
+layout (location = 2) in vec2 aNormal;
+layout (std140) uniform Transform {
+    mat4 model;
+};
+#include "draw_block.glsl"
 out vec3 ourColor;
+#ifdef CLUSTERED_LIGHTING
+#include "cluster_block.glsl"
+out vec3 worldPosition;
+out vec3 worldNormal;
+out float viewDepth;
+// Inverse of encodeOctahedral in vertex_layout.cpp
+vec3 decodeOctahedral(vec2 e) {
+    vec3 n = vec3(e, 1.0 - abs(e.x) - abs(e.y));
+    float t = max(-n.z, 0.0);
+    n.xy += vec2(n.x >= 0.0 ? -t : t, n.y >= 0.0 ? -t : t);
+    return normalize(n);
+}
+#endif
 void main()
 {
-    gl_Position = vec4(aPos.x + offset.x, aPos.y + offset.y, aPos.z, 1.0);
+    vec3 position = aPos * positionScale.xyz + positionBias.xyz;
+    gl_Position = model * vec4(position, 1.0);
     ourColor = aColor;
+#ifdef CLUSTERED_LIGHTING
+    // The scene is drawn in clip space, the world matrix is all the transform there is
+    worldPosition = gl_Position.xyz;
+    worldNormal = mat3(model) * decodeOctahedral(aNormal);
+    viewDepth = -(view * gl_Position).z;
+#endif
 }
 #shader fragment
 #version 330 core
 in vec3 ourColor;
 out vec4 FragColor;
-uniform float shiftColor;
+#include "draw_block.glsl"
+#ifdef CLUSTERED_LIGHTING
+#include "clustered_lighting.glsl"
+in vec3 worldPosition;
+in vec3 worldNormal;
+in float viewDepth;
+const float AMBIENT = 0.2;
+#endif
 void main() {
-    FragColor = vec4(ourColor.xyz * shiftColor, 1.0f);
+    vec3 color = ourColor.xyz;
+#ifdef COLOR_SHIFT
+    color *= colorShift.x;
+#endif
+#ifdef CLUSTERED_LIGHTING
+    color *= AMBIENT + clusteredLighting(worldPosition, normalize(worldNormal), viewDepth);
+#endif
+    FragColor = vec4(color, 1.0f);
 }
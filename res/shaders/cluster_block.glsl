@@ -0,0 +1,5 @@
+layout (std140) uniform Clusters {
+    mat4 view;
+    vec4 clusterGrid;   // tiles x, tiles y, slices
+    vec4 clusterScale;  // tiles per pixel in x and y, then slice = log(view depth) * z + w
+};
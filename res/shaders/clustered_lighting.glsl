@@ -0,0 +1,26 @@
+#include "cluster_block.glsl"
+uniform samplerBuffer pointLights;     // two texels per light: position and radius, color
+uniform usamplerBuffer clusterRanges;  // offset and count per cluster
+uniform usamplerBuffer clusterLights;  // light indices, the clusters' lists back to back
+
+// Diffuse light reaching a surface from the point lights of its cluster
+vec3 clusteredLighting(vec3 position, vec3 normal, float viewDepth) {
+    vec3 slice = vec3(gl_FragCoord.xy * clusterScale.xy, log(max(viewDepth, 1e-4)) * clusterScale.z + clusterScale.w);
+    ivec3 cluster = clamp(ivec3(slice), ivec3(0), ivec3(clusterGrid.xyz) - 1);
+    int index = (cluster.z * int(clusterGrid.y) + cluster.y) * int(clusterGrid.x) + cluster.x;
+    uvec2 range = texelFetch(clusterRanges, index).xy;
+
+    vec3 light = vec3(0.0);
+    for (uint i = 0u; i < range.y; i++) {
+        int lightIndex = int(texelFetch(clusterLights, int(range.x + i)).x);
+        vec4 positionRadius = texelFetch(pointLights, lightIndex * 2);
+        vec3 color = texelFetch(pointLights, lightIndex * 2 + 1).rgb;
+        vec3 toLight = positionRadius.xyz - position;
+        float distanceSquared = dot(toLight, toLight);
+        // Smooth window reaching zero at the radius, so clusters can leave the light out past it
+        float falloff = clamp(1.0 - distanceSquared / (positionRadius.w * positionRadius.w), 0.0, 1.0);
+        float diffuse = max(dot(normal, toLight * inversesqrt(max(distanceSquared, 1e-8))), 0.0);
+        light += color * (diffuse * falloff * falloff);
+    }
+    return light;
+}
@@ -0,0 +1,5 @@
+layout (std140) uniform Draw {
+    vec4 positionScale;
+    vec4 positionBias;
+    vec4 colorShift;
+};
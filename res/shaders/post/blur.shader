@@ -0,0 +1,20 @@
+#shader vertex
+#version 330 core
+#include "fullscreen.glsl"
+#shader fragment
+#version 330 core
+in vec2 uv;
+out vec4 FragColor;
+uniform sampler2D source;
+uniform vec2 direction;  // one texel along the blurred axis
+// 9 tap gaussian, neighbouring taps folded into single bilinear fetches
+const float weights[3] = float[](0.2270270270, 0.3162162162, 0.0702702703);
+const float offsets[3] = float[](0.0, 1.3846153846, 3.2307692308);
+void main() {
+    vec3 color = texture(source, uv).rgb * weights[0];
+    for (int i = 1; i < 3; i++) {
+        color += texture(source, uv + direction * offsets[i]).rgb * weights[i];
+        color += texture(source, uv - direction * offsets[i]).rgb * weights[i];
+    }
+    FragColor = vec4(color, 1.0);
+}
@@ -0,0 +1,27 @@
+#keywords THRESHOLD
+#shader vertex
+#version 330 core
+#include "fullscreen.glsl"
+#shader fragment
+#version 330 core
+in vec2 uv;
+out vec4 FragColor;
+uniform sampler2D source;
+uniform vec2 texelSize;  // of the source
+uniform vec4 threshold;  // threshold, knee, 2 * knee, 0.25 / knee
+void main() {
+    // Four bilinear taps around the destination texel average the 4x4 source texels under it
+    vec3 color = texture(source, uv + texelSize * vec2(-1.0, -1.0)).rgb;
+    color += texture(source, uv + texelSize * vec2(1.0, -1.0)).rgb;
+    color += texture(source, uv + texelSize * vec2(-1.0, 1.0)).rgb;
+    color += texture(source, uv + texelSize * vec2(1.0, 1.0)).rgb;
+    color *= 0.25;
+#ifdef THRESHOLD
+    // Keep what is brighter than the threshold, with a quadratic knee instead of a hard cut
+    float brightness = max(color.r, max(color.g, color.b));
+    float soft = clamp(brightness - threshold.x + threshold.y, 0.0, threshold.z);
+    soft = soft * soft * threshold.w;
+    color *= max(soft, brightness - threshold.x) / max(brightness, 1e-4);
+#endif
+    FragColor = vec4(color, 1.0);
+}
@@ -0,0 +1,8 @@
+out vec2 uv;
+void main()
+{
+    // One triangle over the whole target, corners from the vertex index, no vertex buffer needed
+    vec2 corner = vec2((gl_VertexID << 1) & 2, gl_VertexID & 2);
+    uv = corner;
+    gl_Position = vec4(corner * 2.0 - 1.0, 0.0, 1.0);
+}
@@ -0,0 +1,35 @@
+#shader vertex
+#version 330 core
+#include "fullscreen.glsl"
+#shader fragment
+#version 330 core
+in vec2 uv;
+out vec4 FragColor;
+uniform sampler2D source;  // color with luma in alpha
+uniform vec2 texelSize;
+const float REDUCE_MIN = 1.0 / 128.0;
+const float REDUCE_MUL = 1.0 / 8.0;
+const float SPAN_MAX = 8.0;
+void main() {
+    float lumaNW = texture(source, uv + vec2(-1.0, -1.0) * texelSize).a;
+    float lumaNE = texture(source, uv + vec2(1.0, -1.0) * texelSize).a;
+    float lumaSW = texture(source, uv + vec2(-1.0, 1.0) * texelSize).a;
+    float lumaSE = texture(source, uv + vec2(1.0, 1.0) * texelSize).a;
+    vec4 center = texture(source, uv);
+    float lumaMin = min(center.a, min(min(lumaNW, lumaNE), min(lumaSW, lumaSE)));
+    float lumaMax = max(center.a, max(max(lumaNW, lumaNE), max(lumaSW, lumaSE)));
+
+    // Blur along the edge, perpendicular to the luma gradient, further the flatter the edge
+    vec2 direction = vec2(-((lumaNW + lumaNE) - (lumaSW + lumaSE)), (lumaNW + lumaSW) - (lumaNE + lumaSE));
+    float reduce = max((lumaNW + lumaNE + lumaSW + lumaSE) * 0.25 * REDUCE_MUL, REDUCE_MIN);
+    float scale = 1.0 / (min(abs(direction.x), abs(direction.y)) + reduce);
+    direction = clamp(direction * scale, -SPAN_MAX, SPAN_MAX) * texelSize;
+
+    vec3 inner = 0.5 * (texture(source, uv + direction * (1.0 / 3.0 - 0.5)).rgb +
+                        texture(source, uv + direction * (2.0 / 3.0 - 0.5)).rgb);
+    vec3 outer = inner * 0.5 + 0.25 * (texture(source, uv - direction * 0.5).rgb +
+                                       texture(source, uv + direction * 0.5).rgb);
+    // The wider taps crossed into another edge when their luma leaves the neighbourhood's range
+    float lumaOuter = dot(outer, vec3(0.299, 0.587, 0.114));
+    FragColor = vec4(lumaOuter < lumaMin || lumaOuter > lumaMax ? inner : outer, 1.0);
+}
@@ -0,0 +1,37 @@
+#keywords BLOOM
+#shader vertex
+#version 330 core
+#include "fullscreen.glsl"
+#shader fragment
+#version 330 core
+in vec2 uv;
+out vec4 FragColor;
+uniform sampler2D source;
+uniform sampler2D bloom;
+uniform float exposure;
+uniform float bloomIntensity;
+uniform vec3 lift;
+uniform vec3 gamma;
+uniform vec3 gain;
+uniform vec2 grade;  // saturation, contrast
+// Narkowicz's fit of the ACES filmic curve
+vec3 aces(vec3 x) {
+    return clamp((x * (2.51 * x + 0.03)) / (x * (2.43 * x + 0.59) + 0.14), 0.0, 1.0);
+}
+void main() {
+    // The scene's colors are authored for display, undo the display gamma before tonemapping
+    vec3 color = pow(texture(source, uv).rgb, vec3(2.2));
+#ifdef BLOOM
+    color += texture(bloom, uv).rgb * bloomIntensity;
+#endif
+    color = pow(aces(color * exposure), vec3(1.0 / 2.2));
+
+    // Grading in display space: lift, gamma, gain, then contrast around mid grey and saturation
+    color = pow(max(gain * (color + lift * (1.0 - color)), 0.0), 1.0 / gamma);
+    color = (color - 0.5) * grade.y + 0.5;
+    float luma = dot(color, vec3(0.299, 0.587, 0.114));
+    color = clamp(mix(vec3(luma), color, grade.x), 0.0, 1.0);
+
+    // FXAA reads the luma from alpha
+    FragColor = vec4(color, dot(color, vec3(0.299, 0.587, 0.114)));
+}
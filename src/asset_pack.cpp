@@ -0,0 +1,345 @@
+#include <asset_pack.h>
+
+#include <algorithm>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <numeric>
+#include <system_error>
+
+namespace {
+
+constexpr char ASSET_PACK_MAGIC[4] = {'A', 'P', 'A', 'K'};
+constexpr std::uint32_t ASSET_PACK_VERSION = 1;
+
+struct AssetPackHeader {
+    char magic[4];
+    std::uint32_t version;
+    std::uint32_t entryCount;
+    std::uint32_t pathsSize;
+    std::uint64_t entriesOffset;
+    std::uint64_t pathsOffset;
+};
+
+// LZ4 block format limits: matches are at least 4 bytes, reach back at most 64 KiB, and the last 5 bytes of a block
+// are always literals, with no match starting in the last 12
+constexpr std::size_t MIN_MATCH = 4;
+constexpr std::size_t LAST_LITERALS = 5;
+constexpr std::size_t MATCH_START_LIMIT = 12;
+constexpr std::size_t MAX_OFFSET = 65535;
+constexpr int HASH_BITS = 16;
+
+constexpr std::uint64_t alignUp(std::uint64_t value, std::uint64_t alignment) {
+    return (value + alignment - 1) & ~(alignment - 1);
+}
+
+std::uint32_t read32(const unsigned char *p) {
+    std::uint32_t value;
+    std::memcpy(&value, p, sizeof(value));
+    return value;
+}
+
+std::uint32_t hashSequence(std::uint32_t sequence) {
+    return (sequence * 2654435761u) >> (32 - HASH_BITS);
+}
+
+// Lengths past a token nibble continue in bytes of 255 and a final remainder
+unsigned char *writeLength(unsigned char *out, std::size_t length) {
+    for (; length >= 255; length -= 255) {
+        *out++ = 255;
+    }
+    *out++ = static_cast<unsigned char>(length);
+    return out;
+}
+
+bool readLength(const unsigned char *input, std::size_t inputSize, std::size_t &position, std::size_t &length) {
+    while (true) {
+        if (position >= inputSize) {
+            return false;
+        }
+        const unsigned char byte = input[position++];
+        length += byte;
+        if (byte != 255) {
+            return true;
+        }
+    }
+}
+
+// One sequence: literals, then a match `offset` bytes back (length 0 for the block's final literals)
+unsigned char *writeSequence(unsigned char *out, const unsigned char *literals, std::size_t literalCount,
+                             std::size_t offset, std::size_t matchLength) {
+    unsigned char *token = out++;
+    *token = static_cast<unsigned char>(std::min<std::size_t>(literalCount, 15) << 4);
+    if (literalCount >= 15) {
+        out = writeLength(out, literalCount - 15);
+    }
+    std::memcpy(out, literals, literalCount);
+    out += literalCount;
+    if (matchLength == 0) {
+        return out;
+    }
+    *out++ = static_cast<unsigned char>(offset & 0xff);
+    *out++ = static_cast<unsigned char>(offset >> 8);
+    const std::size_t extra = matchLength - MIN_MATCH;
+    *token |= static_cast<unsigned char>(std::min<std::size_t>(extra, 15));
+    if (extra >= 15) {
+        out = writeLength(out, extra - 15);
+    }
+    return out;
+}
+
+} // namespace
+
+std::size_t compressBound(std::size_t size) {
+    return size + size / 255 + 16;
+}
+
+std::size_t compressBlock(const unsigned char *input, std::size_t size, unsigned char *output) {
+    unsigned char *out = output;
+    std::size_t anchor = 0;
+    if (size > MATCH_START_LIMIT) {
+        std::vector<std::uint32_t> table(std::size_t{1} << HASH_BITS, 0);
+        const std::size_t matchStartLimit = size - MATCH_START_LIMIT;
+        const std::size_t matchEndLimit = size - LAST_LITERALS;
+        std::size_t position = 0;
+        while (position < matchStartLimit) {
+            const std::uint32_t sequence = read32(input + position);
+            std::uint32_t &slot = table[hashSequence(sequence)];
+            const std::size_t candidate = slot;
+            slot = static_cast<std::uint32_t>(position);
+            if (candidate >= position || position - candidate > MAX_OFFSET || read32(input + candidate) != sequence) {
+                position++;
+                continue;
+            }
+            std::size_t length = MIN_MATCH;
+            while (position + length < matchEndLimit && input[candidate + length] == input[position + length]) {
+                length++;
+            }
+            out = writeSequence(out, input + anchor, position - anchor, position - candidate, length);
+            position += length;
+            anchor = position;
+        }
+    }
+    out = writeSequence(out, input + anchor, size - anchor, 0, 0);
+    return static_cast<std::size_t>(out - output);
+}
+
+int decompressBlock(const unsigned char *input, std::size_t inputSize, unsigned char *output, std::size_t outputSize) {
+    std::size_t in = 0, out = 0;
+    while (true) {
+        if (in >= inputSize) {
+            return -1;
+        }
+        const unsigned char token = input[in++];
+        std::size_t literalCount = token >> 4;
+        if (literalCount == 15 && !readLength(input, inputSize, in, literalCount)) {
+            return -1;
+        }
+        if (literalCount > inputSize - in || literalCount > outputSize - out) {
+            return -1;
+        }
+        std::memcpy(output + out, input + in, literalCount);
+        in += literalCount;
+        out += literalCount;
+        if (in == inputSize) {
+            break; // the last sequence has no match
+        }
+
+        if (inputSize - in < 2) {
+            return -1;
+        }
+        const std::size_t offset = input[in] | static_cast<std::size_t>(input[in + 1]) << 8;
+        in += 2;
+        std::size_t matchLength = (token & 15u) + MIN_MATCH;
+        if ((token & 15u) == 15 && !readLength(input, inputSize, in, matchLength)) {
+            return -1;
+        }
+        if (offset == 0 || offset > out || matchLength > outputSize - out) {
+            return -1;
+        }
+        // Matches may overlap their own output (offset < length repeats a pattern), copy forwards byte by byte
+        const unsigned char *match = output + out - offset;
+        for (std::size_t i = 0; i < matchLength; i++) {
+            output[out + i] = match[i];
+        }
+        out += matchLength;
+    }
+    return out == outputSize ? 0 : -1;
+}
+
+std::uint64_t assetPathHash(std::string_view path) {
+    // FNV-1a
+    std::uint64_t hash = 14695981039346656037ull;
+    for (const char c : path) {
+        hash = (hash ^ static_cast<unsigned char>(c)) * 1099511628211ull;
+    }
+    return hash;
+}
+
+int writeAssetPack(std::string_view packPath, const std::vector<AssetSource> &assets, bool compress) {
+    // Table of contents in hash order, ties broken by path so lookups can scan the equal range
+    std::vector<std::size_t> order(assets.size());
+    std::iota(order.begin(), order.end(), std::size_t{0});
+    std::vector<std::uint64_t> hashes(assets.size());
+    for (std::size_t i = 0; i < assets.size(); i++) {
+        hashes[i] = assetPathHash(assets[i].path);
+    }
+    std::ranges::sort(order, [&](std::size_t a, std::size_t b) {
+        return hashes[a] != hashes[b] ? hashes[a] < hashes[b] : assets[a].path < assets[b].path;
+    });
+
+    AssetPackHeader header{};
+    std::memcpy(header.magic, ASSET_PACK_MAGIC, sizeof(header.magic));
+    header.version = ASSET_PACK_VERSION;
+    header.entryCount = static_cast<std::uint32_t>(assets.size());
+    header.entriesOffset = sizeof(AssetPackHeader);
+    header.pathsOffset = header.entriesOffset + assets.size() * sizeof(AssetPackEntry);
+
+    std::vector<AssetPackEntry> entries(assets.size());
+    std::string paths;
+    std::vector<std::vector<unsigned char>> stored(assets.size());
+    for (std::size_t i = 0; i < assets.size(); i++) {
+        const AssetSource &asset = assets[order[i]];
+        if (i > 0 && asset.path == assets[order[i - 1]].path) {
+            std::cerr << "Asset " << asset.path << " is packed twice" << std::endl;
+            return -1;
+        }
+        AssetPackEntry &entry = entries[i];
+        entry.pathHash = hashes[order[i]];
+        entry.pathOffset = static_cast<std::uint32_t>(paths.size());
+        entry.pathLength = static_cast<std::uint32_t>(asset.path.size());
+        paths += asset.path;
+        entry.size = asset.data.size();
+        entry.compression = AssetCompression::NONE;
+        if (compress && !asset.data.empty()) {
+            std::vector<unsigned char> compressed(compressBound(asset.data.size()));
+            compressed.resize(compressBlock(asset.data.data(), asset.data.size(), compressed.data()));
+            if (compressed.size() <= asset.data.size() - asset.data.size() / 8) {
+                entry.compression = AssetCompression::LZ4;
+                stored[i] = std::move(compressed);
+            }
+        }
+        entry.storedSize = entry.compression == AssetCompression::NONE ? asset.data.size() : stored[i].size();
+    }
+    header.pathsSize = static_cast<std::uint32_t>(paths.size());
+
+    std::uint64_t offset = header.pathsOffset + paths.size();
+    for (AssetPackEntry &entry : entries) {
+        offset = alignUp(offset, ASSET_PACK_ALIGNMENT);
+        entry.offset = offset;
+        offset += entry.storedSize;
+    }
+
+    // Write to a temporary file and rename so a crash never leaves a half written pack behind
+    const std::string packFile{packPath};
+    const std::string temporaryFile = packFile + ".tmp";
+    {
+        std::ofstream file(temporaryFile, std::ios::binary | std::ios::trunc);
+        if (!file) {
+            std::cerr << "Failed to create asset pack " << temporaryFile << std::endl;
+            return -1;
+        }
+        file.write(reinterpret_cast<const char *>(&header), sizeof(header));
+        file.write(reinterpret_cast<const char *>(entries.data()),
+                   static_cast<std::streamsize>(entries.size() * sizeof(AssetPackEntry)));
+        file.write(paths.data(), static_cast<std::streamsize>(paths.size()));
+        std::uint64_t written = header.pathsOffset + paths.size();
+        const std::vector<char> zeros(ASSET_PACK_ALIGNMENT, 0);
+        for (std::size_t i = 0; i < entries.size(); i++) {
+            file.write(zeros.data(), static_cast<std::streamsize>(entries[i].offset - written));
+            const std::vector<unsigned char> &data = entries[i].compression == AssetCompression::NONE
+                    ? assets[order[i]].data : stored[i];
+            file.write(reinterpret_cast<const char *>(data.data()), static_cast<std::streamsize>(data.size()));
+            written = entries[i].offset + data.size();
+        }
+        if (!file) {
+            std::cerr << "Failed to write asset pack " << temporaryFile << std::endl;
+            return -1;
+        }
+    }
+    std::error_code error;
+    std::filesystem::rename(temporaryFile, packFile, error);
+    if (error) {
+        std::cerr << "Failed to move asset pack into place: " << error.message() << std::endl;
+        return -1;
+    }
+    return 0;
+}
+
+int openAssetPack(std::string_view packPath, AssetPack &pack) {
+    pack = AssetPack{};
+    if (pack.file.open(packPath) != 0 || pack.file.size() < sizeof(AssetPackHeader)) {
+        return -1;
+    }
+
+    AssetPackHeader header;
+    std::memcpy(&header, pack.file.data(), sizeof(header));
+    if (std::memcmp(header.magic, ASSET_PACK_MAGIC, sizeof(header.magic)) != 0 ||
+        header.version != ASSET_PACK_VERSION) {
+        std::cerr << packPath << " is not an asset pack of version " << ASSET_PACK_VERSION << std::endl;
+        pack.file.close();
+        return -1;
+    }
+    const std::uint64_t fileSize = pack.file.size();
+    if (header.entriesOffset % alignof(AssetPackEntry) != 0 ||
+        header.entriesOffset + std::uint64_t{header.entryCount} * sizeof(AssetPackEntry) > fileSize ||
+        header.pathsOffset + header.pathsSize > fileSize) {
+        std::cerr << "Asset pack " << packPath << " is truncated" << std::endl;
+        pack.file.close();
+        return -1;
+    }
+
+    pack.entries = reinterpret_cast<const AssetPackEntry *>(pack.file.data() + header.entriesOffset);
+    pack.entryCount = header.entryCount;
+    pack.paths = reinterpret_cast<const char *>(pack.file.data() + header.pathsOffset);
+    for (std::uint32_t i = 0; i < pack.entryCount; i++) {
+        const AssetPackEntry &entry = pack.entries[i];
+        if (std::uint64_t{entry.pathOffset} + entry.pathLength > header.pathsSize ||
+            entry.offset > fileSize || entry.storedSize > fileSize - entry.offset ||
+            (entry.compression == AssetCompression::NONE && entry.storedSize != entry.size)) {
+            std::cerr << "Asset pack " << packPath << " has a corrupt entry" << std::endl;
+            pack = AssetPack{};
+            return -1;
+        }
+    }
+    return 0;
+}
+
+const AssetPackEntry *findAsset(const AssetPack &pack, std::string_view path) {
+    const std::uint64_t hash = assetPathHash(path);
+    const AssetPackEntry *end = pack.entries + pack.entryCount;
+    const AssetPackEntry *entry = std::lower_bound(pack.entries, end, hash,
+            [](const AssetPackEntry &e, std::uint64_t value) { return e.pathHash < value; });
+    for (; entry != end && entry->pathHash == hash; ++entry) {
+        if (assetPath(pack, *entry) == path) {
+            return entry;
+        }
+    }
+    return nullptr;
+}
+
+std::string_view assetPath(const AssetPack &pack, const AssetPackEntry &entry) {
+    return {pack.paths + entry.pathOffset, entry.pathLength};
+}
+
+const unsigned char *assetData(const AssetPack &pack, const AssetPackEntry &entry) {
+    return entry.compression == AssetCompression::NONE ? pack.file.data() + entry.offset : nullptr;
+}
+
+int readAsset(const AssetPack &pack, const AssetPackEntry &entry, unsigned char *out) {
+    const unsigned char *stored = pack.file.data() + entry.offset;
+    switch (entry.compression) {
+        case AssetCompression::NONE:
+            std::memcpy(out, stored, entry.size);
+            return 0;
+        case AssetCompression::LZ4:
+            if (decompressBlock(stored, entry.storedSize, out, entry.size) != 0) {
+                std::cerr << "Asset " << assetPath(pack, entry) << " does not decompress" << std::endl;
+                return -1;
+            }
+            return 0;
+    }
+    std::cerr << "Asset " << assetPath(pack, entry) << " uses an unknown compression" << std::endl;
+    return -1;
+}
@@ -0,0 +1,362 @@
+#include <bvh.h>
+
+#include <algorithm>
+#include <span>
+
+namespace {
+
+constexpr int SAH_BINS = 12;
+
+bool isLeaf(const BvhNode &node) {
+    return node.children[0] == NULL_NODE;
+}
+
+std::uint32_t allocateNode(Bvh &bvh) {
+    if (!bvh.freeNodes.empty()) {
+        const std::uint32_t node = bvh.freeNodes.back();
+        bvh.freeNodes.pop_back();
+        return node;
+    }
+    bvh.nodes.push_back({});
+    return static_cast<std::uint32_t>(bvh.nodes.size() - 1);
+}
+
+void freeNode(Bvh &bvh, std::uint32_t node) {
+    bvh.nodes[node].parent = NULL_NODE;
+    bvh.freeNodes.push_back(node);
+}
+
+void refitAncestors(Bvh &bvh, std::uint32_t node) {
+    while (node != NULL_NODE) {
+        BvhNode &current = bvh.nodes[node];
+        current.bounds = mergeAabb(bvh.nodes[current.children[0]].bounds, bvh.nodes[current.children[1]].bounds);
+        node = current.parent;
+    }
+}
+
+// Walks down from the root towards the child whose enlargement costs less, stopping where pairing with the
+// current node beats both (the Box2D descent, with SAH costs)
+std::uint32_t findSibling(const Bvh &bvh, const Aabb &box) {
+    std::uint32_t node = bvh.root;
+    while (!isLeaf(bvh.nodes[node])) {
+        const BvhNode &current = bvh.nodes[node];
+        const float area = surfaceArea(current.bounds);
+        const float combinedArea = surfaceArea(mergeAabb(current.bounds, box));
+        // Pairing here creates a parent over both; descending pushes the enlargement onto this node
+        const float pairCost = 2.0f * combinedArea;
+        const float inheritedCost = 2.0f * (combinedArea - area);
+
+        float childCosts[2];
+        for (int c = 0; c < 2; c++) {
+            const BvhNode &child = bvh.nodes[current.children[c]];
+            const float merged = surfaceArea(mergeAabb(child.bounds, box));
+            childCosts[c] = (isLeaf(child) ? merged : merged - surfaceArea(child.bounds)) + inheritedCost;
+        }
+        if (pairCost < childCosts[0] && pairCost < childCosts[1]) {
+            break;
+        }
+        node = current.children[childCosts[1] < childCosts[0]];
+    }
+    return node;
+}
+
+void attachLeaf(Bvh &bvh, std::uint32_t leaf) {
+    if (bvh.root == NULL_NODE) {
+        bvh.root = leaf;
+        bvh.nodes[leaf].parent = NULL_NODE;
+        return;
+    }
+    const Aabb box = bvh.nodes[leaf].bounds;
+    const std::uint32_t sibling = findSibling(bvh, box);
+    const std::uint32_t oldParent = bvh.nodes[sibling].parent;
+    const std::uint32_t parent = allocateNode(bvh); // may grow nodes, no references held across it
+
+    bvh.nodes[parent] = {mergeAabb(bvh.nodes[sibling].bounds, box), oldParent, {sibling, leaf}, 0};
+    bvh.nodes[sibling].parent = parent;
+    bvh.nodes[leaf].parent = parent;
+    if (oldParent == NULL_NODE) {
+        bvh.root = parent;
+    } else {
+        BvhNode &grandParent = bvh.nodes[oldParent];
+        grandParent.children[grandParent.children[1] == sibling] = parent;
+        refitAncestors(bvh, oldParent);
+    }
+}
+
+// Unlinks the leaf and frees its parent, the leaf node itself is kept
+void detachLeaf(Bvh &bvh, std::uint32_t leaf) {
+    if (leaf == bvh.root) {
+        bvh.root = NULL_NODE;
+        return;
+    }
+    const std::uint32_t parent = bvh.nodes[leaf].parent;
+    const std::uint32_t grandParent = bvh.nodes[parent].parent;
+    const BvhNode &parentNode = bvh.nodes[parent];
+    const std::uint32_t sibling = parentNode.children[parentNode.children[0] == leaf];
+
+    bvh.nodes[sibling].parent = grandParent;
+    if (grandParent == NULL_NODE) {
+        bvh.root = sibling;
+    } else {
+        BvhNode &grandParentNode = bvh.nodes[grandParent];
+        grandParentNode.children[grandParentNode.children[1] == parent] = sibling;
+        refitAncestors(bvh, grandParent);
+    }
+    freeNode(bvh, parent);
+}
+
+Aabb fatten(const Aabb &box, float margin) {
+    const vec3 grow{margin, margin, margin};
+    return {box.min - grow, box.max + grow};
+}
+
+vec3 centroid(const Aabb &box) {
+    return (box.min + box.max) * 0.5f;
+}
+
+float axisValue(vec3 v, int axis) {
+    return axis == 0 ? v.x : axis == 1 ? v.y : v.z;
+}
+
+std::uint32_t buildSubtree(Bvh &bvh, std::span<std::uint32_t> leaves, std::uint32_t parent) {
+    if (leaves.size() == 1) {
+        bvh.nodes[leaves[0]].parent = parent;
+        return leaves[0];
+    }
+
+    Aabb bounds = bvh.nodes[leaves[0]].bounds;
+    Aabb centroids{centroid(bounds), centroid(bounds)};
+    for (std::uint32_t leaf : leaves) {
+        const vec3 c = centroid(bvh.nodes[leaf].bounds);
+        bounds = mergeAabb(bounds, bvh.nodes[leaf].bounds);
+        centroids = mergeAabb(centroids, {c, c});
+    }
+    const vec3 spread = centroids.max - centroids.min;
+    const int axis = spread.x >= spread.y && spread.x >= spread.z ? 0 : spread.y >= spread.z ? 1 : 2;
+    const float low = axisValue(centroids.min, axis);
+    const float extent = axisValue(spread, axis);
+
+    std::size_t split = leaves.size() / 2;
+    if (extent > 0.0f) {
+        // Bin the centroids along the widest axis and take the cheapest of the SAH_BINS - 1 bin boundaries
+        struct Bin {
+            Aabb bounds;
+            std::size_t count = 0;
+        } bins[SAH_BINS];
+        auto binOf = [&](std::uint32_t leaf) {
+            const float t = (axisValue(centroid(bvh.nodes[leaf].bounds), axis) - low) / extent;
+            return std::min(static_cast<int>(t * SAH_BINS), SAH_BINS - 1);
+        };
+        for (std::uint32_t leaf : leaves) {
+            Bin &bin = bins[binOf(leaf)];
+            bin.bounds = bin.count ? mergeAabb(bin.bounds, bvh.nodes[leaf].bounds) : bvh.nodes[leaf].bounds;
+            bin.count++;
+        }
+
+        float rightCosts[SAH_BINS] = {};
+        Aabb accumulated{};
+        std::size_t accumulatedCount = 0;
+        for (int b = SAH_BINS - 1; b > 0; b--) {
+            if (bins[b].count) {
+                accumulated = accumulatedCount ? mergeAabb(accumulated, bins[b].bounds) : bins[b].bounds;
+                accumulatedCount += bins[b].count;
+            }
+            rightCosts[b] = accumulatedCount ? surfaceArea(accumulated) * static_cast<float>(accumulatedCount) : 0.0f;
+        }
+
+        float bestCost = 0.0f;
+        int bestBin = -1;
+        accumulatedCount = 0;
+        for (int b = 0; b < SAH_BINS - 1; b++) {
+            if (bins[b].count) {
+                accumulated = accumulatedCount ? mergeAabb(accumulated, bins[b].bounds) : bins[b].bounds;
+                accumulatedCount += bins[b].count;
+            }
+            if (accumulatedCount == 0 || accumulatedCount == leaves.size()) {
+                continue;
+            }
+            const float cost = surfaceArea(accumulated) * static_cast<float>(accumulatedCount) + rightCosts[b + 1];
+            if (bestBin < 0 || cost < bestCost) {
+                bestCost = cost;
+                bestBin = b;
+            }
+        }
+        if (bestBin >= 0) {
+            const auto middle = std::partition(leaves.begin(), leaves.end(),
+                                               [&](std::uint32_t leaf) { return binOf(leaf) <= bestBin; });
+            split = static_cast<std::size_t>(middle - leaves.begin());
+        }
+    }
+    if (split == 0 || split == leaves.size() || extent <= 0.0f) {
+        // Every centroid in one bin: fall back to a median split so the recursion always makes progress
+        split = leaves.size() / 2;
+        std::nth_element(leaves.begin(), leaves.begin() + static_cast<std::ptrdiff_t>(split), leaves.end(),
+                         [&](std::uint32_t a, std::uint32_t b) {
+            return axisValue(centroid(bvh.nodes[a].bounds), axis) < axisValue(centroid(bvh.nodes[b].bounds), axis);
+        });
+    }
+
+    const std::uint32_t node = allocateNode(bvh);
+    const std::uint32_t left = buildSubtree(bvh, leaves.first(split), node);
+    const std::uint32_t right = buildSubtree(bvh, leaves.subspan(split), node);
+    bvh.nodes[node] = {bounds, parent, {left, right}, 0};
+    return node;
+}
+
+} // namespace
+
+std::uint32_t insertBvhLeaf(Bvh &bvh, const Aabb &box, std::uint32_t object) {
+    const std::uint32_t leaf = allocateNode(bvh);
+    bvh.nodes[leaf] = {fatten(box, bvh.margin), NULL_NODE, {NULL_NODE, NULL_NODE}, object};
+    attachLeaf(bvh, leaf);
+    bvh.leafCount++;
+    return leaf;
+}
+
+void removeBvhLeaf(Bvh &bvh, std::uint32_t leaf) {
+    detachLeaf(bvh, leaf);
+    freeNode(bvh, leaf);
+    bvh.leafCount--;
+}
+
+bool moveBvhLeaf(Bvh &bvh, std::uint32_t leaf, const Aabb &box) {
+    if (containsAabb(bvh.nodes[leaf].bounds, box)) {
+        return false;
+    }
+    detachLeaf(bvh, leaf);
+    bvh.nodes[leaf].bounds = fatten(box, bvh.margin);
+    attachLeaf(bvh, leaf);
+    return true;
+}
+
+void refitBvh(Bvh &bvh) {
+    if (bvh.root == NULL_NODE) {
+        return;
+    }
+    // Post-order through an explicit stack: a node is refit once both children are
+    std::vector<std::uint32_t> &stack = bvh.pending;
+    std::vector<std::uint32_t> &order = bvh.inside;
+    stack.assign(1, bvh.root);
+    order.clear();
+    while (!stack.empty()) {
+        const std::uint32_t node = stack.back();
+        stack.pop_back();
+        if (!isLeaf(bvh.nodes[node])) {
+            order.push_back(node);
+            stack.push_back(bvh.nodes[node].children[0]);
+            stack.push_back(bvh.nodes[node].children[1]);
+        }
+    }
+    for (auto node = order.rbegin(); node != order.rend(); ++node) {
+        BvhNode &current = bvh.nodes[*node];
+        current.bounds = mergeAabb(bvh.nodes[current.children[0]].bounds, bvh.nodes[current.children[1]].bounds);
+    }
+}
+
+void rebuildBvh(Bvh &bvh) {
+    if (bvh.root == NULL_NODE) {
+        return;
+    }
+    // Collect the leaves and free every internal node, the leaves keep their ids
+    std::vector<std::uint32_t> leaves;
+    leaves.reserve(bvh.leafCount);
+    std::vector<std::uint32_t> &stack = bvh.pending;
+    stack.assign(1, bvh.root);
+    while (!stack.empty()) {
+        const std::uint32_t node = stack.back();
+        stack.pop_back();
+        if (isLeaf(bvh.nodes[node])) {
+            leaves.push_back(node);
+        } else {
+            stack.push_back(bvh.nodes[node].children[0]);
+            stack.push_back(bvh.nodes[node].children[1]);
+            freeNode(bvh, node);
+        }
+    }
+    bvh.root = buildSubtree(bvh, leaves, NULL_NODE);
+}
+
+float bvhCost(const Bvh &bvh) {
+    if (bvh.root == NULL_NODE || isLeaf(bvh.nodes[bvh.root])) {
+        return 0.0f;
+    }
+    float total = 0.0f;
+    std::vector<std::uint32_t> stack{bvh.root};
+    while (!stack.empty()) {
+        const BvhNode &node = bvh.nodes[stack.back()];
+        stack.pop_back();
+        if (!isLeaf(node)) {
+            total += surfaceArea(node.bounds);
+            stack.push_back(node.children[0]);
+            stack.push_back(node.children[1]);
+        }
+    }
+    const float rootArea = surfaceArea(bvh.nodes[bvh.root].bounds);
+    return rootArea > 0.0f ? total / rootArea : 0.0f;
+}
+
+void queryBvh(Bvh &bvh, const Frustum &frustum, std::vector<std::uint32_t> &objects, BvhQueryStats *stats) {
+    objects.clear();
+    BvhQueryStats queryStats;
+    if (bvh.root != NULL_NODE) {
+        bvh.pending.assign(1, bvh.root);
+    } else {
+        bvh.pending.clear();
+    }
+
+    constexpr int PACKET = floatN::WIDTH;
+    alignas(32) float lanes[6][PACKET];
+    std::uint32_t packet[PACKET];
+    Containment results[PACKET];
+
+    while (!bvh.pending.empty()) {
+        // Pop up to a packet of nodes and test them together
+        const std::size_t count = std::min<std::size_t>(PACKET, bvh.pending.size());
+        for (std::size_t i = 0; i < count; i++) {
+            packet[i] = bvh.pending.back();
+            bvh.pending.pop_back();
+            const Aabb &box = bvh.nodes[packet[i]].bounds;
+            const vec3 center = centroid(box);
+            const vec3 extent = (box.max - box.min) * 0.5f;
+            lanes[0][i] = center.x;
+            lanes[1][i] = center.y;
+            lanes[2][i] = center.z;
+            lanes[3][i] = extent.x;
+            lanes[4][i] = extent.y;
+            lanes[5][i] = extent.z;
+        }
+        classifyBoxes(frustum, {lanes[0], lanes[1], lanes[2], lanes[3], lanes[4], lanes[5]}, results, count);
+        queryStats.nodesTested += count;
+
+        for (std::size_t i = 0; i < count; i++) {
+            const BvhNode &node = bvh.nodes[packet[i]];
+            if (results[i] == Containment::OUTSIDE) {
+                continue;
+            }
+            if (isLeaf(node)) {
+                objects.push_back(node.object);
+            } else if (results[i] == Containment::INSIDE) {
+                // The whole subtree is visible, collect its leaves without any more tests
+                bvh.inside.assign(1, packet[i]);
+                while (!bvh.inside.empty()) {
+                    const BvhNode &current = bvh.nodes[bvh.inside.back()];
+                    bvh.inside.pop_back();
+                    if (isLeaf(current)) {
+                        objects.push_back(current.object);
+                    } else {
+                        bvh.inside.push_back(current.children[0]);
+                        bvh.inside.push_back(current.children[1]);
+                    }
+                }
+            } else {
+                bvh.pending.push_back(node.children[0]);
+                bvh.pending.push_back(node.children[1]);
+            }
+        }
+    }
+
+    queryStats.visibleObjects = objects.size();
+    if (stats) {
+        *stats = queryStats;
+    }
+}
@@ -0,0 +1,242 @@
+#include <clustered_lighting.h>
+
+#include <job_system.h>
+#include <simd.h>
+
+#include <GLEW/glew.h>
+
+#include <algorithm>
+#include <bit>
+#include <chrono>
+#include <cmath>
+#include <cstring>
+
+namespace {
+
+// Padding lanes: a light with no radius far away touches no cluster
+constexpr float NO_LIGHT = 1e30f;
+
+bool sameMatrix(const mat4 &a, const mat4 &b) {
+    return std::memcmp(&a, &b, sizeof(mat4)) == 0;
+}
+
+float sliceDepth(const ClusteredLighting &clusters, std::uint32_t slice) {
+    return clusters.nearDepth * std::pow(clusters.farDepth / clusters.nearDepth,
+                                         static_cast<float>(slice) / static_cast<float>(CLUSTER_SLICES));
+}
+
+// Each froxel's box: the rays through its tile's corners, cut by the planes at its slice's two depths. The rays
+// go through the unprojected near and far points, which works for perspective and orthographic projections.
+void buildBounds(ClusteredLighting &clusters) {
+    const mat4 inverseProjection = inverse(clusters.projection);
+    auto unproject = [&](float x, float y, float z) {
+        const vec4 p = inverseProjection * vec4{x, y, z, 1.0f};
+        return vec3{p.x / p.w, p.y / p.w, p.z / p.w};
+    };
+
+    clusters.bounds.resize(CLUSTER_COUNT);
+    for (std::uint32_t slice = 0; slice < CLUSTER_SLICES; slice++) {
+        const float depths[2] = {sliceDepth(clusters, slice), sliceDepth(clusters, slice + 1)};
+        for (std::uint32_t tileY = 0; tileY < CLUSTER_TILES_Y; tileY++) {
+            for (std::uint32_t tileX = 0; tileX < CLUSTER_TILES_X; tileX++) {
+                ClusterBounds box{NO_LIGHT, NO_LIGHT, NO_LIGHT, -NO_LIGHT, -NO_LIGHT, -NO_LIGHT};
+                for (std::uint32_t corner = 0; corner < 4; corner++) {
+                    const float x = -1.0f + 2.0f * static_cast<float>(tileX + (corner & 1)) / CLUSTER_TILES_X;
+                    const float y = -1.0f + 2.0f * static_cast<float>(tileY + (corner >> 1)) / CLUSTER_TILES_Y;
+                    const vec3 nearPoint = unproject(x, y, -1.0f);
+                    const vec3 farPoint = unproject(x, y, 1.0f);
+                    for (const float depth : depths) {
+                        const float t = (-depth - nearPoint.z) / (farPoint.z - nearPoint.z);
+                        const vec3 p = lerp(nearPoint, farPoint, t);
+                        box = {std::min(box.minX, p.x), std::min(box.minY, p.y), std::min(box.minZ, p.z),
+                               std::max(box.maxX, p.x), std::max(box.maxY, p.y), std::max(box.maxZ, p.z)};
+                    }
+                }
+                clusters.bounds[(slice * CLUSTER_TILES_Y + tileY) * CLUSTER_TILES_X + tileX] = box;
+            }
+        }
+    }
+}
+
+// Lights whose depth range reaches the slice, in lane-padded structure of arrays
+void gatherSliceLights(const ClusteredLighting &clusters, std::uint32_t slice, ClusterSlice &gathered) {
+    const float sliceNear = sliceDepth(clusters, slice);
+    const float sliceFar = sliceDepth(clusters, slice + 1);
+    gathered.x.clear();
+    gathered.y.clear();
+    gathered.z.clear();
+    gathered.radius.clear();
+    gathered.lights.clear();
+    for (std::size_t light = 0; light < clusters.lightX.size(); light++) {
+        const float depth = -clusters.lightZ[light];
+        const float radius = clusters.lightRadius[light];
+        if (depth + radius >= sliceNear && depth - radius <= sliceFar) {
+            gathered.x.push_back(clusters.lightX[light]);
+            gathered.y.push_back(clusters.lightY[light]);
+            gathered.z.push_back(clusters.lightZ[light]);
+            gathered.radius.push_back(radius);
+            gathered.lights.push_back(static_cast<std::uint16_t>(light));
+        }
+    }
+    while (gathered.x.size() % floatN::WIDTH != 0) {
+        gathered.x.push_back(NO_LIGHT);
+        gathered.y.push_back(NO_LIGHT);
+        gathered.z.push_back(NO_LIGHT);
+        gathered.radius.push_back(0.0f);
+    }
+}
+
+// Squared distance from each sphere's center to the box against its squared radius, WIDTH lights at a time
+template<typename T>
+void assignSliceKernel(const ClusterBounds *tiles, ClusterSlice &slice, std::uint32_t *counts) {
+    const T zero = T::splat(0.0f);
+    slice.indices.clear();
+    for (std::uint32_t tile = 0; tile < CLUSTER_TILES_X * CLUSTER_TILES_Y; tile++) {
+        const ClusterBounds &box = tiles[tile];
+        const T minX = T::splat(box.minX), minY = T::splat(box.minY), minZ = T::splat(box.minZ);
+        const T maxX = T::splat(box.maxX), maxY = T::splat(box.maxY), maxZ = T::splat(box.maxZ);
+        const std::size_t first = slice.indices.size();
+        for (std::size_t i = 0; i < slice.x.size(); i += T::WIDTH) {
+            const T x = T::load(&slice.x[i]), y = T::load(&slice.y[i]), z = T::load(&slice.z[i]);
+            const T radius = T::load(&slice.radius[i]);
+            const T dx = maximum(maximum(minX - x, x - maxX), zero);
+            const T dy = maximum(maximum(minY - y, y - maxY), zero);
+            const T dz = maximum(maximum(minZ - z, z - maxZ), zero);
+            const T distanceSquared = madd(dx, dx, madd(dy, dy, dz * dz));
+            for (int hits = maskBits(greaterThan(radius * radius, distanceSquared)); hits; hits &= hits - 1) {
+                slice.indices.push_back(slice.lights[i + static_cast<std::size_t>(std::countr_zero(
+                        static_cast<unsigned int>(hits)))]);
+            }
+        }
+        counts[tile] = static_cast<std::uint32_t>(slice.indices.size() - first);
+    }
+}
+
+void uploadTextureBuffer(unsigned int buffer, const void *data, std::size_t size) {
+    glBindBuffer(GL_TEXTURE_BUFFER, buffer);
+    // Orphaned every frame, the driver hands out fresh storage while the GPU still reads the last one
+    glBufferData(GL_TEXTURE_BUFFER, static_cast<GLsizeiptr>(std::max<std::size_t>(size, 16)), nullptr,
+                 GL_STREAM_DRAW);
+    if (size) {
+        glBufferSubData(GL_TEXTURE_BUFFER, 0, static_cast<GLsizeiptr>(size), data);
+    }
+}
+
+} // namespace
+
+void initClusteredLighting(ClusteredLighting &clusters) {
+    glGenBuffers(3, clusters.buffers);
+    glGenTextures(3, clusters.textures);
+    const GLenum formats[3] = {GL_RGBA32F, GL_RG32UI, GL_R16UI};
+    for (int i = 0; i < 3; i++) {
+        uploadTextureBuffer(clusters.buffers[i], nullptr, 0);
+        glBindTexture(GL_TEXTURE_BUFFER, clusters.textures[i]);
+        glTexBuffer(GL_TEXTURE_BUFFER, formats[i], clusters.buffers[i]);
+    }
+    glBindTexture(GL_TEXTURE_BUFFER, 0);
+    glBindBuffer(GL_TEXTURE_BUFFER, 0);
+}
+
+void destroyClusteredLighting(ClusteredLighting &clusters) {
+    glDeleteTextures(3, clusters.textures);
+    glDeleteBuffers(3, clusters.buffers);
+    std::fill_n(clusters.textures, 3, 0u);
+    std::fill_n(clusters.buffers, 3, 0u);
+}
+
+void assignClusters(ClusteredLighting &clusters, std::span<const PointLight> lights, const mat4 &view,
+                    const mat4 &projection, float nearDepth, float farDepth, int renderWidth, int renderHeight) {
+    const auto start = std::chrono::steady_clock::now();
+    if (clusters.bounds.empty() || !sameMatrix(projection, clusters.projection) ||
+        nearDepth != clusters.nearDepth || farDepth != clusters.farDepth) {
+        clusters.projection = projection;
+        clusters.nearDepth = nearDepth;
+        clusters.farDepth = farDepth;
+        buildBounds(clusters);
+    }
+
+    const std::size_t count = std::min(lights.size(), MAX_POINT_LIGHTS);
+    clusters.lightX.resize(count);
+    clusters.lightY.resize(count);
+    clusters.lightZ.resize(count);
+    clusters.lightRadius.resize(count);
+    clusters.lightData.resize(count * 8);
+    for (std::size_t i = 0; i < count; i++) {
+        const PointLight &light = lights[i];
+        clusters.lightX[i] = light.position.x;
+        clusters.lightY[i] = light.position.y;
+        clusters.lightZ[i] = light.position.z;
+        clusters.lightRadius[i] = light.radius;
+        const float texels[8] = {light.position.x, light.position.y, light.position.z, light.radius,
+                                 light.color.x, light.color.y, light.color.z, 0.0f};
+        std::copy_n(texels, 8, &clusters.lightData[i * 8]);
+    }
+    transformPointsSoA(view, clusters.lightX.data(), clusters.lightY.data(), clusters.lightZ.data(),
+                       clusters.lightX.data(), clusters.lightY.data(), clusters.lightZ.data(), count);
+
+    constexpr std::uint32_t TILES = CLUSTER_TILES_X * CLUSTER_TILES_Y;
+    parallelFor(CLUSTER_SLICES, 1, [&](std::size_t begin, std::size_t end) {
+        for (std::size_t slice = begin; slice < end; slice++) {
+            gatherSliceLights(clusters, static_cast<std::uint32_t>(slice), clusters.slices[slice]);
+            assignSliceKernel<floatN>(&clusters.bounds[slice * TILES], clusters.slices[slice],
+                                      &clusters.clusterCounts[slice * TILES]);
+        }
+    });
+
+    // Slices are stored one after the other, so a cluster's offset is a running sum of the counts
+    clusters.ranges.resize(CLUSTER_COUNT * 2);
+    clusters.indices.clear();
+    clusters.stats.maxClusterLights = 0;
+    std::uint32_t offset = 0;
+    for (std::uint32_t cluster = 0; cluster < CLUSTER_COUNT; cluster++) {
+        clusters.ranges[cluster * 2] = offset;
+        clusters.ranges[cluster * 2 + 1] = clusters.clusterCounts[cluster];
+        offset += clusters.clusterCounts[cluster];
+        clusters.stats.maxClusterLights = std::max<std::size_t>(clusters.stats.maxClusterLights,
+                                                                clusters.clusterCounts[cluster]);
+    }
+    for (const ClusterSlice &slice : clusters.slices) {
+        clusters.indices.insert(clusters.indices.end(), slice.indices.begin(), slice.indices.end());
+    }
+
+    const float logRatio = std::log(farDepth / nearDepth);
+    clusters.block.view = view;
+    clusters.block.grid = {static_cast<float>(CLUSTER_TILES_X), static_cast<float>(CLUSTER_TILES_Y),
+                           static_cast<float>(CLUSTER_SLICES), 0.0f};
+    clusters.block.scale = {static_cast<float>(CLUSTER_TILES_X) / static_cast<float>(std::max(renderWidth, 1)),
+                            static_cast<float>(CLUSTER_TILES_Y) / static_cast<float>(std::max(renderHeight, 1)),
+                            static_cast<float>(CLUSTER_SLICES) / logRatio,
+                            -static_cast<float>(CLUSTER_SLICES) * std::log(nearDepth) / logRatio};
+
+    clusters.stats.lights = count;
+    clusters.stats.indices = clusters.indices.size();
+    clusters.stats.buildMilliseconds = std::chrono::duration<double, std::milli>(
+            std::chrono::steady_clock::now() - start).count();
+}
+
+void buildClusters(ClusteredLighting &clusters, std::span<const PointLight> lights, const mat4 &view,
+                   const mat4 &projection, float nearDepth, float farDepth, int renderWidth, int renderHeight) {
+    assignClusters(clusters, lights, view, projection, nearDepth, farDepth, renderWidth, renderHeight);
+    uploadTextureBuffer(clusters.buffers[0], clusters.lightData.data(), clusters.lightData.size() * sizeof(float));
+    uploadTextureBuffer(clusters.buffers[1], clusters.ranges.data(), clusters.ranges.size() * sizeof(std::uint32_t));
+    uploadTextureBuffer(clusters.buffers[2], clusters.indices.data(),
+                        clusters.indices.size() * sizeof(std::uint16_t));
+    glBindBuffer(GL_TEXTURE_BUFFER, 0);
+}
+
+void bindClusters(const ClusteredLighting &clusters) {
+    const unsigned int units[3] = {CLUSTER_LIGHT_UNIT, CLUSTER_RANGE_UNIT, CLUSTER_INDEX_UNIT};
+    for (int i = 0; i < 3; i++) {
+        glActiveTexture(GL_TEXTURE0 + units[i]);
+        glBindTexture(GL_TEXTURE_BUFFER, clusters.textures[i]);
+    }
+    glActiveTexture(GL_TEXTURE0);
+}
+
+void setClusterSamplers(unsigned int program) {
+    glUseProgram(program);
+    glUniform1i(glGetUniformLocation(program, "pointLights"), CLUSTER_LIGHT_UNIT);
+    glUniform1i(glGetUniformLocation(program, "clusterRanges"), CLUSTER_RANGE_UNIT);
+    glUniform1i(glGetUniformLocation(program, "clusterLights"), CLUSTER_INDEX_UNIT);
+    glUseProgram(0);
+}
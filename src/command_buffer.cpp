@@ -0,0 +1,203 @@
+#include <command_buffer.h>
+#include <job_system.h>
+
+#include <algorithm>
+#include <cstring>
+#include <iostream>
+#include <new>
+
+namespace {
+
+struct ValueCommand {
+    CommandHeader header;
+    unsigned int value;
+};
+
+struct UniformCommand {
+    CommandHeader header;
+    DrawUniform uniform;
+};
+
+struct UniformBlockCommand {
+    CommandHeader header;
+    UniformBlockRange block;
+};
+
+// Followed by `count` DrawElementsIndirectCommand
+struct DrawCommand {
+    CommandHeader header;
+    RenderPass pass;
+    float depth;
+    std::uint32_t count;
+};
+
+template<typename T>
+T *appendCommand(CommandBuffer &buffer, CommandType type, std::size_t extraSize = 0) {
+    void *memory = linearAllocate(buffer.memory, sizeof(T) + extraSize, alignof(T));
+    T *command = new(memory) T{};
+    command->header.type = type;
+    if (buffer.last) {
+        buffer.last->next = &command->header;
+    } else {
+        buffer.first = &command->header;
+    }
+    buffer.last = &command->header;
+    buffer.commandCount++;
+    return command;
+}
+
+void recordValue(CommandBuffer &buffer, CommandType type, unsigned int value) {
+    appendCommand<ValueCommand>(buffer, type)->value = value;
+}
+
+} // namespace
+
+void *linearAllocate(LinearAllocator &allocator, std::size_t size, std::size_t alignment) {
+    while (allocator.block < allocator.blocks.size()) {
+        const auto base = reinterpret_cast<std::uintptr_t>(allocator.blocks[allocator.block].get());
+        const std::size_t aligned = ((base + allocator.offset + alignment - 1) & ~(alignment - 1)) - base;
+        if (aligned + size <= allocator.blockSizes[allocator.block]) {
+            allocator.offset = aligned + size;
+            return allocator.blocks[allocator.block].get() + aligned;
+        }
+        allocator.block++;
+        allocator.offset = 0;
+    }
+
+    // Out of blocks: add one, oversized if a single allocation needs it (new[] is aligned for any fundamental type)
+    const std::size_t blockSize = std::max(LinearAllocator::BLOCK_SIZE, size);
+    allocator.blocks.push_back(std::make_unique_for_overwrite<std::byte[]>(blockSize));
+    allocator.blockSizes.push_back(blockSize);
+    allocator.block = allocator.blocks.size() - 1;
+    allocator.offset = size;
+    return allocator.blocks.back().get();
+}
+
+void resetLinearAllocator(LinearAllocator &allocator) {
+    allocator.block = 0;
+    allocator.offset = 0;
+}
+
+void resetCommandBuffer(CommandBuffer &buffer) {
+    resetLinearAllocator(buffer.memory);
+    buffer.first = nullptr;
+    buffer.last = nullptr;
+    buffer.commandCount = 0;
+}
+
+void recordBindProgram(CommandBuffer &buffer, unsigned int program) {
+    recordValue(buffer, CommandType::BIND_PROGRAM, program);
+}
+
+void recordBindVertexArray(CommandBuffer &buffer, unsigned int vertexArray) {
+    recordValue(buffer, CommandType::BIND_VERTEX_ARRAY, vertexArray);
+}
+
+void recordBindTexture(CommandBuffer &buffer, unsigned int texture) {
+    recordValue(buffer, CommandType::BIND_TEXTURE, texture);
+}
+
+void recordSetMaterial(CommandBuffer &buffer, unsigned int material) {
+    recordValue(buffer, CommandType::SET_MATERIAL, material);
+}
+
+void recordSetUniform(CommandBuffer &buffer, const DrawUniform &uniform) {
+    appendCommand<UniformCommand>(buffer, CommandType::SET_UNIFORM)->uniform = uniform;
+}
+
+void recordBindUniformBlock(CommandBuffer &buffer, const UniformBlockRange &block) {
+    if (block.binding >= MAX_BLOCK_BINDINGS) {
+        std::cerr << "Uniform block binding " << block.binding << " is not below " << MAX_BLOCK_BINDINGS
+                  << ", bind dropped" << std::endl;
+        return;
+    }
+    appendCommand<UniformBlockCommand>(buffer, CommandType::BIND_UNIFORM_BLOCK)->block = block;
+}
+
+void recordDraw(CommandBuffer &buffer, RenderPass pass, float depth,
+                std::span<const DrawElementsIndirectCommand> drawCommands) {
+    if (drawCommands.empty()) {
+        return;
+    }
+    auto *command = appendCommand<DrawCommand>(buffer, CommandType::DRAW, drawCommands.size_bytes());
+    command->pass = pass;
+    command->depth = depth;
+    command->count = static_cast<std::uint32_t>(drawCommands.size());
+    std::memcpy(command + 1, drawCommands.data(), drawCommands.size_bytes());
+}
+
+void recordCommandsParallel(CommandRecorder &recorder, std::size_t count, std::size_t minPerThread,
+                            const std::function<void(CommandBuffer &, std::size_t, std::size_t)> &record) {
+    const std::size_t threadCount = std::clamp<std::size_t>(count / std::max<std::size_t>(minPerThread, 1), 1,
+                                                            jobWorkerCount());
+    if (recorder.buffers.size() < threadCount) {
+        recorder.buffers.resize(threadCount);
+    }
+    for (CommandBuffer &buffer : recorder.buffers) {
+        resetCommandBuffer(buffer);
+    }
+
+    runBatches(threadCount, [&](std::size_t t) {
+        record(recorder.buffers[t], count * t / threadCount, count * (t + 1) / threadCount);
+    });
+}
+
+void submitCommandBuffers(RenderQueue &queue, std::span<const CommandBuffer> buffers) {
+    std::vector<DrawUniform> uniforms;
+    std::vector<UniformBlockRange> blocks;
+    for (const CommandBuffer &buffer : buffers) {
+        unsigned int program = 0, vertexArray = 0, texture = 0, material = ~0u;
+        uniforms.clear();
+        blocks.clear();
+
+        for (const CommandHeader *header = buffer.first; header; header = header->next) {
+            switch (header->type) {
+                case CommandType::BIND_PROGRAM:
+                    program = reinterpret_cast<const ValueCommand *>(header)->value;
+                    uniforms.clear(); // uniform values belong to the program
+                    break;
+                case CommandType::BIND_VERTEX_ARRAY:
+                    vertexArray = reinterpret_cast<const ValueCommand *>(header)->value;
+                    break;
+                case CommandType::BIND_TEXTURE:
+                    texture = reinterpret_cast<const ValueCommand *>(header)->value;
+                    break;
+                case CommandType::SET_MATERIAL:
+                    material = reinterpret_cast<const ValueCommand *>(header)->value;
+                    break;
+                case CommandType::SET_UNIFORM: {
+                    const DrawUniform &uniform = reinterpret_cast<const UniformCommand *>(header)->uniform;
+                    auto existing = std::find_if(uniforms.begin(), uniforms.end(), [&](const DrawUniform &u) {
+                        return u.location == uniform.location;
+                    });
+                    if (existing != uniforms.end()) {
+                        *existing = uniform;
+                    } else {
+                        uniforms.push_back(uniform);
+                    }
+                    break;
+                }
+                case CommandType::BIND_UNIFORM_BLOCK: {
+                    // Block bindings are context state, unlike uniforms they survive program changes
+                    const UniformBlockRange &block = reinterpret_cast<const UniformBlockCommand *>(header)->block;
+                    auto existing = std::find_if(blocks.begin(), blocks.end(), [&](const UniformBlockRange &b) {
+                        return b.binding == block.binding;
+                    });
+                    if (existing != blocks.end()) {
+                        *existing = block;
+                    } else {
+                        blocks.push_back(block);
+                    }
+                    break;
+                }
+                case CommandType::DRAW: {
+                    const auto *draw = reinterpret_cast<const DrawCommand *>(header);
+                    const auto *drawCommands = reinterpret_cast<const DrawElementsIndirectCommand *>(draw + 1);
+                    submitDraw(queue, draw->pass, draw->depth, program, vertexArray, texture, material, uniforms,
+                               blocks, {drawCommands, draw->count});
+                    break;
+                }
+            }
+        }
+    }
+}
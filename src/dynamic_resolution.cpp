@@ -0,0 +1,116 @@
+#include <dynamic_resolution.h>
+
+#include <GLEW/glew.h>
+
+#include <algorithm>
+#include <cmath>
+#include <iostream>
+
+namespace {
+
+constexpr double SMOOTHING = 0.2;      // weight of a new measurement
+constexpr float MAX_DECREASE = 0.90f;  // per measurement, reacting fast to overload
+constexpr float MAX_INCREASE = 1.02f;  // and recovering slowly so it does not oscillate
+constexpr float HEADROOM = 0.85f;      // of the budget, below which the scale may grow
+
+void allocateTargets(DynamicResolution &resolution, int width, int height) {
+    if (!resolution.framebuffer) {
+        glGenFramebuffers(1, &resolution.framebuffer);
+        glGenTextures(1, &resolution.colorTexture);
+        glGenRenderbuffers(1, &resolution.depthBuffer);
+    }
+    glBindTexture(GL_TEXTURE_2D, resolution.colorTexture);
+    glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA16F, width, height, 0, GL_RGBA, GL_HALF_FLOAT, nullptr);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+    glBindTexture(GL_TEXTURE_2D, 0);
+    glBindRenderbuffer(GL_RENDERBUFFER, resolution.depthBuffer);
+    glRenderbufferStorage(GL_RENDERBUFFER, GL_DEPTH24_STENCIL8, width, height);
+    glBindRenderbuffer(GL_RENDERBUFFER, 0);
+
+    glBindFramebuffer(GL_FRAMEBUFFER, resolution.framebuffer);
+    glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, resolution.colorTexture, 0);
+    glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_DEPTH_STENCIL_ATTACHMENT, GL_RENDERBUFFER, resolution.depthBuffer);
+    if (glCheckFramebufferStatus(GL_FRAMEBUFFER) != GL_FRAMEBUFFER_COMPLETE) {
+        std::cerr << "Dynamic resolution framebuffer is incomplete" << std::endl;
+    }
+    glBindFramebuffer(GL_FRAMEBUFFER, 0);
+    resolution.allocatedWidth = width;
+    resolution.allocatedHeight = height;
+}
+
+void updateScale(DynamicResolution &resolution) {
+    double milliseconds;
+    if (!pollGpuTimer(resolution.timer, milliseconds) || milliseconds <= 0.0) {
+        return;
+    }
+    resolution.gpuMilliseconds = resolution.gpuMilliseconds == 0.0
+            ? milliseconds : resolution.gpuMilliseconds + (milliseconds - resolution.gpuMilliseconds) * SMOOTHING;
+
+    // The scene's cost follows its pixel count, the square of the scale
+    const auto ratio = static_cast<float>(resolution.budgetMilliseconds / resolution.gpuMilliseconds);
+    const float wanted = resolution.scale * std::sqrt(ratio);
+    if (ratio < 1.0f) {
+        resolution.scale = std::max(wanted, resolution.scale * MAX_DECREASE);
+    } else if (ratio > 1.0f / HEADROOM) {
+        resolution.scale = std::min(wanted, resolution.scale * MAX_INCREASE);
+    }
+    resolution.scale = std::clamp(resolution.scale, resolution.minScale, resolution.maxScale);
+}
+
+} // namespace
+
+void initDynamicResolution(DynamicResolution &resolution, float budgetMilliseconds) {
+    resolution.budgetMilliseconds = budgetMilliseconds;
+    resolution.scale = resolution.maxScale;
+    initGpuTimer(resolution.timer);
+}
+
+void destroyDynamicResolution(DynamicResolution &resolution) {
+    destroyGpuTimer(resolution.timer);
+    glDeleteFramebuffers(1, &resolution.framebuffer);
+    glDeleteTextures(1, &resolution.colorTexture);
+    glDeleteRenderbuffers(1, &resolution.depthBuffer);
+    resolution.framebuffer = 0;
+    resolution.colorTexture = 0;
+    resolution.depthBuffer = 0;
+    resolution.allocatedWidth = 0;
+    resolution.allocatedHeight = 0;
+}
+
+void updateDynamicResolution(DynamicResolution &resolution, int outputWidth, int outputHeight) {
+    updateScale(resolution);
+    resolution.outputWidth = std::max(outputWidth, 1);
+    resolution.outputHeight = std::max(outputHeight, 1);
+
+    auto scaled = [](int size, float scale) { return static_cast<int>(std::lround(static_cast<float>(size) * scale)); };
+    const int neededWidth = std::max(scaled(resolution.outputWidth, resolution.maxScale), 1);
+    const int neededHeight = std::max(scaled(resolution.outputHeight, resolution.maxScale), 1);
+    if (neededWidth > resolution.allocatedWidth || neededHeight > resolution.allocatedHeight) {
+        allocateTargets(resolution, std::max(neededWidth, resolution.allocatedWidth),
+                        std::max(neededHeight, resolution.allocatedHeight));
+    }
+    resolution.renderWidth = std::clamp(scaled(resolution.outputWidth, resolution.scale), 1, resolution.allocatedWidth);
+    resolution.renderHeight = std::clamp(scaled(resolution.outputHeight, resolution.scale), 1,
+                                         resolution.allocatedHeight);
+}
+
+void beginDynamicResolution(DynamicResolution &resolution) {
+    glBindFramebuffer(GL_FRAMEBUFFER, resolution.framebuffer);
+    glViewport(0, 0, resolution.renderWidth, resolution.renderHeight);
+    beginGpuTimer(resolution.timer);
+}
+
+void endDynamicResolution(DynamicResolution &resolution, unsigned int targetFramebuffer) {
+    // The upscale costs the same at any scale, keep it out of the measurement
+    endGpuTimer(resolution.timer);
+
+    glBindFramebuffer(GL_READ_FRAMEBUFFER, resolution.framebuffer);
+    glBindFramebuffer(GL_DRAW_FRAMEBUFFER, targetFramebuffer);
+    glBlitFramebuffer(0, 0, resolution.renderWidth, resolution.renderHeight,
+                      0, 0, resolution.outputWidth, resolution.outputHeight, GL_COLOR_BUFFER_BIT, GL_LINEAR);
+    glBindFramebuffer(GL_FRAMEBUFFER, 0);
+    glViewport(0, 0, resolution.outputWidth, resolution.outputHeight);
+}
@@ -0,0 +1,202 @@
+#include <ecs.h>
+
+#include <algorithm>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <mutex>
+#include <new>
+
+namespace {
+
+std::mutex componentMutex;
+std::vector<std::size_t> componentSizes;
+
+std::size_t componentSize(ComponentId id) {
+    std::lock_guard lock(componentMutex);
+    return componentSizes[id];
+}
+
+std::byte *allocateColumn(std::size_t bytes) {
+    const std::align_val_t alignment{COLUMN_ALIGNMENT};
+    return static_cast<std::byte *>(::operator new(std::max<std::size_t>(bytes, 1), alignment));
+}
+
+void freeColumn(std::byte *data) {
+    ::operator delete(data, std::align_val_t{COLUMN_ALIGNMENT});
+}
+
+void reserveRows(Archetype &archetype, std::size_t rows) {
+    if (rows <= archetype.capacity) {
+        return;
+    }
+    const std::size_t capacity = std::max({rows, archetype.capacity * 2, std::size_t{64}});
+    for (ComponentColumn &column : archetype.columns) {
+        std::byte *data = allocateColumn(capacity * column.size);
+        if (column.data) {
+            std::memcpy(data, column.data, archetype.entities.size() * column.size);
+            freeColumn(column.data);
+        }
+        column.data = data;
+    }
+    archetype.capacity = capacity;
+    archetype.entities.reserve(capacity);
+}
+
+// Appends a zeroed row, returns its index
+std::uint32_t appendRow(Archetype &archetype, Entity entity) {
+    const std::size_t row = archetype.entities.size();
+    reserveRows(archetype, row + 1);
+    for (ComponentColumn &column : archetype.columns) {
+        std::memset(column.data + row * column.size, 0, column.size);
+    }
+    archetype.entities.push_back(entity);
+    return static_cast<std::uint32_t>(row);
+}
+
+// Swaps the last row into `row` and fixes up the record of the entity that moved
+void removeRow(World &world, Archetype &archetype, std::uint32_t row) {
+    const std::size_t last = archetype.entities.size() - 1;
+    if (row != last) {
+        for (ComponentColumn &column : archetype.columns) {
+            std::memcpy(column.data + row * column.size, column.data + last * column.size, column.size);
+        }
+        const Entity moved = archetype.entities[last];
+        archetype.entities[row] = moved;
+        world.records[moved.index].row = row;
+    }
+    archetype.entities.pop_back();
+}
+
+Entity allocateEntity(World &world) {
+    if (!world.freeIndices.empty()) {
+        const std::uint32_t index = world.freeIndices.back();
+        world.freeIndices.pop_back();
+        return {index, world.records[index].generation};
+    }
+    world.records.push_back({nullptr, 0, 1});
+    return {static_cast<std::uint32_t>(world.records.size() - 1), 1};
+}
+
+} // namespace
+
+Archetype::~Archetype() {
+    for (ComponentColumn &column : columns) {
+        freeColumn(column.data);
+    }
+}
+
+ComponentId registerComponent(std::size_t size) {
+    std::lock_guard lock(componentMutex);
+    if (componentSizes.size() == MAX_COMPONENTS) {
+        // Masks are 64 bits wide, there is no way to keep going
+        std::cerr << "More than " << MAX_COMPONENTS << " component types registered" << std::endl;
+        std::abort();
+    }
+    componentSizes.push_back(size);
+    return static_cast<ComponentId>(componentSizes.size() - 1);
+}
+
+Archetype &archetypeFor(World &world, ComponentMask mask) {
+    if (auto found = world.archetypeByMask.find(mask); found != world.archetypeByMask.end()) {
+        return *found->second;
+    }
+    auto archetype = std::make_unique<Archetype>();
+    archetype->mask = mask;
+    std::fill(std::begin(archetype->columnOf), std::end(archetype->columnOf), 0xFF);
+    for (ComponentId id = 0; id < MAX_COMPONENTS; id++) {
+        if (mask & (ComponentMask{1} << id)) {
+            archetype->columnOf[id] = static_cast<std::uint8_t>(archetype->columns.size());
+            archetype->columns.push_back({id, componentSize(id), nullptr});
+        }
+    }
+    Archetype *result = archetype.get();
+    world.archetypes.push_back(std::move(archetype));
+    world.archetypeByMask.emplace(mask, result);
+    return *result;
+}
+
+Entity createEntity(World &world, ComponentMask mask) {
+    Archetype &archetype = archetypeFor(world, mask);
+    const Entity entity = allocateEntity(world);
+    EntityRecord &record = world.records[entity.index];
+    record.archetype = &archetype;
+    record.row = appendRow(archetype, entity);
+    return entity;
+}
+
+void createEntities(World &world, ComponentMask mask, std::size_t count, std::vector<Entity> *entities) {
+    Archetype &archetype = archetypeFor(world, mask);
+    const std::size_t first = archetype.entities.size();
+    reserveRows(archetype, first + count);
+    for (ComponentColumn &column : archetype.columns) {
+        std::memset(column.data + first * column.size, 0, count * column.size);
+    }
+    world.records.reserve(world.records.size() + count);
+    if (entities) {
+        entities->reserve(entities->size() + count);
+    }
+    for (std::size_t i = 0; i < count; i++) {
+        const Entity entity = allocateEntity(world);
+        world.records[entity.index].archetype = &archetype;
+        world.records[entity.index].row = static_cast<std::uint32_t>(first + i);
+        archetype.entities.push_back(entity);
+        if (entities) {
+            entities->push_back(entity);
+        }
+    }
+}
+
+bool isAlive(const World &world, Entity entity) {
+    return entity.index < world.records.size() && world.records[entity.index].archetype &&
+           world.records[entity.index].generation == entity.generation;
+}
+
+void destroyEntity(World &world, Entity entity) {
+    if (!isAlive(world, entity)) {
+        return;
+    }
+    EntityRecord &record = world.records[entity.index];
+    removeRow(world, *record.archetype, record.row);
+    record.archetype = nullptr;
+    record.generation++;
+    world.freeIndices.push_back(entity.index);
+}
+
+void setComponentMask(World &world, Entity entity, ComponentMask mask) {
+    if (!isAlive(world, entity) || world.records[entity.index].archetype->mask == mask) {
+        return;
+    }
+    Archetype &target = archetypeFor(world, mask); // may insert, take the record afterwards
+    EntityRecord &record = world.records[entity.index];
+    Archetype &source = *record.archetype;
+
+    const std::uint32_t row = appendRow(target, entity);
+    for (const ComponentColumn &column : source.columns) {
+        const std::uint8_t targetColumn = target.columnOf[column.id];
+        if (targetColumn != 0xFF) {
+            std::memcpy(target.columns[targetColumn].data + row * column.size,
+                        column.data + record.row * column.size, column.size);
+        }
+    }
+    removeRow(world, source, record.row);
+    record.archetype = &target;
+    record.row = row;
+}
+
+void *componentData(World &world, Entity entity, ComponentId id) {
+    if (!isAlive(world, entity)) {
+        return nullptr;
+    }
+    const EntityRecord &record = world.records[entity.index];
+    const std::uint8_t columnIndex = record.archetype->columnOf[id];
+    if (columnIndex == 0xFF) {
+        return nullptr;
+    }
+    const ComponentColumn &column = record.archetype->columns[columnIndex];
+    return column.data + record.row * column.size;
+}
+
+std::size_t entityCount(const World &world) {
+    return world.records.size() - world.freeIndices.size();
+}
@@ -0,0 +1,47 @@
+#include <fixed_timestep.h>
+
+FixedTimestep makeFixedTimestep(double hz, unsigned int maxSteps) {
+    FixedTimestep clock{};
+    clock.step = 1.0 / hz;
+    clock.maxSteps = maxSteps;
+    return clock;
+}
+
+unsigned int advanceFixedTimestep(FixedTimestep &clock, double now) {
+    if (clock.lockstep) {
+        clock.steps++;
+        return 1;
+    }
+    if (!clock.started) {
+        clock.started = true;
+        clock.lastTime = now;
+    }
+    clock.accumulator += now - clock.lastTime;
+    clock.lastTime = now;
+
+    unsigned int steps = 0;
+    while (clock.accumulator >= clock.step && steps < clock.maxSteps) {
+        clock.accumulator -= clock.step;
+        steps++;
+    }
+    if (clock.accumulator >= clock.step) {
+        // Still behind after maxSteps (breakpoint, window drag, a hitch): run slower rather than stall every
+        // following frame catching up
+        const auto behind = static_cast<std::uint64_t>(clock.accumulator / clock.step);
+        clock.droppedSteps += behind;
+        clock.accumulator -= static_cast<double>(behind) * clock.step;
+    }
+    clock.steps += steps;
+    return steps;
+}
+
+float interpolationAlpha(const FixedTimestep &clock) {
+    if (clock.lockstep) {
+        return 1.0f;
+    }
+    return static_cast<float>(clock.accumulator / clock.step);
+}
+
+double simulationTime(const FixedTimestep &clock) {
+    return static_cast<double>(clock.steps) * clock.step;
+}
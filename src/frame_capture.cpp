@@ -0,0 +1,498 @@
+#include <frame_capture.h>
+
+#include <GLEW/glew.h>
+
+#include <algorithm>
+#include <array>
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <iostream>
+
+namespace {
+
+using Clock = std::chrono::steady_clock;
+
+constexpr GLuint64 FENCE_TIMEOUT = 1'000'000'000; // 1 s, in nanoseconds
+
+double millisecondsSince(Clock::time_point start) {
+    return std::chrono::duration<double, std::milli>(Clock::now() - start).count();
+}
+
+// PNG container
+
+constexpr std::array<std::uint32_t, 256> CRC_TABLE = [] {
+    std::array<std::uint32_t, 256> table{};
+    for (std::uint32_t n = 0; n < 256; n++) {
+        std::uint32_t c = n;
+        for (int k = 0; k < 8; k++) {
+            c = c & 1 ? 0xedb88320u ^ (c >> 1) : c >> 1;
+        }
+        table[n] = c;
+    }
+    return table;
+}();
+
+std::uint32_t crc32(const unsigned char *data, std::size_t size, std::uint32_t crc = 0) {
+    crc = ~crc;
+    for (std::size_t i = 0; i < size; i++) {
+        crc = CRC_TABLE[(crc ^ data[i]) & 0xff] ^ (crc >> 8);
+    }
+    return ~crc;
+}
+
+std::uint32_t adler32(const unsigned char *data, std::size_t size) {
+    constexpr std::uint32_t MOD = 65521;
+    std::uint32_t a = 1, b = 0;
+    while (size > 0) {
+        const std::size_t block = std::min<std::size_t>(size, 5552); // largest run before b can overflow
+        for (std::size_t i = 0; i < block; i++) {
+            a += data[i];
+            b += a;
+        }
+        a %= MOD;
+        b %= MOD;
+        data += block;
+        size -= block;
+    }
+    return b << 16 | a;
+}
+
+void putBigEndian(std::vector<unsigned char> &out, std::uint32_t value) {
+    out.push_back(static_cast<unsigned char>(value >> 24));
+    out.push_back(static_cast<unsigned char>(value >> 16));
+    out.push_back(static_cast<unsigned char>(value >> 8));
+    out.push_back(static_cast<unsigned char>(value));
+}
+
+void putChunk(std::vector<unsigned char> &out, const char type[4], const unsigned char *data, std::size_t size) {
+    putBigEndian(out, static_cast<std::uint32_t>(size));
+    const std::size_t typeStart = out.size();
+    out.insert(out.end(), type, type + 4);
+    out.insert(out.end(), data, data + size);
+    putBigEndian(out, crc32(out.data() + typeStart, size + 4));
+}
+
+// Deflate, a single block with the fixed Huffman codes and greedy hash chain matching: far from the best ratio, but
+// fast enough to keep up with the frame rate on a couple of threads
+
+struct BitWriter {
+    std::vector<unsigned char> &out;
+    std::uint32_t buffer = 0;
+    int count = 0;
+
+    void write(std::uint32_t bits, int length) {
+        buffer |= bits << count;
+        count += length;
+        while (count >= 8) {
+            out.push_back(static_cast<unsigned char>(buffer));
+            buffer >>= 8;
+            count -= 8;
+        }
+    }
+
+    void flush() {
+        if (count > 0) {
+            out.push_back(static_cast<unsigned char>(buffer));
+        }
+        buffer = 0;
+        count = 0;
+    }
+};
+
+constexpr std::uint16_t LENGTH_BASE[29] = {3, 4, 5, 6, 7, 8, 9, 10, 11, 13, 15, 17, 19, 23, 27, 31, 35, 43, 51, 59, 67,
+                                           83, 99, 115, 131, 163, 195, 227, 258};
+constexpr std::uint8_t LENGTH_EXTRA[29] = {0, 0, 0, 0, 0, 0, 0, 0, 1, 1, 1, 1, 2, 2, 2, 2, 3, 3, 3, 3, 4, 4, 4, 4, 5,
+                                           5, 5, 5, 0};
+constexpr std::uint16_t DISTANCE_BASE[30] = {1, 2, 3, 4, 5, 7, 9, 13, 17, 25, 33, 49, 65, 97, 129, 193, 257, 385, 513,
+                                             769, 1025, 1537, 2049, 3073, 4097, 6145, 8193, 12289, 16385, 24577};
+constexpr std::uint8_t DISTANCE_EXTRA[30] = {0, 0, 0, 0, 1, 1, 2, 2, 3, 3, 4, 4, 5, 5, 6, 6, 7, 7, 8, 8, 9, 9, 10, 10,
+                                             11, 11, 12, 12, 13, 13};
+
+constexpr std::size_t WINDOW_SIZE = 32768;
+constexpr std::size_t MIN_MATCH = 3;
+constexpr std::size_t MAX_MATCH = 258;
+constexpr int HASH_BITS = 15;
+constexpr int MAX_CHAIN = 8;
+
+// Huffman codes are sent most significant bit first into a least significant bit first stream
+std::uint32_t reverseBits(std::uint32_t code, int length) {
+    std::uint32_t reversed = 0;
+    for (int i = 0; i < length; i++) {
+        reversed = reversed << 1 | (code >> i & 1);
+    }
+    return reversed;
+}
+
+void writeSymbol(BitWriter &writer, std::uint32_t symbol) {
+    if (symbol < 144) {
+        writer.write(reverseBits(0x30 + symbol, 8), 8);
+    } else if (symbol < 256) {
+        writer.write(reverseBits(0x190 + symbol - 144, 9), 9);
+    } else if (symbol < 280) {
+        writer.write(reverseBits(symbol - 256, 7), 7);
+    } else {
+        writer.write(reverseBits(0xc0 + symbol - 280, 8), 8);
+    }
+}
+
+void writeMatch(BitWriter &writer, std::size_t length, std::size_t distance) {
+    int code = 28;
+    while (LENGTH_BASE[code] > length) {
+        code--;
+    }
+    writeSymbol(writer, 257 + code);
+    writer.write(static_cast<std::uint32_t>(length - LENGTH_BASE[code]), LENGTH_EXTRA[code]);
+
+    code = 29;
+    while (DISTANCE_BASE[code] > distance) {
+        code--;
+    }
+    writer.write(reverseBits(code, 5), 5);
+    writer.write(static_cast<std::uint32_t>(distance - DISTANCE_BASE[code]), DISTANCE_EXTRA[code]);
+}
+
+std::uint32_t hashTriple(const unsigned char *p) {
+    return ((std::uint32_t{p[0]} << 16 | std::uint32_t{p[1]} << 8 | p[2]) * 2654435761u) >> (32 - HASH_BITS);
+}
+
+// zlib stream (RFC 1950) around the deflate block
+void deflate(const unsigned char *data, std::size_t size, std::vector<unsigned char> &out) {
+    out.push_back(0x78); // deflate, 32 KiB window
+    out.push_back(0x01); // fastest compression, header checksum
+    BitWriter writer{out};
+    writer.write(1, 1); // final block
+    writer.write(1, 2); // fixed Huffman codes
+
+    std::vector<std::int32_t> head(std::size_t{1} << HASH_BITS, -1);
+    std::vector<std::int32_t> previous(WINDOW_SIZE, -1);
+    auto insert = [&](std::size_t position) {
+        std::int32_t &slot = head[hashTriple(data + position)];
+        previous[position % WINDOW_SIZE] = slot;
+        slot = static_cast<std::int32_t>(position);
+    };
+
+    std::size_t position = 0;
+    while (position < size) {
+        std::size_t bestLength = 0, bestDistance = 0;
+        if (position + MIN_MATCH <= size) {
+            const std::size_t maxLength = std::min(MAX_MATCH, size - position);
+            std::int32_t candidate = head[hashTriple(data + position)];
+            for (int chain = 0; candidate >= 0 && chain < MAX_CHAIN; chain++) {
+                const auto start = static_cast<std::size_t>(candidate);
+                if (start >= position || position - start > WINDOW_SIZE) {
+                    break;
+                }
+                std::size_t length = 0;
+                while (length < maxLength && data[start + length] == data[position + length]) {
+                    length++;
+                }
+                if (length > bestLength) {
+                    bestLength = length;
+                    bestDistance = position - start;
+                    if (length == maxLength) {
+                        break;
+                    }
+                }
+                candidate = previous[start % WINDOW_SIZE];
+            }
+            insert(position);
+        }
+
+        if (bestLength >= MIN_MATCH) {
+            writeMatch(writer, bestLength, bestDistance);
+            for (std::size_t i = 1; i < bestLength; i++) {
+                if (position + i + MIN_MATCH <= size) {
+                    insert(position + i);
+                }
+            }
+            position += bestLength;
+        } else {
+            writeSymbol(writer, data[position]);
+            position++;
+        }
+    }
+    writeSymbol(writer, 256); // end of block
+    writer.flush();
+    putBigEndian(out, adler32(data, size));
+}
+
+// Encoder threads
+
+void writeFrame(FrameCapture &capture, CapturedFrame &frame, std::vector<unsigned char> &encoded) {
+    const auto start = Clock::now();
+    std::size_t written = 0;
+    if (capture.format == CaptureFormat::PNG) {
+        encodePng(frame.pixels.data(), capture.width, capture.height, encoded);
+        char suffix[32];
+        std::snprintf(suffix, sizeof(suffix), "_%06llu.png", static_cast<unsigned long long>(frame.index));
+        const std::string path = capture.output + suffix;
+        std::ofstream file(path, std::ios::binary | std::ios::trunc);
+        if (!file.write(reinterpret_cast<const char *>(encoded.data()), static_cast<std::streamsize>(encoded.size()))) {
+            std::cerr << "Failed to write " << path << std::endl;
+        } else {
+            written = encoded.size();
+        }
+    } else {
+        encodeYuv420(frame.pixels.data(), capture.width, capture.height, encoded);
+        std::unique_lock lock(capture.mutex);
+        capture.condition.wait(lock, [&] { return capture.nextWrite == frame.index; });
+        capture.video << "FRAME\n";
+        capture.video.write(reinterpret_cast<const char *>(encoded.data()),
+                            static_cast<std::streamsize>(encoded.size()));
+        written = encoded.size() + 6;
+        capture.nextWrite++;
+    }
+
+    std::lock_guard lock(capture.mutex);
+    capture.stats.encoded++;
+    capture.stats.bytesWritten += written;
+    capture.stats.encodeMilliseconds += millisecondsSince(start);
+}
+
+void encodeFrames(FrameCapture &capture) {
+    std::vector<unsigned char> encoded;
+    while (true) {
+        std::unique_ptr<CapturedFrame> frame;
+        {
+            std::unique_lock lock(capture.mutex);
+            capture.condition.wait(lock, [&] { return !capture.queue.empty() || capture.stopping; });
+            if (capture.queue.empty()) {
+                return;
+            }
+            frame = std::move(capture.queue.front());
+            capture.queue.pop_front();
+        }
+        writeFrame(capture, *frame, encoded);
+        {
+            std::lock_guard lock(capture.mutex);
+            capture.freeFrames.push_back(std::move(frame));
+        }
+        capture.condition.notify_all();
+    }
+}
+
+// Copies a finished readback out of its buffer and queues it for the encoders
+void collectReadback(FrameCapture &capture, std::size_t slot) {
+    auto sync = static_cast<GLsync>(capture.fences[slot]);
+    if (glClientWaitSync(sync, 0, 0) == GL_TIMEOUT_EXPIRED) {
+        {
+            std::lock_guard lock(capture.mutex);
+            capture.stats.readbackStalls++;
+        }
+        glClientWaitSync(sync, GL_SYNC_FLUSH_COMMANDS_BIT, FENCE_TIMEOUT);
+    }
+    glDeleteSync(sync);
+    capture.fences[slot] = nullptr;
+
+    std::unique_ptr<CapturedFrame> frame;
+    {
+        std::unique_lock lock(capture.mutex);
+        if (capture.freeFrames.empty() && capture.allocatedFrames == FrameCapture::MAX_FRAMES) {
+            capture.stats.encoderStalls++;
+            capture.condition.wait(lock, [&] { return !capture.freeFrames.empty(); });
+        }
+        if (capture.freeFrames.empty()) {
+            frame = std::make_unique<CapturedFrame>();
+            capture.allocatedFrames++;
+        } else {
+            frame = std::move(capture.freeFrames.back());
+            capture.freeFrames.pop_back();
+        }
+    }
+
+    const std::size_t size = static_cast<std::size_t>(capture.width) * static_cast<std::size_t>(capture.height) * 4;
+    frame->pixels.resize(size);
+    glBindBuffer(GL_PIXEL_PACK_BUFFER, capture.pixelBuffers[slot]);
+    const void *mapped = glMapBufferRange(GL_PIXEL_PACK_BUFFER, 0, static_cast<GLsizeiptr>(size), GL_MAP_READ_BIT);
+    if (mapped) {
+        std::memcpy(frame->pixels.data(), mapped, size);
+        glUnmapBuffer(GL_PIXEL_PACK_BUFFER);
+    }
+    glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+
+    {
+        std::lock_guard lock(capture.mutex);
+        if (mapped) {
+            frame->index = capture.stats.captured++;
+            capture.queue.push_back(std::move(frame));
+        } else {
+            capture.stats.dropped++;
+            capture.freeFrames.push_back(std::move(frame));
+        }
+    }
+    capture.condition.notify_all();
+}
+
+} // namespace
+
+int initFrameCapture(FrameCapture &capture, std::string_view output, int width, int height, int framesPerSecond,
+                     std::size_t encoderThreads) {
+    capture.output = std::string(output);
+    capture.format = capture.output.ends_with(".y4m") ? CaptureFormat::Y4M : CaptureFormat::PNG;
+    capture.width = width;
+    capture.height = height;
+    if (width <= 0 || height <= 0) {
+        std::cerr << "Cannot capture a " << width << "x" << height << " framebuffer" << std::endl;
+        return -1;
+    }
+
+    if (capture.format == CaptureFormat::Y4M) {
+        capture.video.open(capture.output, std::ios::binary | std::ios::trunc);
+        if (!capture.video) {
+            std::cerr << "Failed to create " << capture.output << std::endl;
+            return -1;
+        }
+        // Full range BT.601 with 4:2:0 chroma centred between the luma samples, as in JPEG
+        capture.video << "YUV4MPEG2 W" << width << " H" << height << " F" << framesPerSecond << ":1 Ip A1:1 C420jpeg\n";
+    }
+
+    const auto size = static_cast<GLsizeiptr>(width) * height * 4;
+    glGenBuffers(FrameCapture::SLOTS, capture.pixelBuffers);
+    for (unsigned int buffer : capture.pixelBuffers) {
+        glBindBuffer(GL_PIXEL_PACK_BUFFER, buffer);
+        glBufferData(GL_PIXEL_PACK_BUFFER, size, nullptr, GL_STREAM_READ);
+    }
+    glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+
+    for (std::size_t i = 0; i < std::max<std::size_t>(encoderThreads, 1); i++) {
+        capture.encoders.emplace_back(encodeFrames, std::ref(capture));
+    }
+    return 0;
+}
+
+void captureFrame(FrameCapture &capture, int framebufferWidth, int framebufferHeight) {
+    const auto start = Clock::now();
+    if (framebufferWidth != capture.width || framebufferHeight != capture.height) {
+        std::lock_guard lock(capture.mutex);
+        capture.stats.dropped++;
+        return;
+    }
+
+    // The buffer about to be reused holds the readback from SLOTS frames ago
+    const std::size_t slot = capture.issued % FrameCapture::SLOTS;
+    if (capture.fences[slot]) {
+        collectReadback(capture, slot);
+    }
+
+    glBindBuffer(GL_PIXEL_PACK_BUFFER, capture.pixelBuffers[slot]);
+    glPixelStorei(GL_PACK_ALIGNMENT, 4);
+    glReadPixels(0, 0, capture.width, capture.height, GL_RGBA, GL_UNSIGNED_BYTE, nullptr);
+    glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+    capture.fences[slot] = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+    capture.issued++;
+
+    std::lock_guard lock(capture.mutex);
+    capture.stats.renderThreadMilliseconds += millisecondsSince(start);
+}
+
+void finishFrameCapture(FrameCapture &capture) {
+    // Oldest first, so the frames keep their order
+    for (std::size_t i = 0; i < FrameCapture::SLOTS; i++) {
+        const std::size_t slot = (capture.issued + i) % FrameCapture::SLOTS;
+        if (capture.fences[slot]) {
+            collectReadback(capture, slot);
+        }
+    }
+    {
+        std::lock_guard lock(capture.mutex);
+        capture.stopping = true;
+    }
+    capture.condition.notify_all();
+    for (std::thread &encoder : capture.encoders) {
+        encoder.join();
+    }
+    capture.encoders.clear();
+
+    glDeleteBuffers(FrameCapture::SLOTS, capture.pixelBuffers);
+    std::fill(std::begin(capture.pixelBuffers), std::end(capture.pixelBuffers), 0u);
+    if (capture.video.is_open()) {
+        capture.video.close();
+    }
+}
+
+FrameCaptureStats frameCaptureStats(FrameCapture &capture) {
+    std::lock_guard lock(capture.mutex);
+    return capture.stats;
+}
+
+void encodePng(const unsigned char *pixels, int width, int height, std::vector<unsigned char> &out) {
+    // RGB scanlines top to bottom, each with the Sub filter: bytes become differences to the pixel on their left
+    const std::size_t rowSize = static_cast<std::size_t>(width) * 3 + 1;
+    std::vector<unsigned char> scanlines(rowSize * static_cast<std::size_t>(height));
+    for (int y = 0; y < height; y++) {
+        const unsigned char *source = pixels + static_cast<std::size_t>(height - 1 - y) * width * 4;
+        unsigned char *row = scanlines.data() + static_cast<std::size_t>(y) * rowSize;
+        row[0] = 1;
+        unsigned char left[3] = {0, 0, 0};
+        for (int x = 0; x < width; x++) {
+            for (int c = 0; c < 3; c++) {
+                const unsigned char value = source[x * 4 + c];
+                row[1 + x * 3 + c] = static_cast<unsigned char>(value - left[c]);
+                left[c] = value;
+            }
+        }
+    }
+
+    std::vector<unsigned char> compressed;
+    deflate(scanlines.data(), scanlines.size(), compressed);
+
+    // Signature, then three chunks of length, type, data and CRC: sized once up front
+    constexpr unsigned char SIGNATURE[8] = {0x89, 'P', 'N', 'G', '\r', '\n', 0x1a, '\n'};
+    constexpr std::size_t CHUNK_OVERHEAD = 12;
+    out.reserve(sizeof(SIGNATURE) + CHUNK_OVERHEAD * 3 + 13 + compressed.size());
+    out.assign(SIGNATURE, SIGNATURE + sizeof(SIGNATURE));
+    // Width and height big endian, then 8 bit RGB, deflate, adaptive filtering, not interlaced
+    const auto w = static_cast<std::uint32_t>(width), h = static_cast<std::uint32_t>(height);
+    const std::array<unsigned char, 13> header = {
+            static_cast<unsigned char>(w >> 24), static_cast<unsigned char>(w >> 16),
+            static_cast<unsigned char>(w >> 8), static_cast<unsigned char>(w),
+            static_cast<unsigned char>(h >> 24), static_cast<unsigned char>(h >> 16),
+            static_cast<unsigned char>(h >> 8), static_cast<unsigned char>(h),
+            8, 2, 0, 0, 0
+    };
+    putChunk(out, "IHDR", header.data(), header.size());
+    putChunk(out, "IDAT", compressed.data(), compressed.size());
+    putChunk(out, "IEND", nullptr, 0);
+}
+
+void encodeYuv420(const unsigned char *pixels, int width, int height, std::vector<unsigned char> &out) {
+    const int chromaWidth = (width + 1) / 2, chromaHeight = (height + 1) / 2;
+    const std::size_t lumaSize = static_cast<std::size_t>(width) * height;
+    const std::size_t chromaSize = static_cast<std::size_t>(chromaWidth) * chromaHeight;
+    out.resize(lumaSize + chromaSize * 2);
+    unsigned char *luma = out.data();
+    unsigned char *blueDifference = luma + lumaSize;
+    unsigned char *redDifference = blueDifference + chromaSize;
+
+    // Full range BT.601 in 16.16 fixed point
+    auto pixel = [&](int x, int y) {
+        return pixels + (static_cast<std::size_t>(height - 1 - y) * width + x) * 4; // rows top to bottom
+    };
+    for (int y = 0; y < height; y++) {
+        for (int x = 0; x < width; x++) {
+            const unsigned char *p = pixel(x, y);
+            luma[static_cast<std::size_t>(y) * width + x] = static_cast<unsigned char>(
+                    (19595 * p[0] + 38470 * p[1] + 7471 * p[2] + 32768) >> 16);
+        }
+    }
+    for (int y = 0; y < chromaHeight; y++) {
+        for (int x = 0; x < chromaWidth; x++) {
+            // Average of the 2x2 block, edge pixels repeated for odd sizes
+            int r = 0, g = 0, b = 0;
+            for (int k = 0; k < 4; k++) {
+                const unsigned char *p = pixel(std::min(x * 2 + (k & 1), width - 1),
+                                               std::min(y * 2 + (k >> 1), height - 1));
+                r += p[0];
+                g += p[1];
+                b += p[2];
+            }
+            const std::size_t i = static_cast<std::size_t>(y) * chromaWidth + x;
+            // Sums of four pixels: the factors are the usual ones divided by 4, and 128 scaled back up
+            blueDifference[i] = static_cast<unsigned char>(std::clamp(
+                    (-11059 * r - 21709 * g + 32768 * b + (128 << 18) + (1 << 17)) >> 18, 0, 255));
+            redDifference[i] = static_cast<unsigned char>(std::clamp(
+                    (32768 * r - 27439 * g - 5329 * b + (128 << 18) + (1 << 17)) >> 18, 0, 255));
+        }
+    }
+}
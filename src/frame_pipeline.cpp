@@ -0,0 +1,49 @@
+#include <frame_pipeline.h>
+
+FramePacket *beginFramePacket(FramePipeline &pipeline) {
+    std::unique_lock lock(pipeline.mutex);
+    pipeline.condition.wait(lock, [&] {
+        return pipeline.closed || pipeline.published - pipeline.consumed < 2;
+    });
+    if (pipeline.closed) {
+        return nullptr;
+    }
+    FramePacket &packet = pipeline.packets[pipeline.published & 1];
+    packet.frameIndex = pipeline.published;
+    return &packet;
+}
+
+void publishFramePacket(FramePipeline &pipeline) {
+    {
+        std::lock_guard lock(pipeline.mutex);
+        pipeline.published++;
+    }
+    pipeline.condition.notify_all();
+}
+
+const FramePacket *acquireFramePacket(FramePipeline &pipeline) {
+    std::unique_lock lock(pipeline.mutex);
+    pipeline.condition.wait(lock, [&] {
+        return pipeline.closed || pipeline.consumed < pipeline.published;
+    });
+    if (pipeline.closed) {
+        return nullptr;
+    }
+    return &pipeline.packets[pipeline.consumed & 1];
+}
+
+void releaseFramePacket(FramePipeline &pipeline) {
+    {
+        std::lock_guard lock(pipeline.mutex);
+        pipeline.consumed++;
+    }
+    pipeline.condition.notify_all();
+}
+
+void closeFramePipeline(FramePipeline &pipeline) {
+    {
+        std::lock_guard lock(pipeline.mutex);
+        pipeline.closed = true;
+    }
+    pipeline.condition.notify_all();
+}
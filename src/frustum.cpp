@@ -0,0 +1,154 @@
+#include <frustum.h>
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+namespace {
+
+// Each plane pre-splatted, with the absolute normal used for the box's projected radius
+template<typename T>
+struct WidePlane {
+    T normal[3];
+    T absNormal[3];
+    T distance;
+};
+
+template<typename T>
+void classifyKernel(const WidePlane<T> planes[6], const BoxArrays &boxes, Containment *results, std::size_t begin,
+                    std::size_t end) {
+    const T zero = T::splat(0.0f);
+    for (std::size_t i = begin; i < end; i += T::WIDTH) {
+        const T cx = T::load(boxes.centerX + i), cy = T::load(boxes.centerY + i), cz = T::load(boxes.centerZ + i);
+        const T ex = T::load(boxes.extentX + i), ey = T::load(boxes.extentY + i), ez = T::load(boxes.extentZ + i);
+
+        // Over all planes: the smallest distance of the box's nearest corner (negative means fully outside
+        // that plane) and of its farthest corner (negative means the plane cuts the box)
+        T nearest = T::splat(std::numeric_limits<float>::max());
+        T farthest = nearest;
+        for (int p = 0; p < 6; p++) {
+            const WidePlane<T> &plane = planes[p];
+            const T distance = madd(plane.normal[2], cz,
+                                    madd(plane.normal[1], cy, madd(plane.normal[0], cx, plane.distance)));
+            const T radius = madd(plane.absNormal[2], ez, madd(plane.absNormal[1], ey, plane.absNormal[0] * ex));
+            nearest = minimum(nearest, distance + radius);
+            farthest = minimum(farthest, distance - radius);
+        }
+
+        const int outside = maskBits(greaterThan(zero, nearest));
+        const int intersects = maskBits(greaterThan(zero, farthest));
+        for (int lane = 0; lane < T::WIDTH; lane++) {
+            results[i + lane] = (outside >> lane) & 1      ? Containment::OUTSIDE
+                                : (intersects >> lane) & 1 ? Containment::INTERSECTS
+                                                           : Containment::INSIDE;
+        }
+    }
+}
+
+template<typename T>
+void splatPlanes(const Frustum &frustum, WidePlane<T> planes[6]) {
+    for (int p = 0; p < 6; p++) {
+        for (int axis = 0; axis < 3; axis++) {
+            planes[p].normal[axis] = T::splat(frustum.planes[p][axis]);
+            planes[p].absNormal[axis] = T::splat(std::fabs(frustum.planes[p][axis]));
+        }
+        planes[p].distance = T::splat(frustum.planes[p][3]);
+    }
+}
+
+} // namespace
+
+Frustum extractFrustum(const float viewProjection[16]) {
+    auto row = [viewProjection](int r, int c) { return viewProjection[c * 4 + r]; };
+    Frustum frustum{};
+    for (int axis = 0; axis < 3; axis++) {
+        for (int side = 0; side < 2; side++) {
+            float *plane = frustum.planes[axis * 2 + side];
+            const float sign = side == 0 ? 1.0f : -1.0f;
+            for (int c = 0; c < 4; c++) {
+                plane[c] = row(3, c) + sign * row(axis, c);
+            }
+            const float length = std::sqrt(plane[0] * plane[0] + plane[1] * plane[1] + plane[2] * plane[2]);
+            if (length > 0.0f) {
+                for (int c = 0; c < 4; c++) {
+                    plane[c] /= length;
+                }
+            }
+        }
+    }
+    return frustum;
+}
+
+Aabb mergeAabb(const Aabb &a, const Aabb &b) {
+    return {
+            {std::min(a.min.x, b.min.x), std::min(a.min.y, b.min.y), std::min(a.min.z, b.min.z)},
+            {std::max(a.max.x, b.max.x), std::max(a.max.y, b.max.y), std::max(a.max.z, b.max.z)}
+    };
+}
+
+float surfaceArea(const Aabb &box) {
+    const vec3 size = box.max - box.min;
+    return 2.0f * (size.x * size.y + size.y * size.z + size.z * size.x);
+}
+
+bool containsAabb(const Aabb &outer, const Aabb &inner) {
+    return outer.min.x <= inner.min.x && outer.min.y <= inner.min.y && outer.min.z <= inner.min.z &&
+           inner.max.x <= outer.max.x && inner.max.y <= outer.max.y && inner.max.z <= outer.max.z;
+}
+
+Aabb transformAabb(const mat4 &m, const Aabb &box) {
+    const vec3 center = (box.min + box.max) * 0.5f;
+    const vec3 extent = (box.max - box.min) * 0.5f;
+    const vec3 newCenter = transformPoint(m, center);
+    const vec4 *c = m.columns;
+    const vec3 newExtent{
+            std::fabs(c[0].x) * extent.x + std::fabs(c[1].x) * extent.y + std::fabs(c[2].x) * extent.z,
+            std::fabs(c[0].y) * extent.x + std::fabs(c[1].y) * extent.y + std::fabs(c[2].y) * extent.z,
+            std::fabs(c[0].z) * extent.x + std::fabs(c[1].z) * extent.y + std::fabs(c[2].z) * extent.z
+    };
+    return {newCenter - newExtent, newCenter + newExtent};
+}
+
+Containment classifyBox(const Frustum &frustum, const Aabb &box) {
+    const vec3 center = (box.min + box.max) * 0.5f;
+    const vec3 extent = (box.max - box.min) * 0.5f;
+    Containment result = Containment::INSIDE;
+    for (const float *plane : frustum.planes) {
+        const float distance = plane[0] * center.x + plane[1] * center.y + plane[2] * center.z + plane[3];
+        const float radius = std::fabs(plane[0]) * extent.x + std::fabs(plane[1]) * extent.y +
+                             std::fabs(plane[2]) * extent.z;
+        if (distance + radius < 0.0f) {
+            return Containment::OUTSIDE;
+        }
+        if (distance - radius < 0.0f) {
+            result = Containment::INTERSECTS;
+        }
+    }
+    return result;
+}
+
+void classifyBoxes(const Frustum &frustum, const BoxArrays &boxes, Containment *results, std::size_t count) {
+    const std::size_t wide = count - count % floatN::WIDTH;
+    WidePlane<floatN> planes[6];
+    splatPlanes(frustum, planes);
+    classifyKernel(planes, boxes, results, 0, wide);
+
+    // The tail goes through zero padded 4 wide passes
+    WidePlane<float4> narrowPlanes[6];
+    splatPlanes(frustum, narrowPlanes);
+    for (std::size_t i = wide; i < count; i += 4) {
+        const std::size_t lanes = std::min<std::size_t>(4, count - i);
+        float lane[6][4] = {};
+        for (std::size_t l = 0; l < lanes; l++) {
+            lane[0][l] = boxes.centerX[i + l];
+            lane[1][l] = boxes.centerY[i + l];
+            lane[2][l] = boxes.centerZ[i + l];
+            lane[3][l] = boxes.extentX[i + l];
+            lane[4][l] = boxes.extentY[i + l];
+            lane[5][l] = boxes.extentZ[i + l];
+        }
+        Containment laneResults[4];
+        classifyKernel(narrowPlanes, {lane[0], lane[1], lane[2], lane[3], lane[4], lane[5]}, laneResults, 0, 4);
+        std::copy_n(laneResults, lanes, results + i);
+    }
+}
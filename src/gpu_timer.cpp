@@ -0,0 +1,49 @@
+#include <gpu_timer.h>
+
+#include <GLEW/glew.h>
+
+void initGpuTimer(GpuTimer &timer) {
+    glGenQueries(GpuTimer::LATENCY * 2, &timer.queries[0][0]);
+    timer.begun = 0;
+    timer.resolved = 0;
+    timer.measuring = false;
+}
+
+void destroyGpuTimer(GpuTimer &timer) {
+    glDeleteQueries(GpuTimer::LATENCY * 2, &timer.queries[0][0]);
+    timer = GpuTimer{};
+}
+
+void beginGpuTimer(GpuTimer &timer) {
+    timer.measuring = timer.begun - timer.resolved < GpuTimer::LATENCY;
+    if (timer.measuring) {
+        glQueryCounter(timer.queries[timer.begun % GpuTimer::LATENCY][0], GL_TIMESTAMP);
+    }
+}
+
+void endGpuTimer(GpuTimer &timer) {
+    if (timer.measuring) {
+        glQueryCounter(timer.queries[timer.begun % GpuTimer::LATENCY][1], GL_TIMESTAMP);
+        timer.begun++;
+        timer.measuring = false;
+    }
+}
+
+bool pollGpuTimer(GpuTimer &timer, double &milliseconds) {
+    bool finished = false;
+    while (timer.resolved < timer.begun) {
+        const unsigned int *slot = timer.queries[timer.resolved % GpuTimer::LATENCY];
+        GLint available = GL_FALSE;
+        glGetQueryObjectiv(slot[1], GL_QUERY_RESULT_AVAILABLE, &available);
+        if (!available) {
+            break; // later spans cannot be done either
+        }
+        GLuint64 begin = 0, end = 0;
+        glGetQueryObjectui64v(slot[0], GL_QUERY_RESULT, &begin);
+        glGetQueryObjectui64v(slot[1], GL_QUERY_RESULT, &end);
+        milliseconds = static_cast<double>(end - begin) * 1e-6;
+        timer.resolved++;
+        finished = true;
+    }
+    return finished;
+}
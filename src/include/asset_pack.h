@@ -0,0 +1,64 @@
+#pragma once
+
+#include <mapped_file.h>
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <vector>
+
+// Asset archive: many files in one, so a cold start maps a single file instead of opening and stat'ing each asset.
+// Layout: header, table of contents sorted by path hash, path strings, then the entries' data, each starting on a
+// 4 KiB boundary. Entries are stored raw or compressed with the LZ4 block format; raw entries are served as views
+// straight into the mapping.
+
+constexpr std::uint64_t ASSET_PACK_ALIGNMENT = 4096;
+
+enum class AssetCompression : std::uint32_t {
+    NONE = 0, LZ4 = 1
+};
+
+struct AssetPackEntry {
+    std::uint64_t pathHash;   // assetPathHash of the path
+    std::uint32_t pathOffset; // into the string table
+    std::uint32_t pathLength;
+    std::uint64_t offset;     // of the data, from the start of the file
+    std::uint64_t storedSize;
+    std::uint64_t size;       // once decompressed
+    AssetCompression compression;
+    std::uint32_t padding;
+};
+
+struct AssetPack {
+    MappedFile file;
+    const AssetPackEntry *entries = nullptr;
+    std::uint32_t entryCount = 0;
+    const char *paths = nullptr;
+};
+
+// What to put in a pack, with its path inside it
+struct AssetSource {
+    std::string path;
+    std::vector<unsigned char> data;
+};
+
+std::uint64_t assetPathHash(std::string_view path);
+
+// Entries are compressed when that saves at least an eighth of their size, unless `compress` is false
+int writeAssetPack(std::string_view packPath, const std::vector<AssetSource> &assets, bool compress = true);
+
+int openAssetPack(std::string_view packPath, AssetPack &pack);
+const AssetPackEntry *findAsset(const AssetPack &pack, std::string_view path);
+std::string_view assetPath(const AssetPack &pack, const AssetPackEntry &entry);
+// Zero copy view of an uncompressed entry, null for compressed ones
+const unsigned char *assetData(const AssetPack &pack, const AssetPackEntry &entry);
+// Copies or decompresses an entry into `out`
+int readAsset(const AssetPack &pack, const AssetPackEntry &entry, unsigned char *out);
+
+// LZ4 block format, without the frame around it. compressBlock needs compressBound(size) bytes of output and
+// returns the compressed size; decompressBlock checks every read and write against the buffers and fails with -1
+// unless it produces exactly outputSize bytes.
+std::size_t compressBound(std::size_t size);
+std::size_t compressBlock(const unsigned char *input, std::size_t size, unsigned char *output);
+int decompressBlock(const unsigned char *input, std::size_t inputSize, unsigned char *output, std::size_t outputSize);
@@ -0,0 +1,56 @@
+#pragma once
+
+#include <frustum.h>
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+// Dynamic bounding volume hierarchy over object boxes, for frustum culling. Leaves keep a box fattened by
+// `margin`, so objects that move a little never touch the tree; one that leaves its fat box is pulled out and
+// reinserted where the surface area heuristic says it costs least. Incremental edits slowly degrade the tree,
+// rebuildBvh rebuilds it top down with a binned SAH when bvhCost says it is worth it.
+
+constexpr std::uint32_t NULL_NODE = ~0u;
+
+struct BvhNode {
+    Aabb bounds; // fattened for leaves
+    std::uint32_t parent;
+    std::uint32_t children[2]; // NULL_NODE for leaves
+    std::uint32_t object;      // leaves only, whatever the caller passed in
+};
+
+struct BvhQueryStats {
+    std::size_t nodesTested = 0;
+    std::size_t visibleObjects = 0;
+};
+
+struct Bvh {
+    std::vector<BvhNode> nodes;
+    std::vector<std::uint32_t> freeNodes;
+    std::uint32_t root = NULL_NODE;
+    std::size_t leafCount = 0;
+    float margin = 0.1f;
+
+    // Query scratch, kept between frames
+    std::vector<std::uint32_t> pending;
+    std::vector<std::uint32_t> inside;
+};
+
+// Returns the leaf, which stays valid until removed (rebuilds and reinsertion keep it)
+std::uint32_t insertBvhLeaf(Bvh &bvh, const Aabb &box, std::uint32_t object);
+void removeBvhLeaf(Bvh &bvh, std::uint32_t leaf);
+// Nothing happens while the box stays inside the leaf's fat box, otherwise the leaf is reinserted. Returns
+// whether the tree changed.
+bool moveBvhLeaf(Bvh &bvh, std::uint32_t leaf, const Aabb &box);
+
+// Shrinks every internal node to its children, for after many leaves moved
+void refitBvh(Bvh &bvh);
+// Top down binned SAH build over the current leaves
+void rebuildBvh(Bvh &bvh);
+// Summed surface area of the internal nodes relative to the root: the expected number of nodes a query visits
+float bvhCost(const Bvh &bvh);
+
+// Replaces `objects` with the objects whose fat box touches the frustum. Nodes are tested floatN::WIDTH at a
+// time, subtrees fully inside are taken without testing further.
+void queryBvh(Bvh &bvh, const Frustum &frustum, std::vector<std::uint32_t> &objects, BvhQueryStats *stats = nullptr);
@@ -0,0 +1,95 @@
+#pragma once
+
+#include <vector_math.h>
+
+#include <cstddef>
+#include <cstdint>
+#include <span>
+#include <vector>
+
+struct PointLight {
+    vec3 position; // world space
+    float radius;  // the light fades to nothing here
+    vec3 color;    // premultiplied by its intensity
+};
+
+// The view is split into CLUSTER_TILES_X x CLUSTER_TILES_Y screen tiles times CLUSTER_SLICES depth slices,
+// spaced exponentially in view depth so near froxels stay small
+constexpr std::uint32_t CLUSTER_TILES_X = 16;
+constexpr std::uint32_t CLUSTER_TILES_Y = 9;
+constexpr std::uint32_t CLUSTER_SLICES = 24;
+constexpr std::uint32_t CLUSTER_COUNT = CLUSTER_TILES_X * CLUSTER_TILES_Y * CLUSTER_SLICES;
+
+// Light indices are stored as 16 bits, lights past this are ignored
+constexpr std::size_t MAX_POINT_LIGHTS = 65536;
+
+// Texture units the light texture buffers are bound to, samplers of lit programs are set to them
+enum ClusterTextureUnit : unsigned int {
+    CLUSTER_LIGHT_UNIT = 1, CLUSTER_RANGE_UNIT = 2, CLUSTER_INDEX_UNIT = 3
+};
+
+// Mirrors the `Clusters` block of cluster_block.glsl
+struct ClusterBlock {
+    mat4 view;
+    vec4 grid;  // tiles x, tiles y, slices
+    vec4 scale; // tiles per pixel in x and y, then slice = log(view depth) * z + w
+};
+
+struct ClusterStats {
+    std::size_t lights = 0;
+    std::size_t indices = 0;          // light references over all clusters
+    std::size_t maxClusterLights = 0;
+    double buildMilliseconds = 0.0;
+};
+
+// View space box of one froxel
+struct ClusterBounds {
+    float minX, minY, minZ;
+    float maxX, maxY, maxZ;
+};
+
+// Lights overlapping one depth slice, gathered so its tiles test only those
+struct ClusterSlice {
+    std::vector<float> x, y, z, radius;  // view space, padded to the lane width with lights that reach nothing
+    std::vector<std::uint16_t> lights;   // their indices
+    std::vector<std::uint16_t> indices;  // the slice's cluster lists, back to back in tile order
+};
+
+// Clustered forward shading: every frame the lights are assigned to the froxels they touch on the CPU, a slice
+// per job with SIMD sphere against box tests, and the result goes into three texture buffers (core since 3.1):
+// the lights, an offset and count per cluster, and the concatenated light indices. A lit fragment finds its
+// cluster from its window position and view depth and loops over that cluster's lights only.
+struct ClusteredLighting {
+    // What the froxel bounds were built for, they only change with the projection
+    mat4 projection{};
+    float nearDepth = 0.0f;
+    float farDepth = 0.0f;
+    std::vector<ClusterBounds> bounds;
+
+    std::vector<float> lightX, lightY, lightZ, lightRadius; // view space
+    ClusterSlice slices[CLUSTER_SLICES];
+    std::uint32_t clusterCounts[CLUSTER_COUNT] = {};
+    std::vector<std::uint32_t> ranges;   // offset and count per cluster
+    std::vector<std::uint16_t> indices;
+    std::vector<float> lightData;        // position and radius, color: two RGBA32F texels per light
+
+    unsigned int buffers[3] = {};        // lights, ranges, indices
+    unsigned int textures[3] = {};
+    ClusterBlock block{};
+    ClusterStats stats;
+};
+
+void initClusteredLighting(ClusteredLighting &clusters);
+void destroyClusteredLighting(ClusteredLighting &clusters);
+
+// Assigns the lights to the froxels of a view covering nearDepth to farDepth (positive distances) and uploads the
+// lists. renderWidth and renderHeight are the size of the framebuffer the lit draws go to.
+void buildClusters(ClusteredLighting &clusters, std::span<const PointLight> lights, const mat4 &view,
+                   const mat4 &projection, float nearDepth, float farDepth, int renderWidth, int renderHeight);
+// The CPU half of buildClusters, filling bounds, ranges, indices and the block without touching GL
+void assignClusters(ClusteredLighting &clusters, std::span<const PointLight> lights, const mat4 &view,
+                    const mat4 &projection, float nearDepth, float farDepth, int renderWidth, int renderHeight);
+// Binds the texture buffers to their units, leaves texture unit 0 active
+void bindClusters(const ClusteredLighting &clusters);
+// Points a lit program's samplers at the cluster texture units
+void setClusterSamplers(unsigned int program);
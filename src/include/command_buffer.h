@@ -0,0 +1,69 @@
+#pragma once
+
+#include <render_queue.h>
+
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <span>
+#include <vector>
+
+// Bump allocator over fixed size blocks. Nothing is freed individually, reset() rewinds to the first block and
+// keeps every block around, so after the first few frames recording never touches the heap.
+struct LinearAllocator {
+    static constexpr std::size_t BLOCK_SIZE = 64 * 1024;
+
+    std::vector<std::unique_ptr<std::byte[]>> blocks;
+    std::vector<std::size_t> blockSizes;
+    std::size_t block = 0;
+    std::size_t offset = 0;
+};
+
+void *linearAllocate(LinearAllocator &allocator, std::size_t size, std::size_t alignment);
+void resetLinearAllocator(LinearAllocator &allocator);
+
+enum class CommandType : std::uint8_t {
+    BIND_PROGRAM, BIND_VERTEX_ARRAY, BIND_TEXTURE, SET_MATERIAL, SET_UNIFORM, BIND_UNIFORM_BLOCK, DRAW
+};
+
+// Every command starts with this header, the payload follows it in the same allocation
+struct CommandHeader {
+    CommandType type;
+    CommandHeader *next;
+};
+
+// Commands recorded by one thread, without touching GL. State behaves like GL within a buffer: binds stick
+// until replaced, uniforms stay set until the program changes, and every buffer starts from nothing bound.
+struct CommandBuffer {
+    LinearAllocator memory;
+    CommandHeader *first = nullptr;
+    CommandHeader *last = nullptr;
+    std::size_t commandCount = 0;
+};
+
+void resetCommandBuffer(CommandBuffer &buffer);
+
+void recordBindProgram(CommandBuffer &buffer, unsigned int program);
+void recordBindVertexArray(CommandBuffer &buffer, unsigned int vertexArray);
+void recordBindTexture(CommandBuffer &buffer, unsigned int texture);
+void recordSetMaterial(CommandBuffer &buffer, unsigned int material);
+void recordSetUniform(CommandBuffer &buffer, const DrawUniform &uniform);
+void recordBindUniformBlock(CommandBuffer &buffer, const UniformBlockRange &block);
+// The draw commands are copied into the buffer, the span only has to live for the call
+void recordDraw(CommandBuffer &buffer, RenderPass pass, float depth,
+                std::span<const DrawElementsIndirectCommand> drawCommands);
+
+// One command buffer per worker thread, reused from frame to frame
+struct CommandRecorder {
+    std::vector<CommandBuffer> buffers;
+};
+
+// Splits [0, count) into contiguous ranges, at least minPerThread items each, and records every range into
+// its own buffer as a job. Buffers past the ones used this frame are left empty.
+void recordCommandsParallel(CommandRecorder &recorder, std::size_t count, std::size_t minPerThread,
+                            const std::function<void(CommandBuffer &, std::size_t, std::size_t)> &record);
+
+// GL thread side: replays the buffers, in order, as render queue submissions. The radix sort is stable so
+// draws with equal keys keep the buffer order and the frame does not depend on thread timing.
+void submitCommandBuffers(RenderQueue &queue, std::span<const CommandBuffer> buffers);
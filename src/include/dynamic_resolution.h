@@ -0,0 +1,38 @@
+#pragma once
+
+#include <gpu_timer.h>
+
+// Renders the scene into an offscreen framebuffer at a fraction of the window's resolution and upscales it with a
+// linear blit. The fraction follows the measured GPU time of the scene: it drops quickly when a frame goes over
+// budget and climbs back slowly once there is headroom again, so the frame time stays level under load. The
+// framebuffer is allocated at maxScale times the window size and rendered into partially, a new scale never
+// reallocates it. Its color is RGBA16F so HDR values survive into post-processing.
+struct DynamicResolution {
+    float budgetMilliseconds = 12.0f;
+    float minScale = 0.5f;
+    float maxScale = 1.0f;
+    float scale = 1.0f;                // per axis
+    double gpuMilliseconds = 0.0;      // smoothed scene time, 0 until the first measurement
+    int outputWidth = 0;
+    int outputHeight = 0;
+    int renderWidth = 0;
+    int renderHeight = 0;
+
+    int allocatedWidth = 0;
+    int allocatedHeight = 0;
+    unsigned int framebuffer = 0;
+    unsigned int colorTexture = 0;
+    unsigned int depthBuffer = 0;
+    GpuTimer timer;
+};
+
+void initDynamicResolution(DynamicResolution &resolution, float budgetMilliseconds);
+void destroyDynamicResolution(DynamicResolution &resolution);
+
+// Picks this frame's scale and render size, before anything that depends on them is recorded
+void updateDynamicResolution(DynamicResolution &resolution, int outputWidth, int outputHeight);
+// Binds the offscreen framebuffer with the viewport set to the render size and starts timing the scene
+void beginDynamicResolution(DynamicResolution &resolution);
+// Upscales into targetFramebuffer (the window's by default), then binds the default framebuffer with the window's
+// viewport
+void endDynamicResolution(DynamicResolution &resolution, unsigned int targetFramebuffer = 0);
@@ -0,0 +1,154 @@
+#pragma once
+
+#include <job_system.h>
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <type_traits>
+#include <unordered_map>
+#include <vector>
+
+// Archetype based entity-component system. Entities with the same set of components share an archetype, which
+// stores every component in its own tightly packed column (structure of arrays), so a system is a plain loop over
+// a few contiguous arrays. Components are trivially copyable values; moving an entity between archetypes and
+// removing one (swap with the last row) are memcpys.
+
+constexpr std::size_t MAX_COMPONENTS = 64;
+constexpr std::size_t COLUMN_ALIGNMENT = 64; // cache line, and enough for any SIMD load
+
+using ComponentId = std::uint32_t;
+using ComponentMask = std::uint64_t;
+
+struct Entity {
+    std::uint32_t index;
+    std::uint32_t generation; // bumped when the index is recycled, stale handles stop resolving
+
+    bool operator==(const Entity &) const = default;
+};
+
+constexpr Entity NULL_ENTITY{~0u, 0};
+
+struct ComponentColumn {
+    ComponentId id;
+    std::size_t size;
+    std::byte *data;
+};
+
+struct Archetype {
+    ComponentMask mask = 0;
+    std::vector<ComponentColumn> columns; // in component id order
+    std::uint8_t columnOf[MAX_COMPONENTS];  // component id -> column, 0xFF when absent
+    std::vector<Entity> entities;          // row -> entity
+    std::size_t capacity = 0;
+
+    Archetype() = default;
+    Archetype(const Archetype &) = delete;
+    Archetype &operator=(const Archetype &) = delete;
+    ~Archetype();
+};
+
+struct EntityRecord {
+    Archetype *archetype;
+    std::uint32_t row;
+    std::uint32_t generation;
+};
+
+struct World {
+    std::vector<std::unique_ptr<Archetype>> archetypes;
+    std::unordered_map<ComponentMask, Archetype *> archetypeByMask;
+    std::vector<EntityRecord> records;
+    std::vector<std::uint32_t> freeIndices;
+};
+
+// Component ids are handed out on first use, in whatever order the types are first seen. Column storage is
+// aligned to COLUMN_ALIGNMENT, which covers the alignment of every component.
+ComponentId registerComponent(std::size_t size);
+
+// const T names the same component as T, systems use it for the columns they only read
+template<typename T>
+ComponentId componentId() {
+    if constexpr (std::is_const_v<T>) {
+        return componentId<std::remove_const_t<T>>();
+    } else {
+        static_assert(std::is_trivially_copyable_v<T>, "components are moved around with memcpy");
+        static_assert(alignof(T) <= COLUMN_ALIGNMENT, "component alignment above the column alignment");
+        static const ComponentId id = registerComponent(sizeof(T));
+        return id;
+    }
+}
+
+template<typename... Ts>
+ComponentMask componentMask() {
+    return ((ComponentMask{1} << componentId<Ts>()) | ... | ComponentMask{0});
+}
+
+// New entities start with zeroed components
+Entity createEntity(World &world, ComponentMask mask);
+// Bulk creation straight into one archetype, appending the handles to `entities` when given
+void createEntities(World &world, ComponentMask mask, std::size_t count, std::vector<Entity> *entities = nullptr);
+void destroyEntity(World &world, Entity entity);
+bool isAlive(const World &world, Entity entity);
+
+// Moves the entity to the archetype of `mask`, keeping the components both have and zeroing the new ones
+void setComponentMask(World &world, Entity entity, ComponentMask mask);
+
+// nullptr when the entity is dead or does not have the component
+void *componentData(World &world, Entity entity, ComponentId id);
+
+Archetype &archetypeFor(World &world, ComponentMask mask);
+
+std::size_t entityCount(const World &world);
+
+template<typename T>
+T *getComponent(World &world, Entity entity) {
+    return static_cast<T *>(componentData(world, entity, componentId<T>()));
+}
+
+// The entity must be alive
+template<typename T>
+T &addComponent(World &world, Entity entity, const T &value = {}) {
+    const EntityRecord &record = world.records[entity.index];
+    setComponentMask(world, entity, record.archetype->mask | componentMask<T>());
+    T *component = getComponent<T>(world, entity);
+    *component = value;
+    return *component;
+}
+
+template<typename T>
+void removeComponent(World &world, Entity entity) {
+    const EntityRecord &record = world.records[entity.index];
+    setComponentMask(world, entity, record.archetype->mask & ~componentMask<T>());
+}
+
+template<typename T>
+T *column(Archetype &archetype) {
+    return reinterpret_cast<T *>(archetype.columns[archetype.columnOf[componentId<T>()]].data);
+}
+
+// Calls fn(count, Ts *...) once per archetype that has every component in Ts, with the columns of that archetype
+template<typename... Ts, typename Fn>
+void forEach(World &world, Fn &&fn) {
+    const ComponentMask mask = componentMask<Ts...>();
+    for (const auto &archetype : world.archetypes) {
+        if ((archetype->mask & mask) == mask && !archetype->entities.empty()) {
+            fn(archetype->entities.size(), column<Ts>(*archetype)...);
+        }
+    }
+}
+
+// Same as forEach, with every archetype split into batches of at least minBatchSize rows run as jobs. fn gets
+// the batch's row count and its columns offset to the first row, so it must not add or remove entities.
+template<typename... Ts, typename Fn>
+void parallelForEach(World &world, std::size_t minBatchSize, Fn &&fn) {
+    const ComponentMask mask = componentMask<Ts...>();
+    for (const auto &archetype : world.archetypes) {
+        if ((archetype->mask & mask) != mask || archetype->entities.empty()) {
+            continue;
+        }
+        Archetype &current = *archetype;
+        parallelFor(current.entities.size(), minBatchSize, [&](std::size_t begin, std::size_t end) {
+            fn(end - begin, (column<Ts>(current) + begin)...);
+        });
+    }
+}
@@ -0,0 +1,27 @@
+#pragma once
+
+#include <cstdint>
+
+// Fixed-timestep simulation clock: real time is accumulated and consumed in whole steps, so the simulation
+// advances the same way whatever the frame rate, and rendering blends the last two states by alpha().
+struct FixedTimestep {
+    double step;            // seconds per simulation step
+    unsigned int maxSteps;  // per frame; past that the backlog is dropped instead of caught up (spiral of death)
+    bool lockstep = false;  // exactly one step per frame, ignoring real time (deterministic benchmark runs)
+
+    double accumulator = 0.0;
+    double lastTime = 0.0;
+    bool started = false;
+    std::uint64_t steps = 0; // simulation time is steps * step
+    std::uint64_t droppedSteps = 0;
+};
+
+FixedTimestep makeFixedTimestep(double hz, unsigned int maxSteps = 8);
+
+// Feeds the current real time in seconds, returns how many steps to simulate this frame
+unsigned int advanceFixedTimestep(FixedTimestep &clock, double now);
+
+// Where the real time lies between the previous and the latest simulated state, in [0, 1) (1 in lockstep)
+float interpolationAlpha(const FixedTimestep &clock);
+
+double simulationTime(const FixedTimestep &clock);
@@ -0,0 +1,82 @@
+#pragma once
+
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <fstream>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <vector>
+
+// Captures every rendered frame without stalling the pipeline: glReadPixels goes into a ring of pixel buffer
+// objects and each one is only mapped SLOTS frames later, when the GPU has long finished the copy. The mapped
+// pixels are copied into a pooled frame and handed to encoder threads, which write one PNG per frame or append
+// to a YUV4MPEG2 (.y4m) stream in frame order.
+
+enum class CaptureFormat {
+    PNG, Y4M
+};
+
+struct FrameCaptureStats {
+    std::uint64_t captured = 0;       // read back and queued for encoding
+    std::uint64_t encoded = 0;
+    std::uint64_t dropped = 0;        // the framebuffer no longer had the capture's size
+    std::uint64_t readbackStalls = 0; // a readback was not done yet when its buffer came round again
+    std::uint64_t encoderStalls = 0;  // every pooled frame was still waiting for the encoders
+    std::uint64_t bytesWritten = 0;
+    double renderThreadMilliseconds = 0.0; // spent inside captureFrame, what capture costs the frame rate
+    double encodeMilliseconds = 0.0;       // summed over the encoder threads
+};
+
+// Bottom-up RGBA rows, as glReadPixels returns them
+struct CapturedFrame {
+    std::uint64_t index = 0;
+    std::vector<unsigned char> pixels;
+};
+
+struct FrameCapture {
+    static constexpr std::size_t SLOTS = 3;      // readbacks in flight
+    static constexpr std::size_t MAX_FRAMES = 8; // frames read back but not encoded yet
+
+    CaptureFormat format = CaptureFormat::PNG;
+    std::string output; // the .y4m file, or the prefix of the numbered PNGs
+    int width = 0;
+    int height = 0;
+
+    // Render thread only
+    unsigned int pixelBuffers[SLOTS] = {};
+    void *fences[SLOTS] = {}; // GLsync per buffer, set when its readback was issued
+    std::uint64_t issued = 0;
+
+    // Shared with the encoders, under mutex
+    std::mutex mutex;
+    std::condition_variable condition;
+    std::deque<std::unique_ptr<CapturedFrame>> queue;
+    std::vector<std::unique_ptr<CapturedFrame>> freeFrames;
+    std::size_t allocatedFrames = 0;
+    std::uint64_t nextWrite = 0; // the .y4m stream takes frames strictly in order
+    bool stopping = false;
+    FrameCaptureStats stats;
+
+    std::ofstream video;
+    std::vector<std::thread> encoders;
+};
+
+// Format from the output's extension: .y4m makes a video stream, anything else numbered PNGs
+int initFrameCapture(FrameCapture &capture, std::string_view output, int width, int height, int framesPerSecond = 60,
+                     std::size_t encoderThreads = 2);
+// Render thread, after the frame was drawn and before the swap. Reads back the back buffer; frames of another size
+// than the capture are dropped.
+void captureFrame(FrameCapture &capture, int framebufferWidth, int framebufferHeight);
+// Collects the readbacks still in flight, waits for the encoders and closes the output
+void finishFrameCapture(FrameCapture &capture);
+
+FrameCaptureStats frameCaptureStats(FrameCapture &capture);
+
+// Encoders, exposed for offline use. Pixels are bottom-up RGBA rows as read back from GL.
+void encodePng(const unsigned char *pixels, int width, int height, std::vector<unsigned char> &out);
+void encodeYuv420(const unsigned char *pixels, int width, int height, std::vector<unsigned char> &out);
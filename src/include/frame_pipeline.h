@@ -0,0 +1,41 @@
+#pragma once
+
+#include <condition_variable>
+#include <cstdint>
+#include <mutex>
+
+// Everything the render thread needs from the simulation for one frame. Plain values only: the main thread
+// overwrites the other slot while this one is being rendered.
+struct FramePacket {
+    std::uint64_t frameIndex;
+    int framebufferWidth;
+    int framebufferHeight;
+    double time; // simulation time the interpolated state corresponds to, in seconds
+    float shift;
+    float offset[2];
+};
+
+// Double-buffered hand-off between the main thread (input, simulation) and the render thread (GL). The main
+// thread fills frame N+1 while frame N is submitted, and blocks only when it gets two frames ahead.
+struct FramePipeline {
+    FramePacket packets[2] = {};
+    std::uint64_t published = 0; // packets handed over by the main thread
+    std::uint64_t consumed = 0;  // packets the render thread is done with
+    bool closed = false;
+
+    std::mutex mutex;
+    std::condition_variable condition;
+};
+
+// Main thread: the slot to fill for the next frame, waiting for the render thread to free it.
+// Returns nullptr once the pipeline is closed.
+FramePacket *beginFramePacket(FramePipeline &pipeline);
+void publishFramePacket(FramePipeline &pipeline);
+
+// Render thread: the oldest published packet, nullptr once the pipeline is closed. Release it as soon as its
+// data has been consumed (before the swap) so the main thread can move on.
+const FramePacket *acquireFramePacket(FramePipeline &pipeline);
+void releaseFramePacket(FramePipeline &pipeline);
+
+// Either side: wakes up and stops the other one
+void closeFramePipeline(FramePipeline &pipeline);
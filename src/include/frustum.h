@@ -0,0 +1,40 @@
+#pragma once
+
+#include <vector_math.h>
+
+#include <cstddef>
+#include <cstdint>
+
+struct Frustum {
+    float planes[6][4]; // normalized, inside when dot(plane.xyz, p) + plane.w >= 0
+};
+
+// Gribb/Hartmann plane extraction from a column-major view projection matrix
+Frustum extractFrustum(const float viewProjection[16]);
+
+struct Aabb {
+    vec3 min;
+    vec3 max;
+};
+
+Aabb mergeAabb(const Aabb &a, const Aabb &b);
+float surfaceArea(const Aabb &box);
+bool containsAabb(const Aabb &outer, const Aabb &inner);
+// Bounds of the transformed box (Arvo's method, no corner enumeration)
+Aabb transformAabb(const mat4 &m, const Aabb &box);
+
+enum class Containment : std::uint8_t {
+    OUTSIDE, INTERSECTS, INSIDE
+};
+
+// Scalar test of one box
+Containment classifyBox(const Frustum &frustum, const Aabb &box);
+
+// Boxes as structure-of-arrays centers and half extents, the form the wide test loads
+struct BoxArrays {
+    const float *centerX, *centerY, *centerZ;
+    const float *extentX, *extentY, *extentZ;
+};
+
+// Classifies `count` boxes, floatN::WIDTH of them per plane test
+void classifyBoxes(const Frustum &frustum, const BoxArrays &boxes, Containment *results, std::size_t count);
@@ -0,0 +1,24 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+// GPU time of a span of commands, from a pair of GL_TIMESTAMP queries (core since 3.3). Timestamps rather than
+// GL_TIME_ELAPSED so timers can nest. Results arrive a few frames late and are polled without ever blocking; a
+// span begun while all LATENCY query pairs are still in flight is simply not measured.
+struct GpuTimer {
+    static constexpr std::size_t LATENCY = 4;
+
+    unsigned int queries[LATENCY][2] = {}; // begin and end timestamp per slot
+    std::uint64_t begun = 0;               // spans started
+    std::uint64_t resolved = 0;            // spans whose result was read back
+    bool measuring = false;                // the current span got a slot
+};
+
+void initGpuTimer(GpuTimer &timer);
+void destroyGpuTimer(GpuTimer &timer);
+
+void beginGpuTimer(GpuTimer &timer);
+void endGpuTimer(GpuTimer &timer);
+// True when at least one span finished since the last poll, with the newest one's duration
+bool pollGpuTimer(GpuTimer &timer, double &milliseconds);
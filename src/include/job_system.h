@@ -0,0 +1,97 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <new>
+#include <type_traits>
+#include <utility>
+
+// Task based job system: one worker per core (the thread calling initJobSystem is worker 0), each with a
+// Chase-Lev deque. Workers pop their own jobs LIFO and steal FIFO from the others when they run dry.
+// Jobs are plain tasks, not fibers: waiting on a counter runs other jobs on the waiting thread's stack
+// until the counter reaches zero, which is also how a job waits on the jobs it depends on.
+
+constexpr std::size_t JOB_DATA_SIZE = 40;
+constexpr std::size_t MAX_JOBS_PER_WORKER = 4096; // jobs in flight per submitting thread, power of two
+constexpr std::size_t MAX_ATTACHED_THREADS = 4;
+
+// Number of jobs still running; waiters see every side effect of the finished jobs
+struct JobCounter {
+    std::atomic<std::uint32_t> value{0};
+};
+
+// One cache line: the inline function storage, then the bookkeeping
+struct alignas(64) Job {
+    alignas(std::max_align_t) unsigned char data[JOB_DATA_SIZE];
+    void (*function)(Job &job);
+    JobCounter *counter;
+    std::atomic<bool> busy{false}; // set from allocation until the function returned
+};
+
+// workerCount 0 uses std::thread::hardware_concurrency(). Without a running job system every helper
+// below runs its work inline on the calling thread.
+void initJobSystem(std::size_t workerCount = 0);
+void shutdownJobSystem();
+
+// Lets a thread the job system did not start (a render thread) submit and help with jobs. It gets its own
+// deque that the workers steal from, but runs jobs only while waiting. False when every slot is taken.
+bool attachJobThread();
+
+// Pool threads plus the initializing thread, 1 when the job system is not running
+std::size_t jobWorkerCount();
+
+// Low level submission: allocateJob returns a free slot of the calling thread's job ring, submitJob bumps the
+// counter and publishes the job. allocateJob returns nullptr when the calling thread is not a worker or already
+// has MAX_JOBS_PER_WORKER jobs in flight; the caller then runs the work inline.
+Job *allocateJob();
+void submitJob(Job &job, JobCounter &counter);
+
+// Runs other jobs until the counter drops to zero
+void waitForCounter(JobCounter &counter);
+
+// Queues fn() as a job; fn is stored inline in the job so it must be small and trivially destructible
+// (capture by reference)
+template<typename Fn>
+void runJob(Fn &&fn, JobCounter &counter) {
+    using Function = std::decay_t<Fn>;
+    static_assert(sizeof(Function) <= JOB_DATA_SIZE, "job function too big, capture by reference");
+    static_assert(std::is_trivially_destructible_v<Function>, "job functions are never destroyed");
+
+    Job *job = allocateJob();
+    if (!job) {
+        fn();
+        return;
+    }
+    new(job->data) Function(std::forward<Fn>(fn));
+    job->function = [](Job &self) {
+        (*std::launder(reinterpret_cast<Function *>(self.data)))();
+    };
+    submitJob(*job, counter);
+}
+
+// Calls fn(batch) for every batch in [0, batchCount), batch 0 on the calling thread, and returns once all ran
+template<typename Fn>
+void runBatches(std::size_t batchCount, Fn &&fn) {
+    if (batchCount == 0) {
+        return;
+    }
+    JobCounter counter;
+    for (std::size_t batch = 1; batch < batchCount; batch++) {
+        runJob([&fn, batch] { fn(batch); }, counter);
+    }
+    fn(std::size_t{0});
+    waitForCounter(counter);
+}
+
+// Splits [0, count) into contiguous ranges of at least minBatchSize items, a few per worker so stealing can
+// even out uneven ranges, and calls fn(begin, end) on each
+template<typename Fn>
+void parallelFor(std::size_t count, std::size_t minBatchSize, Fn &&fn) {
+    const std::size_t maxBatches = jobWorkerCount() * 4;
+    std::size_t batchCount = count / (minBatchSize ? minBatchSize : 1);
+    batchCount = batchCount < 1 ? 1 : (batchCount > maxBatches ? maxBatches : batchCount);
+    runBatches(batchCount, [&fn, count, batchCount](std::size_t batch) {
+        fn(count * batch / batchCount, count * (batch + 1) / batchCount);
+    });
+}
@@ -0,0 +1,34 @@
+#pragma once
+
+#include <string>
+#include <string_view>
+#include <vector>
+
+// Minimal JSON document model, enough for glTF and the small config files we read.
+struct JsonValue {
+    enum class Type {
+        NUL, BOOLEAN, NUMBER, STRING, ARRAY, OBJECT
+    };
+
+    Type type = Type::NUL;
+    bool boolean = false;
+    double number = 0.0;
+    std::string string;
+    std::vector<JsonValue> items;   // array elements or object values
+    std::vector<std::string> keys;  // object keys, parallel to items
+
+    [[nodiscard]] const JsonValue *find(std::string_view key) const;
+    [[nodiscard]] std::size_t size() const { return items.size(); }
+    [[nodiscard]] const JsonValue &operator[](std::size_t index) const { return items[index]; }
+
+    [[nodiscard]] double asNumber(double fallback = 0.0) const;
+    [[nodiscard]] int asInt(int fallback = 0) const;
+    [[nodiscard]] std::string_view asString() const;
+
+    // Shortcuts for looking up a member and reading it in one go
+    [[nodiscard]] int intMember(std::string_view key, int fallback = 0) const;
+    [[nodiscard]] double numberMember(std::string_view key, double fallback = 0.0) const;
+    [[nodiscard]] std::string_view stringMember(std::string_view key) const;
+};
+
+int parseJson(std::string_view text, JsonValue &root);
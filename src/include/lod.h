@@ -0,0 +1,37 @@
+#pragma once
+
+#include <mesh.h>
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+constexpr unsigned int MAX_MESH_LODS = 8;
+
+// One level of detail: a range of the shared index buffer and the geometric error (object space distance)
+// introduced by simplifying down to it. LOD 0 is the original mesh with zero error.
+struct MeshLod {
+    std::uint32_t firstIndex;
+    std::uint32_t indexCount;
+    float error;
+    std::uint32_t reserved;
+};
+
+// Quadric error metric edge collapse. Vertices only ever collapse onto one of their neighbours so the result
+// keeps referencing the existing vertex buffer; boundary and attribute seam vertices are locked.
+// Stops when `out` has at most targetIndexCount indices or the next collapse would exceed targetError.
+// Returns the error of the simplified mesh.
+float simplifyMesh(const MeshData &mesh, const unsigned int *indices, std::size_t indexCount,
+                   std::size_t targetIndexCount, float targetError, std::vector<unsigned int> &out);
+
+// Appends successively simplified LODs (each `ratio` of the previous one) after the existing indices, which
+// become LOD 0. Stops early when a step no longer removes at least 10% of the triangles.
+void buildLodChain(MeshData &mesh, std::vector<MeshLod> &lods, unsigned int maxLods = 5, float ratio = 0.5f);
+
+// Pixels per object space unit at distance 1: viewportHeight / (2 * tan(fovY / 2)) for perspective,
+// viewportHeight / orthoHeight with a distance of 1 for orthographic projections
+float projectionScale(float viewportHeight, float fovY);
+
+// Picks the coarsest LOD whose error, projected at `distance`, stays under pixelThreshold
+unsigned int selectLod(const MeshLod *lods, std::size_t lodCount, float distance, float projectionScale,
+                       float pixelThreshold = 1.0f);
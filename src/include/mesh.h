@@ -0,0 +1,57 @@
+#pragma once
+
+#include <resources.h>
+#include <vertex_layout.h>
+
+#include <cstdint>
+#include <string_view>
+#include <vector>
+
+struct Vertex {
+    float position[3];
+    float normal[3];
+    float uv[2];
+    float color[3];
+};
+
+struct MeshData {
+    std::vector<Vertex> vertices;
+    std::vector<unsigned int> indices;
+};
+
+struct Meshlet;
+struct MeshLod;
+
+// Importers. Both parse on every hardware thread and fill `mesh` with a deduplicated, indexed triangle list.
+// Missing normals are generated, missing colours default to white.
+int loadObj(std::string_view path, MeshData &mesh);
+int loadGltf(std::string_view path, MeshData &mesh); // .gltf (embedded or external buffers) and .glb
+int importMesh(std::string_view path, MeshData &mesh); // picks the importer from the file extension
+
+// Binary mesh cache, stored next to the source as "<source>.mcache". The header records the source size and
+// modification time so a stale cache is rebuilt. Vertices are stored already packed in the requested
+// VertexFormat, followed by the meshlet table (see meshlet.h) and the LOD table (see lod.h). Sources and caches are
+// looked up like any other resource (see resources.h), so an opened cache is a read-only view into the mapped file
+// or the mounted pack whose vertex and index pointers can be handed directly to glBufferData.
+struct MeshCacheView {
+    ResourceData resource;
+    VertexLayout layout;
+    MeshBounds bounds{};
+    const unsigned char *vertexData = nullptr;
+    std::uint32_t vertexCount = 0;
+    const unsigned int *indices = nullptr;
+    std::uint32_t indexCount = 0;
+    const Meshlet *meshlets = nullptr; // cover LOD 0 only
+    std::uint32_t meshletCount = 0;
+    const MeshLod *lods = nullptr;
+    std::uint32_t lodCount = 0;
+};
+
+int writeMeshCache(std::string_view cachePath, std::string_view sourcePath, const MeshData &mesh,
+                   const std::vector<Meshlet> &meshlets, const std::vector<MeshLod> &lods,
+                   const VertexFormat &format);
+int openMeshCache(std::string_view cachePath, std::string_view sourcePath, const VertexFormat &format,
+                  MeshCacheView &view);
+
+// Opens the cache for `path`, importing the source and (re)writing the cache first when needed
+int loadMesh(std::string_view path, const VertexFormat &format, MeshCacheView &view);
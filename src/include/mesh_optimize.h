@@ -0,0 +1,40 @@
+#pragma once
+
+#include <mesh.h>
+
+#include <cstddef>
+#include <iosfwd>
+#include <vector>
+
+// Post-transform cache statistics of an index buffer, simulated with a FIFO cache
+struct VertexCacheStats {
+    float acmr = 0.0f; // average cache miss ratio: transformed vertices per triangle (0.5 is ideal on big grids)
+    float atvr = 0.0f; // average transform to vertex ratio: transformed vertices per unique vertex (1 is ideal)
+};
+
+struct MeshOptimizeReport {
+    VertexCacheStats before;
+    VertexCacheStats after;
+    std::size_t triangleCount = 0;
+    std::size_t vertexCount = 0;
+};
+
+constexpr unsigned int DEFAULT_CACHE_SIZE = 16;
+
+VertexCacheStats analyzeVertexCache(const unsigned int *indices, std::size_t indexCount, std::size_t vertexCount,
+                                    unsigned int cacheSize = DEFAULT_CACHE_SIZE);
+
+// Reorders triangles for the post-transform vertex cache (Tom Forsyth's linear-speed algorithm)
+void optimizeVertexCache(std::vector<unsigned int> &indices, std::size_t vertexCount);
+
+// Splits a cache optimized index buffer into clusters and sorts them so outward facing clusters draw first.
+// `threshold` is how much ACMR we are willing to lose to get smaller (better sortable) clusters, 1.05 = 5%.
+void optimizeOverdraw(std::vector<unsigned int> &indices, const std::vector<Vertex> &vertices, float threshold = 1.05f);
+
+// Reorders vertices in first use order so fetches walk memory linearly; unreferenced vertices are dropped
+void optimizeVertexFetch(MeshData &mesh);
+
+// Runs the three passes above in order, `report` may be null
+void optimizeMesh(MeshData &mesh, MeshOptimizeReport *report);
+
+std::ostream &operator<<(std::ostream &stream, const MeshOptimizeReport &report);
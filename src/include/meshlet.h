@@ -0,0 +1,48 @@
+#pragma once
+
+#include <frustum.h>
+#include <mesh.h>
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+constexpr unsigned int MESHLET_MAX_VERTICES = 64;
+constexpr unsigned int MESHLET_MAX_TRIANGLES = 124;
+
+// A cluster of triangles that is culled as a unit. Its triangles are contiguous in the mesh index buffer
+// and still reference the shared vertex buffer, so a surviving meshlet is exactly one indirect draw.
+struct Meshlet {
+    std::uint32_t firstIndex;
+    std::uint32_t indexCount;
+    std::uint32_t vertexCount;
+    float center[3];
+    float radius;
+    float coneAxis[3];
+    float coneCutoff; // sin of the normal cone half angle, 1 disables backface culling
+};
+
+// Layout mandated by glMultiDrawElementsIndirect
+struct DrawElementsIndirectCommand {
+    std::uint32_t count;
+    std::uint32_t instanceCount;
+    std::uint32_t firstIndex;
+    std::int32_t baseVertex;
+    std::uint32_t baseInstance;
+};
+
+struct MeshletCullStats {
+    std::size_t tested = 0;
+    std::size_t frustumCulled = 0;
+    std::size_t backfaceCulled = 0;
+    std::size_t draws = 0; // after merging meshlets that are adjacent in the index buffer
+};
+
+// Greedily cuts the index buffer, in its current (ideally cache optimized) order, into meshlets
+void buildMeshlets(const MeshData &mesh, std::vector<Meshlet> &meshlets);
+
+// Culls meshlets [begin, end) against the frustum and their normal cone, appending one draw per run of
+// consecutive survivors. Safe to call concurrently on disjoint ranges with separate outputs.
+void cullMeshlets(const Meshlet *meshlets, std::size_t begin, std::size_t end, const Frustum &frustum,
+                  const float cameraPosition[3], std::vector<DrawElementsIndirectCommand> &commands,
+                  MeshletCullStats &stats);
@@ -0,0 +1,45 @@
+#pragma once
+
+#include <frustum.h>
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+// Software occlusion culling. Occluders are rasterized on the CPU into a small depth buffer, which is reduced into
+// a hierarchical-Z pyramid where every texel holds the farthest depth of the four below it. An object is hidden
+// when the nearest depth of its screen space bounds lies behind all the pyramid texels those bounds overlap, read
+// at the level where they cover at most two texels across.
+
+constexpr int OCCLUSION_WIDTH = 256;
+constexpr int OCCLUSION_HEIGHT = 128;
+
+struct OcclusionStats {
+    std::size_t occluderTriangles = 0;
+    std::size_t tested = 0;
+    std::size_t occluded = 0;
+};
+
+struct OcclusionBuffer {
+    int width = 0;
+    int height = 0;
+    // levels[0] is the rasterized depth, window depth in [0, 1] with 1 where nothing was drawn; row 0 at the bottom
+    std::vector<std::vector<float>> levels;
+    std::vector<int> levelWidths;
+    std::vector<int> levelHeights;
+    OcclusionStats stats;
+};
+
+// Clears the buffer for a new frame, (re)allocating the pyramid when the size changes
+void beginOcclusionBuffer(OcclusionBuffer &buffer, int width = OCCLUSION_WIDTH, int height = OCCLUSION_HEIGHT);
+
+// Rasterizes indexed triangles (positions as xyz floats) transformed by modelViewProjection. Triangles crossing the
+// near plane are dropped, which can only make the buffer less occluding.
+void rasterizeOccluder(OcclusionBuffer &buffer, const mat4 &modelViewProjection, const float *positions,
+                       const unsigned int *indices, std::size_t indexCount);
+
+// Reduces level 0 into the rest of the pyramid, call after the last occluder
+void buildDepthPyramid(OcclusionBuffer &buffer);
+
+// `box` is in the space viewProjection maps to clip space. Boxes crossing the near plane are never occluded.
+bool isOccluded(OcclusionBuffer &buffer, const mat4 &viewProjection, const Aabb &box);
@@ -0,0 +1,62 @@
+#pragma once
+
+#include <render_graph.h>
+#include <shader.h>
+
+#include <cstddef>
+
+struct PostProcessSettings {
+    float exposure = 1.0f;
+
+    bool bloom = true;
+    int bloomDivisor = 4;          // the blur runs at 1/2 or 1/4 of the input's resolution
+    float bloomThreshold = 0.9f;   // in linear scene color
+    float bloomKnee = 0.4f;
+    float bloomIntensity = 0.5f;
+
+    // Color grading, applied after tonemapping
+    float lift[3] = {0.0f, 0.0f, 0.0f};
+    float gamma[3] = {1.0f, 1.0f, 1.0f};
+    float gain[3] = {1.0f, 1.0f, 1.0f};
+    float saturation = 1.0f;
+    float contrast = 1.0f;
+
+    bool fxaa = true;
+};
+
+// A linked post pass with its uniform locations looked up once
+struct PostProgram {
+    static constexpr std::size_t UNIFORM_COUNT = 9;
+
+    unsigned int program = 0;
+    int uniforms[UNIFORM_COUNT] = {};
+};
+
+// HDR scene color in, display color out through a chain of fullscreen passes: a bright pass and downsample to
+// half size (optionally again to quarter size) with a separable blur for bloom, then bloom composite, tonemap and
+// color grading, then FXAA. The passes go into the frame's render graph, which allocates their intermediate
+// targets and times them.
+struct PostProcess {
+    PostProcessSettings settings;
+
+    ShaderVariants downsampleShaders;
+    ShaderVariants blurShaders;
+    ShaderVariants tonemapShaders;
+    ShaderVariants fxaaShaders;
+    PostProgram brightPass;
+    PostProgram downsample;
+    PostProgram blur;
+    PostProgram tonemap;
+    PostProgram tonemapBloom;
+    PostProgram fxaa;
+
+    unsigned int vertexArray = 0; // empty, the fullscreen triangle comes from gl_VertexID
+};
+
+// Compiles every pass up front so toggling a setting never stalls a frame
+int initPostProcess(PostProcess &post, ShaderIncludeCache &includes);
+void destroyPostProcess(PostProcess &post);
+
+// Adds the chain reading the scene texture and writing output, both of the same size. The bloom passes are always
+// added and culled by the graph when bloom is off.
+void addPostProcessPasses(PostProcess &post, RenderGraph &graph, GraphTexture scene, GraphTexture output);
@@ -0,0 +1,27 @@
+#pragma once
+
+#include <cstdint>
+#include <ostream>
+#include <string>
+#include <string_view>
+#include <vector>
+
+// Named timings in milliseconds, recorded by whoever measures them (GPU spans arrive a few frames late) and
+// summarized on demand. Counters are found by name; there are a handful per frame, a linear search is enough.
+struct ProfileCounter {
+    std::string name;
+    double last = 0.0;
+    double total = 0.0;
+    double max = 0.0;
+    std::uint64_t samples = 0;
+};
+
+struct Profiler {
+    std::vector<ProfileCounter> counters; // in the order they were first recorded
+};
+
+void recordProfileSample(Profiler &profiler, std::string_view name, double milliseconds);
+// nullptr until the first sample of that name
+const ProfileCounter *findProfileCounter(const Profiler &profiler, std::string_view name);
+// One line per counter: average, maximum and last sample
+void printProfile(const Profiler &profiler, std::ostream &out);
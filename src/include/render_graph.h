@@ -0,0 +1,102 @@
+#pragma once
+
+#include <gpu_timer.h>
+#include <profiler.h>
+#include <render_target.h>
+
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+using GraphTexture = std::uint32_t;
+using GraphPass = std::uint32_t;
+
+constexpr std::uint32_t GRAPH_NONE = ~0u;
+
+struct RenderGraph;
+
+// Called when the pass runs, with the framebuffer of its first written texture bound and the viewport covering it
+using GraphPassFunction = std::function<void(const RenderGraph &graph)>;
+
+struct RenderGraphTextureNode {
+    std::string name;
+    int width = 0;
+    int height = 0;
+    RenderTargetFormat format = RenderTargetFormat::RGBA8;
+    bool imported = false;
+    RenderTarget target;                // imported, or assigned for the execution
+    GraphPass producer = GRAPH_NONE;
+    std::uint32_t physical = GRAPH_NONE; // allocation it shares with other transients
+    std::uint32_t firstUse = 0;          // positions in the execution order
+    std::uint32_t lastUse = 0;
+};
+
+struct RenderGraphPassNode {
+    std::string name;
+    std::vector<GraphTexture> reads;
+    std::vector<GraphTexture> writes;
+    GraphPassFunction execute;
+    bool sideEffects = false; // kept even when nothing reads what it writes
+    bool culled = false;
+};
+
+struct RenderGraphStats {
+    std::size_t passes = 0;
+    std::size_t culledPasses = 0;
+    std::size_t transientTextures = 0;
+    std::size_t allocations = 0;      // transients after aliasing
+    std::size_t transientBytes = 0;   // if every transient had its own texture
+    std::size_t allocatedBytes = 0;
+};
+
+// The frame's passes and the textures flowing between them, rebuilt every frame. Each texture is written by
+// exactly one pass, so the reads and writes form a DAG: compiling culls the passes nothing visible depends on,
+// orders the rest topologically and lets transient textures whose lifetimes do not overlap share one allocation
+// from the RenderTargetPool. GL has no memory aliasing, sharing a texture object is the equivalent. Every pass
+// that runs is timed on the GPU and reported to the profiler under its name.
+struct RenderGraph {
+    struct Allocation {
+        int width;
+        int height;
+        RenderTargetFormat format;
+        std::uint32_t lastUse;
+        RenderTarget target;
+    };
+
+    std::vector<RenderGraphTextureNode> textures;
+    std::vector<RenderGraphPassNode> passes;
+    std::vector<GraphPass> order; // passes that survived culling, in execution order
+    std::vector<Allocation> allocations;
+    RenderGraphStats stats;
+    bool compiled = false;
+
+    std::vector<std::pair<std::string, GpuTimer>> timers; // by pass name, kept across frames
+};
+
+// Clears last frame's passes and textures
+void beginRenderGraph(RenderGraph &graph);
+void destroyRenderGraph(RenderGraph &graph);
+
+GraphTexture createGraphTexture(RenderGraph &graph, std::string_view name, int width, int height,
+                                RenderTargetFormat format);
+// A target owned outside the graph (the window is RenderTarget{0, 0, width, height}). Passes writing it are
+// never culled.
+GraphTexture importGraphTexture(RenderGraph &graph, std::string_view name, const RenderTarget &target);
+
+GraphPass addGraphPass(RenderGraph &graph, std::string_view name, GraphPassFunction execute);
+void readGraphTexture(RenderGraph &graph, GraphPass pass, GraphTexture texture);
+void writeGraphTexture(RenderGraph &graph, GraphPass pass, GraphTexture texture);
+void markGraphSideEffects(RenderGraph &graph, GraphPass pass);
+
+// Culls, orders and assigns allocations. -1 when a texture has two writers, is read but never written, or the
+// passes depend on each other in a cycle.
+int compileRenderGraph(RenderGraph &graph);
+// Runs the compiled passes, taking the allocations from the pool for the duration and giving them back after
+void executeRenderGraph(RenderGraph &graph, RenderTargetPool &targets, Profiler &profiler);
+
+// Valid while the graph executes
+const RenderTarget &graphTarget(const RenderGraph &graph, GraphTexture texture);
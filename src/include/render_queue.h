@@ -0,0 +1,104 @@
+#pragma once
+
+#include <meshlet.h>
+
+#include <cstddef>
+#include <cstdint>
+#include <span>
+#include <vector>
+
+enum class RenderPass : std::uint8_t {
+    SOLID = 0, TRANSLUCENT = 1, OVERLAY = 2
+};
+
+// Sort key layout, most significant bits first:
+//   solid, overlay: pass:4 | program:10 | material:12 | texture:12 | depth:24 (front to back) | unused:2
+//   translucent:    pass:4 | depth:24 (back to front) | program:10 | material:12 | texture:12 | unused:2
+// GL object names are small integers in practice, they are masked to their field.
+std::uint64_t makeSortKey(RenderPass pass, unsigned int program, unsigned int material, unsigned int texture,
+                          float depth);
+
+// A uniform value set either per material or per draw
+struct DrawUniform {
+    int location;
+    int components; // 1 to 4 floats
+    float value[4];
+};
+
+// A range of a uniform buffer bound to a block binding point (glBindBufferRange) for a draw
+struct UniformBlockRange {
+    unsigned int binding;
+    unsigned int buffer;
+    std::uint32_t offset;
+    std::uint32_t size;
+};
+
+// Block bindings the queue tracks, ranges bound at or above it are rejected rather than aliasing a tracked one
+constexpr unsigned int MAX_BLOCK_BINDINGS = 8;
+
+// Uniforms shared by every draw with the same material, only uploaded when the material changes
+struct Material {
+    std::vector<DrawUniform> uniforms;
+};
+
+// Payload of a submission; the ranges index into the queue's per-frame uniform, block and command arrays
+struct DrawItem {
+    unsigned int program;
+    unsigned int vertexArray;
+    unsigned int texture;
+    unsigned int material;
+    std::uint32_t firstUniform;
+    std::uint32_t uniformCount;
+    std::uint32_t firstBlock;
+    std::uint32_t blockCount;
+    std::uint32_t firstCommand;
+    std::uint32_t commandCount;
+};
+
+struct RenderQueueStats {
+    std::size_t draws = 0;
+    std::size_t stateChanges = 0;         // program + vertex array + texture + material binds actually issued
+    std::size_t unsortedStateChanges = 0; // what submission order would have cost
+    std::size_t programChanges = 0;
+    std::size_t vertexArrayChanges = 0;
+    std::size_t textureChanges = 0;
+    std::size_t materialChanges = 0;
+    std::size_t blockBinds = 0;
+};
+
+struct RenderQueue {
+    std::vector<Material> materials;
+
+    std::vector<std::uint64_t> keys;
+    std::vector<std::uint32_t> order;
+    std::vector<DrawItem> items;
+    std::vector<DrawUniform> uniforms;
+    std::vector<UniformBlockRange> blocks;
+    std::vector<DrawElementsIndirectCommand> commands;
+    RenderQueueStats stats;
+
+    unsigned int indirectBuffer = 0;
+    bool multiDrawIndirect = false;
+
+    // Radix sort scratch, kept between frames
+    std::vector<std::uint64_t> scratchKeys;
+    std::vector<std::uint32_t> scratchOrder;
+};
+
+void initRenderQueue(RenderQueue &queue);
+unsigned int addMaterial(RenderQueue &queue, Material material);
+
+// Clears last frame's submissions (materials persist)
+void beginRenderQueue(RenderQueue &queue);
+
+// Records one draw. `depth` is the normalized view depth in [0, 1] used for ordering within a state bucket.
+void submitDraw(RenderQueue &queue, RenderPass pass, float depth, unsigned int program, unsigned int vertexArray,
+                unsigned int texture, unsigned int material, std::span<const DrawUniform> drawUniforms,
+                std::span<const UniformBlockRange> drawBlocks,
+                std::span<const DrawElementsIndirectCommand> drawCommands);
+
+// LSD radix sort of the keys, 8 bits per pass, skipping passes where every key has the same byte
+void sortRenderQueue(RenderQueue &queue);
+
+// Replays the sorted submissions, binding state only when it differs from the previous draw
+void executeRenderQueue(RenderQueue &queue);
@@ -0,0 +1,46 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+enum class RenderTargetFormat {
+    RGBA8,
+    RGBA16F,
+    R11F_G11F_B10F, // HDR color at half the bandwidth of RGBA16F, no alpha
+};
+
+// A color texture with a framebuffer around it, sampled linearly and clamped to its edges
+struct RenderTarget {
+    unsigned int framebuffer = 0;
+    unsigned int texture = 0;
+    int width = 0;
+    int height = 0;
+    RenderTargetFormat format = RenderTargetFormat::RGBA8;
+};
+
+// Intermediate targets handed out by size and format. A released target goes back to the pool and is given to
+// the next pass asking for the same size and format, in this frame or a later one, so a chain of passes
+// allocates its textures once instead of every frame.
+struct RenderTargetPool {
+    struct Slot {
+        RenderTarget target;
+        bool inUse = false;
+        std::uint64_t lastUsedFrame = 0;
+    };
+
+    std::vector<Slot> slots;
+    std::uint64_t frame = 0;
+    std::size_t created = 0; // textures allocated over the pool's life
+};
+
+// Sizes are clamped to at least 1x1
+RenderTarget acquireRenderTarget(RenderTargetPool &pool, int width, int height, RenderTargetFormat format);
+void releaseRenderTarget(RenderTargetPool &pool, const RenderTarget &target);
+// Ends the pool's frame, freeing targets nothing acquired for idleFrames frames (sizes left behind by a resize)
+void trimRenderTargets(RenderTargetPool &pool, std::uint64_t idleFrames = 120);
+void destroyRenderTargetPool(RenderTargetPool &pool);
+
+std::size_t renderTargetBytes(int width, int height, RenderTargetFormat format);
+// Memory held by the pool's textures, in use or not
+std::size_t renderTargetPoolBytes(const RenderTargetPool &pool);
@@ -0,0 +1,53 @@
+#pragma once
+
+#include <mapped_file.h>
+
+#include <cstddef>
+#include <span>
+#include <string>
+#include <string_view>
+#include <vector>
+
+// Read-only view of the files under res/. Built with LEARN_OPENGL_EMBED_RESOURCES, shaders (includes expanded) and
+// small assets are compiled into the executable by tools/embed_resources.cpp and never read from disk. Next come the
+// entries of a mounted asset pack, then loose files next to the executable or in the working directory.
+
+struct EmbeddedResource {
+    std::string_view path; // as passed to readResource, "res/shaders/3colors.shader"
+    const unsigned char *data;
+    std::size_t size;
+};
+
+// Sorted by path; empty when resources are not embedded
+std::span<const EmbeddedResource> embeddedResources();
+const EmbeddedResource *findEmbeddedResource(std::string_view path);
+
+// The key resources are looked up by: forward slashes, no "." components, ".." folded into their parent
+std::string normalizeResourcePath(std::string_view path);
+
+// Loose files and the pack are looked for under the root first, then in the working directory. The application
+// sets the root to executableDirectory() so it runs from anywhere; the build tools leave it empty.
+std::string executableDirectory();
+void setResourceRoot(std::string_view directory);
+
+// Where a relative resource lives on disk. Files that exist in neither place go wherever their directory does, so
+// caches can be written back.
+std::string resourceFilePath(std::string_view path);
+
+// Serves the pack's entries from then on (see asset_pack.h). Call before loading starts, lookups are only safe from
+// several threads once it returned.
+int mountResourcePack(std::string_view packPath);
+
+// The bytes of one resource. Embedded resources and uncompressed pack entries are viewed in place and loose files
+// are mapped; only compressed pack entries are decompressed into `storage`.
+struct ResourceData {
+    std::span<const unsigned char> bytes;
+    std::vector<unsigned char> storage;
+    MappedFile file;
+};
+
+// Quiet when the resource does not exist, so callers can probe for optional files
+int openResource(std::string_view path, ResourceData &data);
+void closeResource(ResourceData &data);
+
+int readResource(std::string_view path, std::string &contents);
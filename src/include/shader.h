@@ -0,0 +1,95 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <initializer_list>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+// .shader files hold every stage of a program, each section starting with `#shader <stage>`, where stage is one of
+// vertex, tess_control, tess_evaluation, geometry, fragment or compute. A compute section makes a compute program
+// and cannot be combined with the others. On top of GLSL they understand two directives:
+//   #include "file.glsl"   pastes a file, resolved relative to the file containing the directive
+//   #keywords NAME ...     declares feature keywords; a variant is compiled with `#define NAME 1` for each keyword
+//                          it enables, inserted after the stage's #version line
+// Files are read through readResource, so shaders embedded in the executable never touch the disk.
+
+constexpr std::size_t MAX_SHADER_KEYWORDS = 64;
+
+enum class ShaderStage {
+    VERTEX = 0, TESS_CONTROL = 1, TESS_EVALUATION = 2, GEOMETRY = 3, FRAGMENT = 4, COMPUTE = 5
+};
+
+constexpr int SHADER_STAGE_COUNT = 6;
+
+// As written after #shader, indexed by ShaderStage
+constexpr std::string_view SHADER_STAGE_NAMES[SHADER_STAGE_COUNT] = {
+        "vertex", "tess_control", "tess_evaluation", "geometry", "fragment", "compute"
+};
+
+struct ShaderSources {
+    std::string stages[SHADER_STAGE_COUNT]; // indexed by ShaderStage, empty for stages the file does not have
+    std::vector<std::string> keywords;      // bit i of a keyword mask enables keywords[i]
+};
+
+// Included files with their own includes already expanded, keyed by resource path. Shared between parses, so a
+// header pulled in by many shaders or stages is read and expanded only once.
+struct ShaderIncludeCache {
+    std::unordered_map<std::string, std::string> files;
+};
+
+int parseShaders(std::string_view shaderPath, ShaderSources &sources, ShaderIncludeCache &includes);
+int parseShaders(std::string_view shaderPath, ShaderSources &sources);
+// Back to the .shader format, with every include already expanded
+std::string serializeShaders(const ShaderSources &sources);
+// A program is either compute alone or a graphics pipeline with at least a vertex stage
+int validateShaderStages(const ShaderSources &sources);
+
+// Builds the program for one keyword combination. Tessellation needs GL 4.0 or ARB_tessellation_shader, compute
+// GL 4.3 or ARB_compute_shader; a stage the context lacks fails the build.
+int compileAndLinkShaders(const ShaderSources &sources, unsigned int &shaderProgram, std::uint64_t keywordMask = 0);
+
+// Mask enabling the given keywords; unknown names are reported and left out
+std::uint64_t keywordMask(const ShaderSources &sources, std::initializer_list<std::string_view> keywords);
+
+// A uniform block the programs may declare and the C++ struct it mirrors (see uniform_buffer.h). Every variant
+// checks the linked block's size and member offsets against it, so the GLSL and C++ sides cannot drift apart.
+struct UniformBlockBinding {
+    std::string name;
+    unsigned int binding;
+    std::size_t size;                                        // sizeof the struct
+    std::vector<std::pair<std::string, std::size_t>> members; // GLSL member name -> offsetof in the struct
+};
+
+// The permutations of one .shader file, compiled the first time each keyword mask is asked for
+struct ShaderVariants {
+    ShaderSources sources;
+    std::vector<UniformBlockBinding> blockBindings;
+    std::unordered_map<std::uint64_t, unsigned int> programs;        // 0 for variants that failed to build
+};
+
+int loadShaderVariants(std::string_view shaderPath, ShaderVariants &variants, ShaderIncludeCache &includes);
+// Program for a keyword mask, compiling it on first use; 0 when it does not build (not retried)
+unsigned int getShaderVariant(ShaderVariants &variants, std::uint64_t keywordMask);
+void destroyShaderVariants(ShaderVariants &variants);
+
+// A linked compute program and the work group size it declares with layout (local_size_x = ...)
+struct ComputeProgram {
+    unsigned int program = 0;
+    unsigned int localSize[3] = {1, 1, 1};
+};
+
+bool isComputeSupported();
+// program comes from compileAndLinkShaders or getShaderVariant on a source with a compute stage
+int initComputeProgram(ComputeProgram &compute, unsigned int program);
+
+// Runs groupsX * groupsY * groupsZ work groups, then issues glMemoryBarrier(barriers) (GL_*_BARRIER_BIT) so later
+// commands see what the shader wrote
+int dispatchCompute(const ComputeProgram &compute, unsigned int groupsX, unsigned int groupsY = 1,
+                    unsigned int groupsZ = 1, unsigned int barriers = 0);
+// Enough work groups to cover a threadsX * threadsY * threadsZ grid; invocations past its end must return early
+int dispatchComputeThreads(const ComputeProgram &compute, unsigned int threadsX, unsigned int threadsY = 1,
+                           unsigned int threadsZ = 1, unsigned int barriers = 0);
@@ -0,0 +1,236 @@
+#pragma once
+
+// Thin wrappers over the SIMD registers the math library uses: float4 is SSE2 on x86, NEON on 64-bit ARM (ARMv7
+// lacks the across-vector adds used here) and a plain array elsewhere; float8 is AVX and only exists when the
+// compiler targets it (LEARN_OPENGL_AVX2).
+// Both expose the same operations so kernels can be written once as templates over the lane type.
+
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define SIMD_SSE 1
+#include <immintrin.h>
+#elif defined(__aarch64__) || defined(_M_ARM64)
+#define SIMD_NEON 1
+#include <arm_neon.h>
+#endif
+
+#if defined(__AVX__)
+#define SIMD_AVX 1
+#endif
+
+#if defined(__FMA__)
+#define SIMD_FMA 1
+#endif
+
+struct float4 {
+    static constexpr int WIDTH = 4;
+
+#if SIMD_SSE
+    __m128 v;
+
+    static float4 splat(float f) { return {_mm_set1_ps(f)}; }
+    static float4 load(const float *p) { return {_mm_loadu_ps(p)}; }
+    void store(float *p) const { _mm_storeu_ps(p, v); }
+#elif SIMD_NEON
+    float32x4_t v;
+
+    static float4 splat(float f) { return {vdupq_n_f32(f)}; }
+    static float4 load(const float *p) { return {vld1q_f32(p)}; }
+    void store(float *p) const { vst1q_f32(p, v); }
+#else
+    float v[4];
+
+    static float4 splat(float f) { return {{f, f, f, f}}; }
+    static float4 load(const float *p) { return {{p[0], p[1], p[2], p[3]}}; }
+    void store(float *p) const { std::memcpy(p, v, sizeof(v)); }
+#endif
+};
+
+#if SIMD_SSE
+
+inline float4 operator+(float4 a, float4 b) { return {_mm_add_ps(a.v, b.v)}; }
+inline float4 operator-(float4 a, float4 b) { return {_mm_sub_ps(a.v, b.v)}; }
+inline float4 operator*(float4 a, float4 b) { return {_mm_mul_ps(a.v, b.v)}; }
+inline float4 madd(float4 a, float4 b, float4 c) {
+#if SIMD_FMA
+    return {_mm_fmadd_ps(a.v, b.v, c.v)};
+#else
+    return {_mm_add_ps(_mm_mul_ps(a.v, b.v), c.v)};
+#endif
+}
+inline float4 minimum(float4 a, float4 b) { return {_mm_min_ps(a.v, b.v)}; }
+inline float4 maximum(float4 a, float4 b) { return {_mm_max_ps(a.v, b.v)}; }
+// Round to nearest even (the default MXCSR mode), exact for |x| < 2^31
+inline float4 roundNearest(float4 a) { return {_mm_cvtepi32_ps(_mm_cvtps_epi32(a.v))}; }
+inline float4 signBits(float4 a) { return {_mm_and_ps(a.v, _mm_set1_ps(-0.0f))}; }
+inline float4 absolute(float4 a) { return {_mm_andnot_ps(_mm_set1_ps(-0.0f), a.v)}; }
+inline float4 xorBits(float4 a, float4 b) { return {_mm_xor_ps(a.v, b.v)}; }
+inline float4 greaterThan(float4 a, float4 b) { return {_mm_cmpgt_ps(a.v, b.v)}; }
+inline float4 select(float4 mask, float4 a, float4 b) {
+    return {_mm_or_ps(_mm_and_ps(mask.v, a.v), _mm_andnot_ps(mask.v, b.v))};
+}
+// Sign bit of every lane packed into an int, lane 0 in bit 0
+inline int maskBits(float4 a) { return _mm_movemask_ps(a.v); }
+template<int I>
+float4 broadcast(float4 a) { return {_mm_shuffle_ps(a.v, a.v, _MM_SHUFFLE(I, I, I, I))}; }
+// a.x * b.x + a.y * b.y + a.z * b.z + a.w * b.w in every lane
+inline float4 dot4(float4 a, float4 b) {
+    __m128 product = _mm_mul_ps(a.v, b.v);
+    product = _mm_add_ps(product, _mm_shuffle_ps(product, product, _MM_SHUFFLE(2, 3, 0, 1)));
+    return {_mm_add_ps(product, _mm_shuffle_ps(product, product, _MM_SHUFFLE(1, 0, 3, 2)))};
+}
+
+#elif SIMD_NEON
+
+inline float4 operator+(float4 a, float4 b) { return {vaddq_f32(a.v, b.v)}; }
+inline float4 operator-(float4 a, float4 b) { return {vsubq_f32(a.v, b.v)}; }
+inline float4 operator*(float4 a, float4 b) { return {vmulq_f32(a.v, b.v)}; }
+inline float4 madd(float4 a, float4 b, float4 c) { return {vfmaq_f32(c.v, a.v, b.v)}; }
+inline float4 minimum(float4 a, float4 b) { return {vminq_f32(a.v, b.v)}; }
+inline float4 maximum(float4 a, float4 b) { return {vmaxq_f32(a.v, b.v)}; }
+inline float4 roundNearest(float4 a) { return {vrndnq_f32(a.v)}; }
+inline float4 signBits(float4 a) {
+    return {vreinterpretq_f32_u32(vandq_u32(vreinterpretq_u32_f32(a.v), vdupq_n_u32(0x80000000u)))};
+}
+inline float4 absolute(float4 a) { return {vabsq_f32(a.v)}; }
+inline float4 xorBits(float4 a, float4 b) {
+    return {vreinterpretq_f32_u32(veorq_u32(vreinterpretq_u32_f32(a.v), vreinterpretq_u32_f32(b.v)))};
+}
+inline float4 greaterThan(float4 a, float4 b) { return {vreinterpretq_f32_u32(vcgtq_f32(a.v, b.v))}; }
+inline float4 select(float4 mask, float4 a, float4 b) { return {vbslq_f32(vreinterpretq_u32_f32(mask.v), a.v, b.v)}; }
+inline int maskBits(float4 a) {
+    const int32x4_t lanes = {0, 1, 2, 3};
+    const uint32x4_t signs = vshrq_n_u32(vreinterpretq_u32_f32(a.v), 31);
+    return static_cast<int>(vaddvq_u32(vshlq_u32(signs, lanes)));
+}
+template<int I>
+float4 broadcast(float4 a) { return {vdupq_laneq_f32(a.v, I)}; }
+inline float4 dot4(float4 a, float4 b) { return {vdupq_n_f32(vaddvq_f32(vmulq_f32(a.v, b.v)))}; }
+
+#else
+
+namespace simd_detail {
+template<typename Fn>
+float4 map(float4 a, float4 b, Fn fn) {
+    return {{fn(a.v[0], b.v[0]), fn(a.v[1], b.v[1]), fn(a.v[2], b.v[2]), fn(a.v[3], b.v[3])}};
+}
+inline std::uint32_t bits(float f) { std::uint32_t u; std::memcpy(&u, &f, 4); return u; }
+inline float fromBits(std::uint32_t u) { float f; std::memcpy(&f, &u, 4); return f; }
+} // namespace simd_detail
+
+inline float4 operator+(float4 a, float4 b) { return simd_detail::map(a, b, [](float x, float y) { return x + y; }); }
+inline float4 operator-(float4 a, float4 b) { return simd_detail::map(a, b, [](float x, float y) { return x - y; }); }
+inline float4 operator*(float4 a, float4 b) { return simd_detail::map(a, b, [](float x, float y) { return x * y; }); }
+inline float4 madd(float4 a, float4 b, float4 c) { return a * b + c; }
+inline float4 minimum(float4 a, float4 b) { return simd_detail::map(a, b, [](float x, float y) { return y < x ? y : x; }); }
+inline float4 maximum(float4 a, float4 b) { return simd_detail::map(a, b, [](float x, float y) { return x < y ? y : x; }); }
+inline float4 roundNearest(float4 a) { return simd_detail::map(a, a, [](float x, float) { return std::nearbyint(x); }); }
+inline float4 signBits(float4 a) {
+    return simd_detail::map(a, a, [](float x, float) { return simd_detail::fromBits(simd_detail::bits(x) & 0x80000000u); });
+}
+inline float4 absolute(float4 a) { return simd_detail::map(a, a, [](float x, float) { return std::fabs(x); }); }
+inline float4 xorBits(float4 a, float4 b) {
+    return simd_detail::map(a, b, [](float x, float y) {
+        return simd_detail::fromBits(simd_detail::bits(x) ^ simd_detail::bits(y));
+    });
+}
+inline float4 greaterThan(float4 a, float4 b) {
+    return simd_detail::map(a, b, [](float x, float y) { return simd_detail::fromBits(x > y ? ~0u : 0u); });
+}
+inline float4 select(float4 mask, float4 a, float4 b) {
+    float4 result;
+    for (int i = 0; i < 4; i++) {
+        result.v[i] = simd_detail::bits(mask.v[i]) ? a.v[i] : b.v[i];
+    }
+    return result;
+}
+inline int maskBits(float4 a) {
+    int result = 0;
+    for (int i = 0; i < 4; i++) {
+        result |= static_cast<int>(simd_detail::bits(a.v[i]) >> 31) << i;
+    }
+    return result;
+}
+template<int I>
+float4 broadcast(float4 a) { return float4::splat(a.v[I]); }
+inline float4 dot4(float4 a, float4 b) {
+    return float4::splat(a.v[0] * b.v[0] + a.v[1] * b.v[1] + a.v[2] * b.v[2] + a.v[3] * b.v[3]);
+}
+
+#endif
+
+#if SIMD_AVX
+
+struct float8 {
+    static constexpr int WIDTH = 8;
+
+    __m256 v;
+
+    static float8 splat(float f) { return {_mm256_set1_ps(f)}; }
+    static float8 load(const float *p) { return {_mm256_loadu_ps(p)}; }
+    void store(float *p) const { _mm256_storeu_ps(p, v); }
+};
+
+inline float8 operator+(float8 a, float8 b) { return {_mm256_add_ps(a.v, b.v)}; }
+inline float8 operator-(float8 a, float8 b) { return {_mm256_sub_ps(a.v, b.v)}; }
+inline float8 operator*(float8 a, float8 b) { return {_mm256_mul_ps(a.v, b.v)}; }
+inline float8 madd(float8 a, float8 b, float8 c) {
+#if SIMD_FMA
+    return {_mm256_fmadd_ps(a.v, b.v, c.v)};
+#else
+    return {_mm256_add_ps(_mm256_mul_ps(a.v, b.v), c.v)};
+#endif
+}
+inline float8 minimum(float8 a, float8 b) { return {_mm256_min_ps(a.v, b.v)}; }
+inline float8 maximum(float8 a, float8 b) { return {_mm256_max_ps(a.v, b.v)}; }
+inline float8 roundNearest(float8 a) { return {_mm256_round_ps(a.v, _MM_FROUND_TO_NEAREST_INT | _MM_FROUND_NO_EXC)}; }
+inline float8 signBits(float8 a) { return {_mm256_and_ps(a.v, _mm256_set1_ps(-0.0f))}; }
+inline float8 absolute(float8 a) { return {_mm256_andnot_ps(_mm256_set1_ps(-0.0f), a.v)}; }
+inline float8 xorBits(float8 a, float8 b) { return {_mm256_xor_ps(a.v, b.v)}; }
+inline float8 greaterThan(float8 a, float8 b) { return {_mm256_cmp_ps(a.v, b.v, _CMP_GT_OQ)}; }
+inline float8 select(float8 mask, float8 a, float8 b) { return {_mm256_blendv_ps(b.v, a.v, mask.v)}; }
+inline int maskBits(float8 a) { return _mm256_movemask_ps(a.v); }
+
+#endif
+
+// Widest lane type the build targets, used by the batch kernels
+#if SIMD_AVX
+using floatN = float8;
+#else
+using floatN = float4;
+#endif
+
+constexpr float PI = 3.14159265358979323846f;
+constexpr float HALF_PI = PI * 0.5f;
+constexpr float TWO_PI = PI * 2.0f;
+
+// sin over all floats (accuracy degrades past |x| ~ 1e5 like any single precision reduction). The angle is
+// reduced to [-pi, pi] with a two part 2*pi (Cody-Waite), folded to [-pi/2, pi/2], then an odd degree 11
+// polynomial: absolute error below 2e-7 on [-pi, pi], growing with |x| through the single precision reduction.
+template<typename T>
+T fastSin(T x) {
+    const T turns = roundNearest(x * T::splat(1.0f / TWO_PI));
+    x = madd(turns, T::splat(-6.28318548202514648f), x);
+    x = madd(turns, T::splat(1.74845553146951715e-7f), x);
+
+    const T sign = signBits(x);
+    T a = absolute(x);
+    a = select(greaterThan(a, T::splat(HALF_PI)), T::splat(PI) - a, a);
+
+    const T a2 = a * a;
+    T p = T::splat(-2.3889859e-08f);
+    p = madd(p, a2, T::splat(2.7525562e-06f));
+    p = madd(p, a2, T::splat(-1.9840874e-04f));
+    p = madd(p, a2, T::splat(8.3333310e-03f));
+    p = madd(p, a2, T::splat(-1.6666667e-01f));
+    const T result = madd(a * a2, p, a);
+    return xorBits(result, sign);
+}
+
+template<typename T>
+T fastCos(T x) {
+    return fastSin(x + T::splat(HALF_PI));
+}
@@ -0,0 +1,63 @@
+#pragma once
+
+#include <vector_math.h>
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+// Scene graph of transforms in flat parallel arrays. Nodes are only ever appended under an existing parent, so
+// every parent sits before its children and one forward pass resolves the whole tree. Changing a local transform
+// marks the node dirty; the update recomputes that node and its subtree and leaves everything else alone.
+
+constexpr std::uint32_t NO_PARENT = ~0u;
+
+struct TransformHierarchy {
+    // Indexed by node, parents[i] < i for every node that has a parent
+    std::vector<std::uint32_t> parents;
+    std::vector<std::uint32_t> depths;
+    std::vector<vec3> positions;
+    std::vector<quat> rotations;
+    std::vector<vec3> scales;
+    std::vector<mat4> worldMatrices;
+    std::vector<std::uint8_t> dirty; // local transform changed since the last update
+
+    // Nodes grouped by depth, so each level is one batch of independent products; rebuilt when nodes are added
+    std::vector<std::uint32_t> levelNodes;
+    std::vector<std::uint32_t> levelStarts;
+    bool levelsValid = false;
+
+    // Node range [changedBegin, changedEnd) rewritten by the last update, empty when nothing moved
+    std::uint32_t changedBegin = 0;
+    std::uint32_t changedEnd = 0;
+
+    // Update scratch, kept between frames
+    std::vector<std::uint8_t> worldDirty;
+    std::vector<std::uint32_t> batchNodes;
+    std::vector<mat4> parentMatrices;
+    std::vector<mat4> localMatrices;
+};
+
+// Returns the new node, dirty until the next update. `parent` must be an existing node or NO_PARENT.
+std::uint32_t addTransform(TransformHierarchy &hierarchy, std::uint32_t parent, vec3 position,
+                           const quat &rotation = quatIdentity(), vec3 scale = {1.0f, 1.0f, 1.0f});
+
+void setLocalTransform(TransformHierarchy &hierarchy, std::uint32_t node, vec3 position, const quat &rotation,
+                       vec3 scale);
+void setLocalPosition(TransformHierarchy &hierarchy, std::uint32_t node, vec3 position);
+
+// Recomputes the world matrices of dirty nodes and their descendants, level by level through the batch matrix
+// kernel. Returns how many nodes were recomputed.
+std::size_t updateWorldMatrices(TransformHierarchy &hierarchy);
+
+// GPU copy of the world matrices for the `Transform { mat4 model; }` std140 block. Every node gets its own slot
+// aligned to GL_UNIFORM_BUFFER_OFFSET_ALIGNMENT, a draw selects its node by binding that range.
+struct TransformBuffer {
+    unsigned int buffer = 0;
+    std::size_t stride = 0;
+    std::size_t capacity = 0; // in nodes
+};
+
+void initTransformBuffer(TransformBuffer &transforms);
+// Writes the matrices the last update changed, or all of them when the buffer had to grow. GL thread only.
+void uploadTransforms(TransformBuffer &transforms, const TransformHierarchy &hierarchy);
@@ -0,0 +1,71 @@
+#pragma once
+
+#include <vector_math.h>
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <type_traits>
+
+// Uniform block binding points shared by every program, assigned with glUniformBlockBinding after linking
+enum UniformBinding : unsigned int {
+    BINDING_TRANSFORM = 0, BINDING_DRAW = 1, BINDING_CLUSTERS = 2
+};
+
+// Uniform blocks are declared as C++ structs mirrored field for field by a `layout (std140)` block in GLSL.
+// vec4 and mat4 already follow std140 (16 byte aligned, matrices as four vec4 columns); use them for vec3
+// too, since GLSL would pack a scalar following a vec3 into its fourth component.
+template<typename T>
+constexpr bool isUniformBlock = std::is_trivially_copyable_v<T> && alignof(T) == 16 && sizeof(T) % 16 == 0;
+
+// What a ring allocation hands back: where to write and the offset to bind. data is null when the frame's
+// share of the ring is used up.
+struct UniformAllocation {
+    std::byte *data;
+    std::uint32_t offset;
+};
+
+// One uniform buffer split into FRAMES regions, each written by one frame while the GPU may still read the
+// previous ones; a fence per region keeps the CPU from overwriting data in flight. With ARB_buffer_storage the
+// buffer is mapped once, persistently, otherwise the current region is mapped unsynchronized each frame. Either
+// way allocation is an atomic bump, so recording threads can fill their draws' blocks directly.
+struct UniformRing {
+    static constexpr std::size_t FRAMES = 3;
+
+    unsigned int buffer = 0;
+    std::size_t frameSize = 0;
+    std::size_t alignment = 256;
+    bool persistent = false;
+
+    std::byte *persistentData = nullptr; // whole buffer, persistent path only
+    std::byte *frameData = nullptr;      // the current frame's region while it is open
+    std::size_t frame = 0;
+    bool started = false;
+    std::atomic<std::size_t> used{0};
+    std::atomic<std::size_t> overflows{0}; // allocations refused because the frame's region was full
+    std::size_t grows = 0;
+    void *fences[FRAMES] = {}; // GLsync per region, set once the frame's draws were issued
+};
+
+void initUniformRing(UniformRing &ring, std::size_t frameSize = 1 << 20);
+void destroyUniformRing(UniformRing &ring);
+
+// Fences the previous frame's region, then waits until the next one is free and opens it for writing. When the
+// previous frame overflowed, the ring is first reallocated big enough for it, which waits for the GPU once.
+void beginUniformFrame(UniformRing &ring);
+// Thread safe while the frame is open
+UniformAllocation allocateUniforms(UniformRing &ring, std::size_t size);
+// Closes the frame's region; must come before any draw that reads it
+void endUniformFrame(UniformRing &ring);
+
+// Copies a block into the current frame's region, data is null when it overflowed
+template<typename T>
+UniformAllocation pushUniforms(UniformRing &ring, const T &block) {
+    static_assert(isUniformBlock<T>, "uniform blocks must be trivially copyable, 16 byte aligned and sized");
+    const UniformAllocation allocation = allocateUniforms(ring, sizeof(T));
+    if (allocation.data) {
+        std::memcpy(allocation.data, &block, sizeof(T));
+    }
+    return allocation;
+}
@@ -0,0 +1,110 @@
+#pragma once
+
+// Engine math: vectors, column-major matrices (the GL convention, uploadable as is) and quaternions.
+// The 4 wide types sit on float4 so mat4 products and transforms are a handful of SIMD instructions;
+// batch kernels at the bottom work on structure-of-arrays data.
+
+#include <simd.h>
+
+#include <cmath>
+#include <cstddef>
+
+struct vec2 {
+    float x, y;
+};
+
+struct vec3 {
+    float x, y, z;
+};
+
+struct alignas(16) vec4 {
+    float x, y, z, w;
+};
+
+// Rotation quaternion, w is the scalar part
+struct alignas(16) quat {
+    float x, y, z, w;
+};
+
+// Column-major: columns[c] is the c-th column
+struct mat3 {
+    vec3 columns[3];
+};
+
+struct alignas(16) mat4 {
+    vec4 columns[4];
+};
+
+inline vec2 operator+(vec2 a, vec2 b) { return {a.x + b.x, a.y + b.y}; }
+inline vec2 operator-(vec2 a, vec2 b) { return {a.x - b.x, a.y - b.y}; }
+inline vec2 operator*(vec2 a, float s) { return {a.x * s, a.y * s}; }
+inline float dot(vec2 a, vec2 b) { return a.x * b.x + a.y * b.y; }
+
+inline vec3 operator+(vec3 a, vec3 b) { return {a.x + b.x, a.y + b.y, a.z + b.z}; }
+inline vec3 operator-(vec3 a, vec3 b) { return {a.x - b.x, a.y - b.y, a.z - b.z}; }
+inline vec3 operator-(vec3 a) { return {-a.x, -a.y, -a.z}; }
+inline vec3 operator*(vec3 a, float s) { return {a.x * s, a.y * s, a.z * s}; }
+inline vec3 operator*(vec3 a, vec3 b) { return {a.x * b.x, a.y * b.y, a.z * b.z}; }
+inline float dot(vec3 a, vec3 b) { return a.x * b.x + a.y * b.y + a.z * b.z; }
+inline vec3 cross(vec3 a, vec3 b) { return {a.y * b.z - a.z * b.y, a.z * b.x - a.x * b.z, a.x * b.y - a.y * b.x}; }
+inline float length(vec3 a) { return std::sqrt(dot(a, a)); }
+inline vec3 normalize(vec3 a) {
+    const float len = length(a);
+    return len > 0.0f ? a * (1.0f / len) : a;
+}
+inline vec3 lerp(vec3 a, vec3 b, float t) { return a + (b - a) * t; }
+
+inline float4 toFloat4(const vec4 &a) { return float4::load(&a.x); }
+inline vec4 toVec4(float4 a) {
+    vec4 result;
+    a.store(&result.x);
+    return result;
+}
+
+inline vec4 operator+(const vec4 &a, const vec4 &b) { return toVec4(toFloat4(a) + toFloat4(b)); }
+inline vec4 operator-(const vec4 &a, const vec4 &b) { return toVec4(toFloat4(a) - toFloat4(b)); }
+inline vec4 operator*(const vec4 &a, float s) { return toVec4(toFloat4(a) * float4::splat(s)); }
+inline float dot(const vec4 &a, const vec4 &b) {
+    float result[4];
+    dot4(toFloat4(a), toFloat4(b)).store(result);
+    return result[0];
+}
+
+mat4 identity();
+mat4 translation(vec3 t);
+mat4 scaling(vec3 s);
+mat4 rotation(const quat &q);
+// Translation * rotation * scale
+mat4 composeTransform(vec3 t, const quat &r, vec3 s);
+mat4 perspective(float fovY, float aspect, float near, float far);
+mat4 orthographic(float left, float right, float bottom, float top, float near, float far);
+mat4 lookAt(vec3 eye, vec3 target, vec3 up);
+
+mat4 operator*(const mat4 &a, const mat4 &b);
+vec4 operator*(const mat4 &m, const vec4 &v);
+vec3 transformPoint(const mat4 &m, vec3 p);
+vec3 transformDirection(const mat4 &m, vec3 d);
+mat4 transpose(const mat4 &m);
+// General inverse (cofactors), the identity for singular matrices
+mat4 inverse(const mat4 &m);
+// Inverse transpose of the upper 3x3, for transforming normals
+mat3 normalMatrix(const mat4 &m);
+
+quat quatIdentity();
+quat axisAngle(vec3 axis, float angle);
+quat operator*(const quat &a, const quat &b);
+quat normalize(const quat &q);
+quat conjugate(const quat &q);
+vec3 rotate(const quat &q, vec3 v);
+// Shortest path spherical interpolation, falls back to nlerp for nearly equal rotations
+quat slerp(const quat &a, const quat &b, float t);
+
+// Batch kernels over structure-of-arrays data, vectorized with the widest lane type the build has
+
+// out = m * (x, y, z, 1) for every point; outputs may alias inputs
+void transformPointsSoA(const mat4 &m, const float *x, const float *y, const float *z, float *outX, float *outY,
+                        float *outZ, std::size_t count);
+// out[i] = a[i] * b[i]; out may alias a or b
+void multiplyMatrices(const mat4 *a, const mat4 *b, mat4 *out, std::size_t count);
+// fastSin/fastCos over arrays, either output may be null
+void sinCos(const float *angles, float *sines, float *cosines, std::size_t count);
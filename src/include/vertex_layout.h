@@ -0,0 +1,87 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+struct Vertex;
+
+// Storage format of each vertex attribute on the GPU
+enum class PositionFormat : std::uint8_t {
+    FLOAT32,  // 12 bytes
+    HALF,     // 8 bytes (3 halves + padding)
+    UNORM16,  // 8 bytes, relative to the mesh bounding box
+};
+
+enum class NormalFormat : std::uint8_t {
+    NONE,
+    FLOAT32,      // 12 bytes
+    OCTAHEDRAL16, // 4 bytes, octahedral mapping stored as 2 snorm16
+};
+
+enum class UvFormat : std::uint8_t {
+    NONE, FLOAT32, HALF
+};
+
+enum class ColorFormat : std::uint8_t {
+    NONE, FLOAT32, UNORM8
+};
+
+struct VertexFormat {
+    PositionFormat position = PositionFormat::FLOAT32;
+    NormalFormat normal = NormalFormat::NONE;
+    UvFormat uv = UvFormat::NONE;
+    ColorFormat color = ColorFormat::FLOAT32;
+
+    bool operator==(const VertexFormat &) const = default;
+};
+
+// Shader attribute locations shared by every program that consumes meshes
+enum VertexLocation : unsigned int {
+    LOCATION_POSITION = 0, LOCATION_COLOR = 1, LOCATION_NORMAL = 2, LOCATION_UV = 3
+};
+
+struct VertexAttribute {
+    unsigned int location;
+    int components;
+    unsigned int type; // GL component type
+    bool normalized;
+    unsigned int offset;
+};
+
+// Data-driven description of an interleaved vertex, replaces hand written glVertexAttribPointer calls
+struct VertexLayout {
+    VertexFormat format;
+    unsigned int stride = 0;
+    std::vector<VertexAttribute> attributes;
+};
+
+struct MeshBounds {
+    float min[3];
+    float max[3];
+};
+
+// What the vertex shader multiplies and adds to the fetched position to get object space back
+struct PositionDecode {
+    float scale[3];
+    float bias[3];
+};
+
+VertexLayout makeVertexLayout(const VertexFormat &format);
+MeshBounds computeBounds(const Vertex *vertices, std::size_t count);
+PositionDecode positionDecode(PositionFormat format, const MeshBounds &bounds);
+
+// Encodes float vertices into the interleaved layout, `out` is resized to count * layout.stride
+void packVertices(const Vertex *vertices, std::size_t count, const VertexLayout &layout, const MeshBounds &bounds,
+                  std::vector<unsigned char> &out);
+
+// Decodes the positions of packed vertices back to object space, `out` gets count * 3 floats
+void unpackPositions(const unsigned char *vertexData, std::size_t count, const VertexLayout &layout,
+                     const MeshBounds &bounds, std::vector<float> &out);
+
+// Sets up the attribute pointers of the currently bound VAO for the buffer bound to GL_ARRAY_BUFFER
+void applyVertexLayout(const VertexLayout &layout);
+
+std::uint16_t floatToHalf(float value);
+float halfToFloat(std::uint16_t value);
+void encodeOctahedral(const float normal[3], std::int16_t out[2]);
@@ -0,0 +1,238 @@
+#include <job_system.h>
+
+#include <algorithm>
+#include <memory>
+#include <thread>
+#include <vector>
+
+namespace {
+
+// Chase-Lev work-stealing deque, with the memory orderings of Lê et al., "Correct and Efficient Work-Stealing
+// for Weak Memory Models". The owner pushes and pops at the bottom, thieves take from the top. Fixed capacity:
+// a worker never has more jobs in flight than its job ring holds anyway.
+class WorkStealingDeque {
+public:
+    bool push(Job *job) {
+        const std::int64_t b = bottom.load(std::memory_order_relaxed);
+        const std::int64_t t = top.load(std::memory_order_acquire);
+        if (b - t >= static_cast<std::int64_t>(MAX_JOBS_PER_WORKER)) {
+            return false;
+        }
+        buffer[b & MASK].store(job, std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_release);
+        bottom.store(b + 1, std::memory_order_relaxed);
+        return true;
+    }
+
+    Job *pop() {
+        const std::int64_t b = bottom.load(std::memory_order_relaxed) - 1;
+        bottom.store(b, std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        std::int64_t t = top.load(std::memory_order_relaxed);
+
+        if (t > b) { // empty
+            bottom.store(b + 1, std::memory_order_relaxed);
+            return nullptr;
+        }
+        Job *job = buffer[b & MASK].load(std::memory_order_relaxed);
+        if (t == b) {
+            // Last job, race the thieves for it
+            if (!top.compare_exchange_strong(t, t + 1, std::memory_order_seq_cst, std::memory_order_relaxed)) {
+                job = nullptr;
+            }
+            bottom.store(b + 1, std::memory_order_relaxed);
+        }
+        return job;
+    }
+
+    Job *steal() {
+        std::int64_t t = top.load(std::memory_order_acquire);
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        const std::int64_t b = bottom.load(std::memory_order_acquire);
+        if (t >= b) {
+            return nullptr;
+        }
+        Job *job = buffer[t & MASK].load(std::memory_order_relaxed);
+        if (!top.compare_exchange_strong(t, t + 1, std::memory_order_seq_cst, std::memory_order_relaxed)) {
+            return nullptr; // lost to the owner or another thief
+        }
+        return job;
+    }
+
+private:
+    static constexpr std::int64_t MASK = MAX_JOBS_PER_WORKER - 1;
+
+    alignas(64) std::atomic<std::int64_t> top{0};
+    alignas(64) std::atomic<std::int64_t> bottom{0};
+    std::atomic<Job *> buffer[MAX_JOBS_PER_WORKER] = {};
+};
+
+struct Worker {
+    WorkStealingDeque deque;
+    Job jobs[MAX_JOBS_PER_WORKER];
+    std::size_t nextJob = 0;
+    std::uint32_t random = 0;
+};
+
+struct JobSystem {
+    std::vector<std::unique_ptr<Worker>> workers; // the pool first, then the slots for attached threads
+    std::size_t poolSize = 0;
+    std::atomic<std::size_t> attachedThreads{0};
+    std::vector<std::thread> threads;
+    std::atomic<bool> running{false};
+    // Bumped after every submission, idle workers sleep on it
+    std::atomic<std::uint32_t> epoch{0};
+
+    ~JobSystem() {
+        shutdownJobSystem();
+    }
+};
+
+JobSystem jobSystem;
+thread_local Worker *currentWorker = nullptr;
+
+// xorshift32, only used to pick steal victims
+std::uint32_t nextRandom(std::uint32_t &state) {
+    state ^= state << 13;
+    state ^= state >> 17;
+    state ^= state << 5;
+    return state;
+}
+
+Job *findJob(Worker &worker) {
+    if (Job *job = worker.deque.pop()) {
+        return job;
+    }
+    const std::size_t count = jobSystem.workers.size();
+    const std::size_t start = nextRandom(worker.random) % count;
+    for (std::size_t i = 0; i < count; i++) {
+        Worker &victim = *jobSystem.workers[(start + i) % count];
+        if (&victim != &worker) {
+            if (Job *job = victim.deque.steal()) {
+                return job;
+            }
+        }
+    }
+    return nullptr;
+}
+
+void execute(Job &job) {
+    JobCounter *counter = job.counter;
+    job.function(job);
+    job.busy.store(false, std::memory_order_release);
+    counter->value.fetch_sub(1, std::memory_order_release);
+}
+
+void workerMain(Worker &worker) {
+    currentWorker = &worker;
+    while (true) {
+        // Read the epoch before looking for work: a job submitted after the search bumps it and the wait returns
+        const std::uint32_t epoch = jobSystem.epoch.load(std::memory_order_seq_cst);
+        if (!jobSystem.running.load(std::memory_order_acquire)) {
+            break;
+        }
+        Job *job = findJob(worker);
+        for (int spin = 0; !job && spin < 64; spin++) {
+            std::this_thread::yield();
+            job = findJob(worker);
+        }
+        if (job) {
+            execute(*job);
+        } else {
+            jobSystem.epoch.wait(epoch, std::memory_order_seq_cst);
+        }
+    }
+    currentWorker = nullptr;
+}
+
+} // namespace
+
+void initJobSystem(std::size_t workerCount) {
+    if (jobSystem.running.load()) {
+        return;
+    }
+    if (workerCount == 0) {
+        workerCount = std::max(1u, std::thread::hardware_concurrency());
+    }
+    jobSystem.workers.clear();
+    jobSystem.poolSize = workerCount;
+    jobSystem.attachedThreads = 0;
+    for (std::size_t i = 0; i < workerCount + MAX_ATTACHED_THREADS; i++) {
+        jobSystem.workers.push_back(std::make_unique<Worker>());
+        jobSystem.workers.back()->random = static_cast<std::uint32_t>(i * 2654435761u + 1);
+    }
+    jobSystem.running.store(true);
+
+    currentWorker = jobSystem.workers[0].get();
+    for (std::size_t i = 1; i < workerCount; i++) {
+        jobSystem.threads.emplace_back(workerMain, std::ref(*jobSystem.workers[i]));
+    }
+}
+
+void shutdownJobSystem() {
+    if (!jobSystem.running.exchange(false)) {
+        return;
+    }
+    jobSystem.epoch.fetch_add(1, std::memory_order_seq_cst);
+    jobSystem.epoch.notify_all();
+    for (std::thread &thread : jobSystem.threads) {
+        thread.join();
+    }
+    jobSystem.threads.clear();
+    jobSystem.workers.clear();
+    currentWorker = nullptr;
+}
+
+bool attachJobThread() {
+    if (!jobSystem.running.load() || currentWorker) {
+        return currentWorker != nullptr;
+    }
+    const std::size_t slot = jobSystem.attachedThreads.fetch_add(1);
+    if (slot >= MAX_ATTACHED_THREADS) {
+        return false;
+    }
+    currentWorker = jobSystem.workers[jobSystem.poolSize + slot].get();
+    return true;
+}
+
+std::size_t jobWorkerCount() {
+    return jobSystem.running.load(std::memory_order_relaxed) ? jobSystem.poolSize : 1;
+}
+
+Job *allocateJob() {
+    if (!currentWorker) {
+        return nullptr;
+    }
+    // Walk the ring from where the last allocation stopped; long running jobs keep their slot and are skipped
+    Worker &worker = *currentWorker;
+    for (std::size_t i = 0; i < MAX_JOBS_PER_WORKER; i++) {
+        Job &job = worker.jobs[worker.nextJob++ & (MAX_JOBS_PER_WORKER - 1)];
+        if (!job.busy.load(std::memory_order_acquire)) {
+            job.busy.store(true, std::memory_order_relaxed);
+            return &job;
+        }
+    }
+    return nullptr;
+}
+
+void submitJob(Job &job, JobCounter &counter) {
+    job.counter = &counter;
+    counter.value.fetch_add(1, std::memory_order_relaxed);
+    if (!currentWorker->deque.push(&job)) {
+        execute(job); // deque full, nothing gained by queueing anyway
+        return;
+    }
+    jobSystem.epoch.fetch_add(1, std::memory_order_seq_cst);
+    jobSystem.epoch.notify_one();
+}
+
+void waitForCounter(JobCounter &counter) {
+    while (counter.value.load(std::memory_order_acquire) != 0) {
+        Job *job = currentWorker ? findJob(*currentWorker) : nullptr;
+        if (job) {
+            execute(*job);
+        } else {
+            std::this_thread::yield();
+        }
+    }
+}
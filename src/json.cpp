@@ -0,0 +1,241 @@
+#include <json.h>
+
+#include <charconv>
+#include <iostream>
+
+namespace {
+
+struct JsonParser {
+    std::string_view text;
+    std::size_t position = 0;
+    int depth = 0;
+
+    void skipWhitespace() {
+        while (position < text.size() &&
+               (text[position] == ' ' || text[position] == '\n' || text[position] == '\r' || text[position] == '\t')) {
+            position++;
+        }
+    }
+
+    bool consume(char expected) {
+        skipWhitespace();
+        if (position < text.size() && text[position] == expected) {
+            position++;
+            return true;
+        }
+        return false;
+    }
+
+    bool matchLiteral(std::string_view literal) {
+        if (text.substr(position, literal.size()) == literal) {
+            position += literal.size();
+            return true;
+        }
+        return false;
+    }
+
+    static void appendUtf8(std::string &out, unsigned int codepoint) {
+        if (codepoint < 0x80) {
+            out += static_cast<char>(codepoint);
+        } else if (codepoint < 0x800) {
+            out += static_cast<char>(0xC0 | (codepoint >> 6));
+            out += static_cast<char>(0x80 | (codepoint & 0x3F));
+        } else if (codepoint < 0x10000) {
+            out += static_cast<char>(0xE0 | (codepoint >> 12));
+            out += static_cast<char>(0x80 | ((codepoint >> 6) & 0x3F));
+            out += static_cast<char>(0x80 | (codepoint & 0x3F));
+        } else {
+            out += static_cast<char>(0xF0 | (codepoint >> 18));
+            out += static_cast<char>(0x80 | ((codepoint >> 12) & 0x3F));
+            out += static_cast<char>(0x80 | ((codepoint >> 6) & 0x3F));
+            out += static_cast<char>(0x80 | (codepoint & 0x3F));
+        }
+    }
+
+    bool parseHex4(unsigned int &value) {
+        if (position + 4 > text.size()) {
+            return false;
+        }
+        auto result = std::from_chars(text.data() + position, text.data() + position + 4, value, 16);
+        if (result.ec != std::errc{} || result.ptr != text.data() + position + 4) {
+            return false;
+        }
+        position += 4;
+        return true;
+    }
+
+    bool parseString(std::string &out) {
+        if (!consume('"')) {
+            return false;
+        }
+        while (position < text.size()) {
+            char c = text[position++];
+            if (c == '"') {
+                return true;
+            }
+            if (c != '\\') {
+                out += c;
+                continue;
+            }
+            if (position >= text.size()) {
+                return false;
+            }
+            char escape = text[position++];
+            switch (escape) {
+                case '"': out += '"'; break;
+                case '\\': out += '\\'; break;
+                case '/': out += '/'; break;
+                case 'b': out += '\b'; break;
+                case 'f': out += '\f'; break;
+                case 'n': out += '\n'; break;
+                case 'r': out += '\r'; break;
+                case 't': out += '\t'; break;
+                case 'u': {
+                    unsigned int codepoint;
+                    if (!parseHex4(codepoint)) {
+                        return false;
+                    }
+                    if (codepoint >= 0xD800 && codepoint < 0xDC00 && matchLiteral("\\u")) {
+                        unsigned int low;
+                        if (!parseHex4(low)) {
+                            return false;
+                        }
+                        codepoint = 0x10000 + ((codepoint - 0xD800) << 10) + (low - 0xDC00);
+                    }
+                    appendUtf8(out, codepoint);
+                    break;
+                }
+                default:
+                    return false;
+            }
+        }
+        return false;
+    }
+
+    bool parseValue(JsonValue &value) {
+        skipWhitespace();
+        if (position >= text.size() || depth > 256) {
+            return false;
+        }
+
+        char c = text[position];
+        if (c == '{') {
+            position++;
+            depth++;
+            value.type = JsonValue::Type::OBJECT;
+            if (consume('}')) {
+                depth--;
+                return true;
+            }
+            do {
+                std::string key;
+                if (!parseString(key) || !consume(':')) {
+                    return false;
+                }
+                value.keys.push_back(std::move(key));
+                value.items.emplace_back();
+                if (!parseValue(value.items.back())) {
+                    return false;
+                }
+            } while (consume(','));
+            depth--;
+            return consume('}');
+        }
+        if (c == '[') {
+            position++;
+            depth++;
+            value.type = JsonValue::Type::ARRAY;
+            if (consume(']')) {
+                depth--;
+                return true;
+            }
+            do {
+                value.items.emplace_back();
+                if (!parseValue(value.items.back())) {
+                    return false;
+                }
+            } while (consume(','));
+            depth--;
+            return consume(']');
+        }
+        if (c == '"') {
+            value.type = JsonValue::Type::STRING;
+            return parseString(value.string);
+        }
+        if (matchLiteral("true")) {
+            value.type = JsonValue::Type::BOOLEAN;
+            value.boolean = true;
+            return true;
+        }
+        if (matchLiteral("false")) {
+            value.type = JsonValue::Type::BOOLEAN;
+            return true;
+        }
+        if (matchLiteral("null")) {
+            value.type = JsonValue::Type::NUL;
+            return true;
+        }
+
+        value.type = JsonValue::Type::NUMBER;
+        // from_chars does not accept a leading '+' but JSON does not allow one either
+        auto result = std::from_chars(text.data() + position, text.data() + text.size(), value.number);
+        if (result.ec != std::errc{}) {
+            return false;
+        }
+        position = static_cast<std::size_t>(result.ptr - text.data());
+        return true;
+    }
+};
+
+} // namespace
+
+const JsonValue *JsonValue::find(std::string_view key) const {
+    for (std::size_t i = 0; i < keys.size(); i++) {
+        if (keys[i] == key) {
+            return &items[i];
+        }
+    }
+    return nullptr;
+}
+
+double JsonValue::asNumber(double fallback) const {
+    return type == Type::NUMBER ? number : fallback;
+}
+
+int JsonValue::asInt(int fallback) const {
+    return type == Type::NUMBER ? static_cast<int>(number) : fallback;
+}
+
+std::string_view JsonValue::asString() const {
+    return type == Type::STRING ? std::string_view{string} : std::string_view{};
+}
+
+int JsonValue::intMember(std::string_view key, int fallback) const {
+    const JsonValue *member = find(key);
+    return member ? member->asInt(fallback) : fallback;
+}
+
+double JsonValue::numberMember(std::string_view key, double fallback) const {
+    const JsonValue *member = find(key);
+    return member ? member->asNumber(fallback) : fallback;
+}
+
+std::string_view JsonValue::stringMember(std::string_view key) const {
+    const JsonValue *member = find(key);
+    return member ? member->asString() : std::string_view{};
+}
+
+int parseJson(std::string_view text, JsonValue &root) {
+    JsonParser parser{text};
+    root = JsonValue{};
+    if (!parser.parseValue(root)) {
+        std::cerr << "JSON parse error near offset " << parser.position << std::endl;
+        return -1;
+    }
+    parser.skipWhitespace();
+    if (parser.position != text.size()) {
+        std::cerr << "Unexpected trailing characters in JSON at offset " << parser.position << std::endl;
+        return -1;
+    }
+    return 0;
+}
@@ -0,0 +1,253 @@
+#include <lod.h>
+#include <mesh_optimize.h>
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <unordered_map>
+
+namespace {
+
+// Symmetric 4x4 matrix, upper triangle row by row
+struct Quadric {
+    double m[10] = {};
+
+    static Quadric plane(double a, double b, double c, double d) {
+        Quadric q;
+        q.m[0] = a * a; q.m[1] = a * b; q.m[2] = a * c; q.m[3] = a * d;
+        q.m[4] = b * b; q.m[5] = b * c; q.m[6] = b * d;
+        q.m[7] = c * c; q.m[8] = c * d;
+        q.m[9] = d * d;
+        return q;
+    }
+
+    Quadric &operator+=(const Quadric &other) {
+        for (int i = 0; i < 10; i++) {
+            m[i] += other.m[i];
+        }
+        return *this;
+    }
+
+    [[nodiscard]] double evaluate(const float p[3]) const {
+        const double x = p[0], y = p[1], z = p[2];
+        return m[0] * x * x + 2 * m[1] * x * y + 2 * m[2] * x * z + 2 * m[3] * x +
+               m[4] * y * y + 2 * m[5] * y * z + 2 * m[6] * y +
+               m[7] * z * z + 2 * m[8] * z +
+               m[9];
+    }
+};
+
+struct Collapse {
+    double cost;
+    unsigned int from;
+    unsigned int to;
+};
+
+void faceNormal(const float *a, const float *b, const float *c, double n[3]) {
+    const double e1[3] = {b[0] - a[0], b[1] - a[1], b[2] - a[2]};
+    const double e2[3] = {c[0] - a[0], c[1] - a[1], c[2] - a[2]};
+    n[0] = e1[1] * e2[2] - e1[2] * e2[1];
+    n[1] = e1[2] * e2[0] - e1[0] * e2[2];
+    n[2] = e1[0] * e2[1] - e1[1] * e2[0];
+}
+
+} // namespace
+
+float simplifyMesh(const MeshData &mesh, const unsigned int *indices, std::size_t indexCount,
+                   std::size_t targetIndexCount, float targetError, std::vector<unsigned int> &out) {
+    const std::size_t vertexCount = mesh.vertices.size();
+    const std::size_t triangleCount = indexCount / 3;
+    std::vector<unsigned int> triangles(indices, indices + triangleCount * 3);
+    std::vector<bool> triangleAlive(triangleCount, true);
+    std::vector<std::vector<unsigned int>> vertexTriangles(vertexCount);
+    std::vector<Quadric> quadrics(vertexCount);
+
+    // Plane quadrics, and edge use counts to find the boundaries (which also covers attribute seams, since
+    // split vertices make the index topology open there)
+    std::unordered_map<std::uint64_t, unsigned int> edgeUses;
+    edgeUses.reserve(indexCount);
+    for (std::size_t t = 0; t < triangleCount; t++) {
+        const unsigned int *tri = &triangles[t * 3];
+        double n[3];
+        faceNormal(mesh.vertices[tri[0]].position, mesh.vertices[tri[1]].position, mesh.vertices[tri[2]].position, n);
+        const double length = std::sqrt(n[0] * n[0] + n[1] * n[1] + n[2] * n[2]);
+        if (length > 0.0) {
+            n[0] /= length; n[1] /= length; n[2] /= length;
+            const float *p = mesh.vertices[tri[0]].position;
+            const Quadric q = Quadric::plane(n[0], n[1], n[2], -(n[0] * p[0] + n[1] * p[1] + n[2] * p[2]));
+            for (int k = 0; k < 3; k++) {
+                quadrics[tri[k]] += q;
+            }
+        }
+        for (int k = 0; k < 3; k++) {
+            vertexTriangles[tri[k]].push_back(static_cast<unsigned int>(t));
+            const unsigned int a = std::min(tri[k], tri[(k + 1) % 3]);
+            const unsigned int b = std::max(tri[k], tri[(k + 1) % 3]);
+            edgeUses[(std::uint64_t{a} << 32) | b]++;
+        }
+    }
+    std::vector<bool> locked(vertexCount, false);
+    for (const auto &[edge, uses] : edgeUses) {
+        if (uses != 2) {
+            locked[edge >> 32] = true;
+            locked[edge & 0xFFFFFFFF] = true;
+        }
+    }
+
+    std::size_t liveIndices = triangleCount * 3;
+    double maxCost = 0.0;
+    const double maxAllowedCost = static_cast<double>(targetError) * targetError;
+
+    auto flipsTriangle = [&](unsigned int u, unsigned int v) {
+        const float *target = mesh.vertices[v].position;
+        for (unsigned int t : vertexTriangles[u]) {
+            const unsigned int *tri = &triangles[t * 3];
+            if (tri[0] == v || tri[1] == v || tri[2] == v) {
+                continue;
+            }
+            const float *p[3], *moved[3];
+            for (int k = 0; k < 3; k++) {
+                p[k] = mesh.vertices[tri[k]].position;
+                moved[k] = tri[k] == u ? target : p[k];
+            }
+            double before[3], after[3];
+            faceNormal(p[0], p[1], p[2], before);
+            faceNormal(moved[0], moved[1], moved[2], after);
+            if (before[0] * after[0] + before[1] * after[1] + before[2] * after[2] <= 0.0) {
+                return true;
+            }
+        }
+        return false;
+    };
+
+    // Work in passes: every unlocked vertex proposes its cheapest collapse, the proposals are applied cheapest
+    // first and a vertex takes part in at most one collapse per pass. That keeps the result even (no vertex
+    // turns into a hub swallowing its whole neighbourhood) and the cost per pass linear.
+    std::vector<Collapse> collapses;
+    std::vector<bool> touched(vertexCount);
+    while (liveIndices > targetIndexCount) {
+        collapses.clear();
+        for (unsigned int u = 0; u < vertexCount; u++) {
+            if (locked[u] || vertexTriangles[u].empty()) {
+                continue;
+            }
+            Collapse best{std::numeric_limits<double>::max(), u, u};
+            for (unsigned int t : vertexTriangles[u]) {
+                for (int k = 0; k < 3; k++) {
+                    const unsigned int v = triangles[t * 3 + k];
+                    if (v == u) {
+                        continue;
+                    }
+                    Quadric q = quadrics[u];
+                    q += quadrics[v];
+                    const double cost = q.evaluate(mesh.vertices[v].position);
+                    if (cost < best.cost) {
+                        best = {cost, u, v};
+                    }
+                }
+            }
+            if (best.to != u && best.cost <= maxAllowedCost) {
+                collapses.push_back(best);
+            }
+        }
+        if (collapses.empty()) {
+            break;
+        }
+        std::sort(collapses.begin(), collapses.end(), [](const Collapse &a, const Collapse &b) {
+            return a.cost < b.cost;
+        });
+
+        std::fill(touched.begin(), touched.end(), false);
+        std::size_t applied = 0;
+        for (const Collapse &collapse : collapses) {
+            if (liveIndices <= targetIndexCount) {
+                break;
+            }
+            const unsigned int u = collapse.from;
+            const unsigned int v = collapse.to;
+            if (touched[u] || touched[v] || flipsTriangle(u, v)) {
+                continue;
+            }
+
+            // Move u's triangles to v, dropping the ones that degenerate
+            for (unsigned int t : vertexTriangles[u]) {
+                unsigned int *tri = &triangles[t * 3];
+                if (tri[0] == v || tri[1] == v || tri[2] == v) {
+                    triangleAlive[t] = false;
+                    liveIndices -= 3;
+                    for (int k = 0; k < 3; k++) {
+                        if (tri[k] != u) {
+                            auto &list = vertexTriangles[tri[k]];
+                            list.erase(std::find(list.begin(), list.end(), t));
+                        }
+                    }
+                } else {
+                    for (int k = 0; k < 3; k++) {
+                        if (tri[k] == u) {
+                            tri[k] = v;
+                        }
+                    }
+                    vertexTriangles[v].push_back(t);
+                }
+            }
+            vertexTriangles[u].clear();
+            quadrics[v] += quadrics[u];
+            maxCost = std::max(maxCost, collapse.cost);
+            touched[u] = touched[v] = true;
+            applied++;
+        }
+        if (applied == 0) {
+            break;
+        }
+    }
+
+    out.clear();
+    out.reserve(liveIndices);
+    for (std::size_t t = 0; t < triangleCount; t++) {
+        if (triangleAlive[t]) {
+            out.insert(out.end(), &triangles[t * 3], &triangles[t * 3] + 3);
+        }
+    }
+    return static_cast<float>(std::sqrt(std::max(maxCost, 0.0)));
+}
+
+void buildLodChain(MeshData &mesh, std::vector<MeshLod> &lods, unsigned int maxLods, float ratio) {
+    lods.clear();
+    lods.push_back({0, static_cast<std::uint32_t>(mesh.indices.size()), 0.0f, 0});
+
+    std::vector<unsigned int> current(mesh.indices);
+    std::vector<unsigned int> simplified;
+    float error = 0.0f;
+
+    for (unsigned int level = 1; level < std::min(maxLods, MAX_MESH_LODS); level++) {
+        const std::size_t target = static_cast<std::size_t>(static_cast<float>(current.size() / 3) * ratio) * 3;
+        const float stepError = simplifyMesh(mesh, current.data(), current.size(), target,
+                                             std::numeric_limits<float>::max(), simplified);
+        if (simplified.empty() || simplified.size() * 10 > current.size() * 9) {
+            break;
+        }
+        optimizeVertexCache(simplified, mesh.vertices.size());
+
+        // Each level is simplified from the previous one, so errors add up
+        error += stepError;
+        lods.push_back({static_cast<std::uint32_t>(mesh.indices.size()), static_cast<std::uint32_t>(simplified.size()),
+                        error, 0});
+        mesh.indices.insert(mesh.indices.end(), simplified.begin(), simplified.end());
+        current.swap(simplified);
+    }
+}
+
+float projectionScale(float viewportHeight, float fovY) {
+    return viewportHeight / (2.0f * std::tan(fovY * 0.5f));
+}
+
+unsigned int selectLod(const MeshLod *lods, std::size_t lodCount, float distance, float projectionScale,
+                       float pixelThreshold) {
+    const float pixelsPerUnit = projectionScale / std::max(distance, 1e-4f);
+    for (std::size_t lod = lodCount; lod-- > 1;) {
+        if (lods[lod].error * pixelsPerUnit <= pixelThreshold) {
+            return static_cast<unsigned int>(lod);
+        }
+    }
+    return 0;
+}
@@ -1,26 +1,86 @@
 #include <GLEW/glew.h>
 #include <GLFW/glfw3.h>
 
+#include <algorithm>
+#include <cstddef>
 #include <iostream>
-#include <fstream>
-#include <sstream>
-#include <filesystem>
-#include <valarray>
+#include <random>
+#include <thread>
 
 #define STB_IMAGE_IMPLEMENTATION
 #include <stb_image.h>
 
-struct ShaderSources {
-    std::string vertex;
-    std::string fragment;
+#include <mesh.h>
+#include <meshlet.h>
+#include <lod.h>
+#include <render_queue.h>
+#include <command_buffer.h>
+#include <job_system.h>
+#include <frame_pipeline.h>
+#include <fixed_timestep.h>
+#include <ecs.h>
+#include <vector_math.h>
+#include <transform_hierarchy.h>
+#include <bvh.h>
+#include <occlusion.h>
+#include <uniform_buffer.h>
+#include <shader.h>
+#include <resources.h>
+#include <frame_capture.h>
+#include <dynamic_resolution.h>
+#include <post_process.h>
+#include <profiler.h>
+#include <render_graph.h>
+#include <clustered_lighting.h>
+
+// Components of the animated quad
+struct Oscillator {
+    float phase;
+    float angularSpeed;
 };
 
-void framebufferSizeCallback(GLFWwindow * window, int width, int height);
+struct Offset {
+    float x, y;
+};
+
+struct ColorShift {
+    float value;
+};
+
+// Per-draw parameters, mirrored by the `Draw` block of 3colors.shader
+struct DrawBlock {
+    vec4 positionScale; // xyz
+    vec4 positionBias;  // xyz
+    vec4 colorShift;    // x
+};
+
+// What the renderer needs of the scene, captured after every fixed step and blended for rendering
+struct SceneState {
+    float shift;
+    float offset[2];
+};
+
+// Point lights drifting in small circles just in front of the quad, as structure of arrays for the animation
+struct LightField {
+    std::vector<float> anchorX, anchorY, orbit, phase, speed;
+    std::vector<float> angles, sines, cosines;
+    std::vector<PointLight> lights;
+};
+
+constexpr double SIMULATION_HZ = 60.0;
+// GPU time the scene may take before its resolution drops, leaving room in a 60 Hz frame for the rest
+constexpr float SCENE_BUDGET_MS = 12.0f;
+constexpr std::size_t POINT_LIGHT_COUNT = 4096;
+
+void animateScene(World &world, double time);
+SceneState captureScene(World &world, Entity quad);
+SceneState interpolateScene(const SceneState &previous, const SceneState &current, float alpha);
+void initLightField(LightField &field, std::size_t count);
+void animateLights(LightField &field, float time);
+int renderMain(GLFWwindow * window, FramePipeline &pipeline, std::string_view capturePath);
 void processInput(GLFWwindow * window);
-int parseShaders(std::string_view shaderPath, ShaderSources &sources);
-int compileAndLinkShaders(const ShaderSources& sources, unsigned int &shaderProgram);
 
-int main()
+int main(int argc, char **argv)
 {
     using namespace std;
     GLFWwindow * window;
@@ -42,6 +102,120 @@ int main()
         return -1;
     }
 
+    // Worker threads for simulation, asset loading and culling; this thread is worker 0
+    initJobSystem();
+
+    // Assets come from the packed archive when it was built, loose files under res/ otherwise. Both are looked up
+    // next to the executable, so it does not have to be started from the build directory.
+    setResourceRoot(executableDirectory());
+    if (mountResourcePack("res.pack") != 0) {
+        std::cerr << "No resource pack, reading loose files" << std::endl;
+    }
+
+    // --lockstep simulates exactly one step per frame so benchmark runs do not depend on the display rate,
+    // --capture <file.y4m | prefix> records every rendered frame as a video stream or numbered PNGs
+    FixedTimestep clock = makeFixedTimestep(SIMULATION_HZ);
+    std::string_view capturePath;
+    for (int i = 1; i < argc; i++) {
+        if (std::string_view(argv[i]) == "--lockstep") {
+            clock.lockstep = true;
+        } else if (std::string_view(argv[i]) == "--capture" && i + 1 < argc) {
+            capturePath = argv[++i];
+        }
+    }
+
+    // The GL context belongs to the render thread, this one keeps events, input and simulation
+    FramePipeline pipeline;
+    int renderResult = 0;
+    std::thread renderThread([&] {
+        renderResult = renderMain(window, pipeline, capturePath);
+        // Rendering only stops on its own when loading failed, take the main loop down with it
+        closeFramePipeline(pipeline);
+        glfwSetWindowShouldClose(window, true);
+    });
+
+    World world;
+    const Entity quad = createEntity(world, componentMask<Oscillator, Offset, ColorShift>());
+    getComponent<Oscillator>(world, quad)->angularSpeed = 2.0f;
+    animateScene(world, 0.0);
+    SceneState previousState = captureScene(world, quad);
+    SceneState currentState = previousState;
+
+    // Loop until the user closes the window
+    while (!glfwWindowShouldClose(window))
+    {
+        processInput(window);
+
+        for (unsigned int step = advanceFixedTimestep(clock, glfwGetTime()); step-- > 0;) {
+            previousState = currentState;
+            animateScene(world, simulationTime(clock) - step * clock.step);
+            currentState = captureScene(world, quad);
+        }
+
+        FramePacket *packet = beginFramePacket(pipeline);
+        if (!packet) {
+            break;
+        }
+        const float alpha = interpolationAlpha(clock);
+        const SceneState state = interpolateScene(previousState, currentState, alpha);
+        packet->time = std::max(simulationTime(clock) - (1.0 - alpha) * clock.step, 0.0);
+        packet->shift = state.shift;
+        packet->offset[0] = state.offset[0];
+        packet->offset[1] = state.offset[1];
+
+        glfwGetFramebufferSize(window, &packet->framebufferWidth, &packet->framebufferHeight);
+        publishFramePacket(pipeline);
+
+        // Poll for and process events
+        glfwPollEvents();
+    }
+
+    closeFramePipeline(pipeline);
+    renderThread.join();
+    shutdownJobSystem();
+    glfwTerminate();
+    return renderResult;
+}
+
+void animateScene(World &world, double time) {
+    const auto t = static_cast<float>(time);
+    parallelForEach<const Oscillator, Offset, ColorShift>(world, 16 * 1024, [t](
+            std::size_t count, const Oscillator *oscillators, Offset *offsets, ColorShift *shifts) {
+        // Angles go through the SIMD sin/cos a block at a time
+        constexpr std::size_t BLOCK = 256;
+        float angles[BLOCK], sines[BLOCK], cosines[BLOCK];
+        for (std::size_t first = 0; first < count; first += BLOCK) {
+            const std::size_t size = std::min(BLOCK, count - first);
+            for (std::size_t i = 0; i < size; i++) {
+                angles[i] = oscillators[first + i].phase + t * oscillators[first + i].angularSpeed;
+            }
+            sinCos(angles, sines, cosines, size);
+            for (std::size_t i = 0; i < size; i++) {
+                // greenColor uniform
+                shifts[first + i].value = sines[i] / 2.0f + .5f;
+
+                // hOffset uniform
+                offsets[first + i].x = cosines[i] / 2.0f;
+                offsets[first + i].y = sines[i] / 2.0f;
+            }
+        }
+    });
+}
+
+SceneState captureScene(World &world, Entity quad) {
+    const Offset &offset = *getComponent<Offset>(world, quad);
+    return {getComponent<ColorShift>(world, quad)->value, {offset.x, offset.y}};
+}
+
+SceneState interpolateScene(const SceneState &previous, const SceneState &current, float alpha) {
+    auto lerp = [alpha](float a, float b) { return a + (b - a) * alpha; };
+    return {
+            lerp(previous.shift, current.shift),
+            {lerp(previous.offset[0], current.offset[0]), lerp(previous.offset[1], current.offset[1])}
+    };
+}
+
+int renderMain(GLFWwindow * window, FramePipeline &pipeline, std::string_view capturePath) {
     // Make the window's context current
     glfwMakeContextCurrent(window);
 
@@ -52,64 +226,104 @@ int main()
         std::cerr << "GLEW encountered a problem while initializing: " << glewGetErrorString(err) << std::endl;
     }
 
-    glViewport(0, 0, 800, 800);
-    glfwSetFramebufferSizeCallback(window, framebufferSizeCallback);
+    // Loading and culling go wide from here, this thread stays the only one talking to GL
+    attachJobThread();
 
-    float vertices[] = {
-               -0.5f,  0.5f, 0.0f, 1.0f,  0.96f, 0.87f,
-               -0.5f, -0.5f, 0.0f, 1.0f,  0.41f, 0.41f,
-                0.5f, -0.5f, 0.0f, 0.78f, 0.0f,  0.22f,
-                0.5f,  0.5f, 0.0f, 0.07f, 0.11f, 0.27f,
+    // Geometry, mapped straight from the binary mesh cache. Positions are quantized against the mesh bounds,
+    // the vertex shader turns them back into object space with positionScale/positionBias.
+    const VertexFormat vertexFormat{
+            PositionFormat::UNORM16,
+            NormalFormat::OCTAHEDRAL16,
+            UvFormat::HALF,
+            ColorFormat::UNORM8
     };
+    MeshCacheView mesh;
+    if (loadMesh("res/meshes/quad.obj", vertexFormat, mesh) != 0) {
+        std::cerr << "Could not load mesh" << std::endl;
+        return -1;
+    }
 
-    unsigned int indices[] = {
-            0, 1, 2,
-            0, 2, 3
+    // Shaders, compiled per keyword combination the first time it is drawn with. Per-draw parameters go through
+    // uniform blocks: world matrices from the transform buffer, everything else written by the recording threads
+    // into this frame's share of the uniform ring.
+    ShaderIncludeCache shaderIncludes;
+    ShaderVariants colorShaders;
+    colorShaders.blockBindings = {
+            {"Transform", BINDING_TRANSFORM, sizeof(mat4), {{"model", 0}}},
+            {"Draw", BINDING_DRAW, sizeof(DrawBlock), {{"positionScale", offsetof(DrawBlock, positionScale)},
+                                                       {"positionBias", offsetof(DrawBlock, positionBias)},
+                                                       {"colorShift", offsetof(DrawBlock, colorShift)}}},
+            {"Clusters", BINDING_CLUSTERS, sizeof(ClusterBlock), {{"view", offsetof(ClusterBlock, view)},
+                                                                  {"clusterGrid", offsetof(ClusterBlock, grid)},
+                                                                  {"clusterScale", offsetof(ClusterBlock, scale)}}}
     };
-
-    // Vertex Buffer
-    unsigned int vertexBuffer;
-    glGenBuffers(1, &vertexBuffer);
-    glBindBuffer(GL_ARRAY_BUFFER, vertexBuffer);
-    glBufferData(GL_ARRAY_BUFFER, sizeof(vertices), &vertices, GL_STATIC_DRAW); // move vertices to GL_ARRAY_BUFFER
-
-
-    // Element Buffer
-    unsigned int elementBuffer;
-    glGenBuffers(1, &elementBuffer);
-    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, elementBuffer);
-    glBufferData(GL_ELEMENT_ARRAY_BUFFER, sizeof(indices), &indices, GL_STATIC_DRAW);
-
-    // Shaders
-    ShaderSources sources;
-    if (parseShaders("res/shaders/3colors.shader", sources) != 0) {
+    if (loadShaderVariants("res/shaders/3colors.shader", colorShaders, shaderIncludes) != 0) {
         std::cerr << "Could not parse shaders" << std::endl;
         return -1;
     }
 
-    unsigned int shaderProgram;
-    if (compileAndLinkShaders(sources, shaderProgram) != 0) {
+    const unsigned int shaderProgram = getShaderVariant(
+            colorShaders, keywordMask(colorShaders.sources, {"COLOR_SHIFT", "CLUSTERED_LIGHTING"}));
+    if (shaderProgram == 0) {
         std::cerr << "Could not compile or use shaders" << std::endl;
         return -1;
     }
-
-    // Define vertices format
-    glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, 3 * sizeof(float), nullptr);
+    setClusterSamplers(shaderProgram);
 
     // Vertex array
     unsigned int vertexArray;
     glGenVertexArrays(1, &vertexArray);
     glBindVertexArray(vertexArray);
+
+    // Vertex Buffer
+    unsigned int vertexBuffer;
+    glGenBuffers(1, &vertexBuffer);
     glBindBuffer(GL_ARRAY_BUFFER, vertexBuffer);
-    glBufferData(GL_ARRAY_BUFFER, sizeof(vertices), vertices, GL_STATIC_DRAW);
-    glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, 6 * sizeof(float), nullptr);
-    glEnableVertexAttribArray(0); // zero because it's the first and only (for now)
-    glVertexAttribPointer(1, 3, GL_FLOAT, GL_FALSE, 6 * sizeof(float), (void *) (3 * sizeof(float)));
-    glEnableVertexAttribArray(1);
+    glBufferData(GL_ARRAY_BUFFER, mesh.vertexCount * mesh.layout.stride, mesh.vertexData, GL_STATIC_DRAW);
+
+    // Element Buffer
+    unsigned int elementBuffer;
+    glGenBuffers(1, &elementBuffer);
+    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, elementBuffer);
+    glBufferData(GL_ELEMENT_ARRAY_BUFFER, mesh.indexCount * sizeof(unsigned int), mesh.indices, GL_STATIC_DRAW);
+
+    // Define vertices format
+    applyVertexLayout(mesh.layout);
+
+    const std::vector<Meshlet> meshlets(mesh.meshlets, mesh.meshlets + mesh.meshletCount);
+    const Aabb meshBox{
+            {mesh.bounds.min[0], mesh.bounds.min[1], mesh.bounds.min[2]},
+            {mesh.bounds.max[0], mesh.bounds.max[1], mesh.bounds.max[2]}
+    };
+    const std::vector<MeshLod> lods(mesh.lods, mesh.lods + mesh.lodCount);
+
+    // Draws go through the render queue, which sorts them by state before touching GL
+    RenderQueue renderQueue;
+    initRenderQueue(renderQueue);
+    const unsigned int colorMaterial = addMaterial(renderQueue, {});
+    CommandRecorder commandRecorder;
+    std::vector<MeshletCullStats> meshletStats(jobWorkerCount()); // per command buffer, summed over the run
+
+    UniformRing uniformRing;
+    initUniformRing(uniformRing);
+    const PositionDecode decode = positionDecode(mesh.layout.format.position, mesh.bounds);
+
+    // The coarsest LOD, decoded back to floats, stands in for the mesh when it is rasterized as an occluder
+    std::vector<float> occluderPositions;
+    unpackPositions(mesh.vertexData, mesh.vertexCount, mesh.layout, mesh.bounds, occluderPositions);
+    const std::vector<unsigned int> occluderIndices = lods.empty()
+            ? std::vector<unsigned int>(mesh.indices, mesh.indices + mesh.indexCount)
+            : std::vector<unsigned int>(mesh.indices + lods.back().firstIndex,
+                                        mesh.indices + lods.back().firstIndex + lods.back().indexCount);
+    closeResource(mesh.resource); // the data lives in the buffers now
 
     // Loading texture
-    int width, height, nrChannels;
-    unsigned char *data = stbi_load("res/images/container.jpg", &width, &height, &nrChannels, 0);
+    int width = 0, height = 0, nrChannels = 0;
+    unsigned char *data = nullptr;
+    if (ResourceData image; openResource("res/images/container.jpg", image) == 0) {
+        data = stbi_load_from_memory(image.bytes.data(), static_cast<int>(image.bytes.size()), &width, &height,
+                                     &nrChannels, 0);
+    }
 
     unsigned int texture;
     glGenTextures(1, &texture);
@@ -129,154 +343,287 @@ int main()
 
     stbi_image_free(data);
 
-    // Loop until the user closes the window
-    while (!glfwWindowShouldClose(window))
+    // Scene graph: the quad hangs off a root node and follows the simulated offset, its world matrix reaches the
+    // shader through the transform buffer instead of a per-draw uniform
+    TransformHierarchy transforms;
+    const std::uint32_t sceneRoot = addTransform(transforms, NO_PARENT, {0.0f, 0.0f, 0.0f});
+    const std::uint32_t quadNode = addTransform(transforms, sceneRoot, {0.0f, 0.0f, 0.0f});
+    TransformBuffer transformBuffer;
+    initTransformBuffer(transformBuffer);
+
+    // Objects are culled against the view through a BVH of their world boxes before anything is recorded
+    Bvh sceneBvh;
+    updateWorldMatrices(transforms);
+    const std::uint32_t quadLeaf = insertBvhLeaf(sceneBvh, transformAabb(transforms.worldMatrices[quadNode], meshBox),
+                                                 quadNode);
+    std::vector<std::uint32_t> visibleObjects;
+
+    // Nodes rasterized into the software depth buffer, all drawn with the mesh's occluder LOD. An object never
+    // occludes itself, so the quad is not one of them and the list stays empty until the scene has real occluders;
+    // occlusion_benchmark exercises the same path against a wall in front of a grid of boxes.
+    const std::vector<std::uint32_t> occluderNodes;
+    OcclusionBuffer occlusion;
+    OcclusionStats occlusionTotals;
+
+    // The scene renders offscreen at a resolution that keeps its GPU time within budget
+    DynamicResolution resolution;
+    initDynamicResolution(resolution, SCENE_BUDGET_MS);
+
+    // Each frame is a render graph: the scene pass, then bloom, tonemapping, grading and FXAA at window size on the
+    // upscaled scene. Its intermediate textures come from the pool and are timed per pass into the profiler.
+    RenderTargetPool renderTargets;
+    PostProcess postProcess;
+    if (initPostProcess(postProcess, shaderIncludes) != 0) {
+        return -1;
+    }
+    RenderGraph renderGraph;
+    Profiler profiler;
+
+    // The quad is lit by thousands of point lights through clustered shading. The scene has no projection yet, so
+    // the froxels come from a camera 10 units up +z with a "projection" undoing it, the quad sits at view depth 10.
+    LightField lightField;
+    initLightField(lightField, POINT_LIGHT_COUNT);
+    ClusteredLighting clusters;
+    initClusteredLighting(clusters);
+    const mat4 clusterView = translation({0.0f, 0.0f, -10.0f});
+    const mat4 clusterProjection = translation({0.0f, 0.0f, 10.0f});
+
+    // Frames are captured at the size of the first one
+    FrameCapture capture;
+    bool capturing = false;
+
+    // Render frames as the main thread hands them over
+    while (const FramePacket *packet = acquireFramePacket(pipeline))
     {
-        processInput(window);
+        const int viewportWidth = packet->framebufferWidth;
+        const int viewportHeight = packet->framebufferHeight;
+        if (!capturePath.empty() && capture.width == 0) {
+            capturing = initFrameCapture(capture, capturePath, viewportWidth, viewportHeight,
+                                         static_cast<int>(SIMULATION_HZ)) == 0;
+        }
 
         // Render here
-        glClearColor(0.07f / 3.2f, 0.11f / 3.2f, 0.27f / 3.2f, 1.0f / 3.2f);
-        glClear(GL_COLOR_BUFFER_BIT);
-
-        glUseProgram(shaderProgram);
-
-        auto time = (float) glfwGetTime();
-
-        // greenColor uniform
-        float shift = std::sin(time * 2.0f) / 2.0f + .5f;
-        int shiftColourUniform = glGetUniformLocation(shaderProgram, "shiftColor");
-        glUniform1f(shiftColourUniform, shift);
-
-        // hOffset uniform
-        float offset[2] = {
-                static_cast<float>(std::cos(time * 2.0f) / 2.0f),
-                static_cast<float>(std::sin(time * 2.0f) / 2.0f)
-        };
-        int offsetUniform = glGetUniformLocation(shaderProgram, "offset");
-        glUniform2f(offsetUniform, offset[0], offset[1]);
+        updateDynamicResolution(resolution, viewportWidth, viewportHeight);
+
+        // Light lists for this frame's render size, assigned on the worker threads
+        animateLights(lightField, static_cast<float>(packet->time));
+        buildClusters(clusters, lightField.lights, clusterView, clusterProjection, 9.0f, 11.0f,
+                      resolution.renderWidth, resolution.renderHeight);
+        recordProfileSample(profiler, "clusters (cpu)", clusters.stats.buildMilliseconds);
+
+        const float shift = packet->shift;
+        setLocalPosition(transforms, quadNode, {packet->offset[0], packet->offset[1], 0.0f});
+        updateWorldMatrices(transforms);
+        uploadTransforms(transformBuffer, transforms);
+
+        // The scene is still drawn straight in clip space, so the quad's world matrix is the whole view projection
+        // and the camera sits on +z looking down at it (both expressed in object space for the culling)
+        const mat4 &quadWorld = transforms.worldMatrices[quadNode];
+        const vec3 camera = transformPoint(inverse(quadWorld), {0.0f, 0.0f, 10.0f});
+        const float cameraPosition[3] = {camera.x, camera.y, camera.z};
+
+        // In world space the view projection is the identity, only objects whose box reaches it get recorded
+        moveBvhLeaf(sceneBvh, quadLeaf, transformAabb(quadWorld, meshBox));
+        const mat4 viewProjection = identity();
+        queryBvh(sceneBvh, extractFrustum(&viewProjection.columns[0].x), visibleObjects);
+
+        // Visible occluders go into the software depth buffer, then every other frustum survivor is tested against
+        // its hierarchical-Z pyramid so hidden objects are never recorded
+        bool quadVisible = std::ranges::find(visibleObjects, quadNode) != visibleObjects.end();
+        if (!occluderNodes.empty()) {
+            beginOcclusionBuffer(occlusion);
+            for (const std::uint32_t node : occluderNodes) {
+                if (std::ranges::find(visibleObjects, node) != visibleObjects.end()) {
+                    rasterizeOccluder(occlusion, viewProjection * transforms.worldMatrices[node],
+                                      occluderPositions.data(), occluderIndices.data(), occluderIndices.size());
+                }
+            }
+            buildDepthPyramid(occlusion);
+            if (quadVisible && std::ranges::find(occluderNodes, quadNode) == occluderNodes.end()) {
+                quadVisible = !isOccluded(occlusion, viewProjection, transformAabb(quadWorld, meshBox));
+            }
+            occlusionTotals.occluderTriangles += occlusion.stats.occluderTriangles;
+            occlusionTotals.tested += occlusion.stats.tested;
+            occlusionTotals.occluded += occlusion.stats.occluded;
+        }
 
-        glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, elementBuffer);
-        glDrawElements(GL_TRIANGLES, 6, GL_UNSIGNED_INT, nullptr);
+        // In clip space one object unit spans half the framebuffer height, at a constant "distance" of 1
+        const unsigned int lod = selectLod(lods.data(), lods.size(), 1.0f,
+                                           static_cast<float>(resolution.renderHeight) * 0.5f);
+
+        // Worker threads cull their share of the meshlets and record the survivors, only this thread talks to GL
+        const Frustum frustum = extractFrustum(&quadWorld.columns[0].x);
+        const std::size_t meshletCount = quadVisible && lod == 0 ? meshlets.size() : 0;
+        beginUniformFrame(uniformRing);
+        const UniformAllocation clusterBlock = pushUniforms(uniformRing, clusters.block);
+        recordCommandsParallel(commandRecorder, meshletCount, 4096,
+                               [&](CommandBuffer &buffer, std::size_t begin, std::size_t end) {
+            if (!quadVisible) {
+                return;
+            }
+            thread_local std::vector<DrawElementsIndirectCommand> culled;
+            culled.clear();
+            if (lod == 0) {
+                const auto bufferIndex = static_cast<std::size_t>(&buffer - commandRecorder.buffers.data());
+                MeshletCullStats &stats = meshletStats[bufferIndex];
+                cullMeshlets(meshlets.data(), begin, end, frustum, cameraPosition, culled, stats);
+                stats.draws += culled.size();
+            } else {
+                // Simplified levels are small enough to go out as a single draw
+                culled.push_back({lods[lod].indexCount, 1, lods[lod].firstIndex, 0, 0});
+            }
+            recordBindProgram(buffer, shaderProgram);
+            recordBindVertexArray(buffer, vertexArray);
+            recordBindTexture(buffer, texture);
+            recordSetMaterial(buffer, colorMaterial);
+
+            const UniformAllocation drawBlock = pushUniforms(uniformRing, DrawBlock{
+                    {decode.scale[0], decode.scale[1], decode.scale[2], 0.0f},
+                    {decode.bias[0], decode.bias[1], decode.bias[2], 0.0f},
+                    {shift, 0.0f, 0.0f, 0.0f}
+            });
+            if (!drawBlock.data) {
+                return; // the ring is full this frame; counted in overflows and grown before the next one
+            }
+            recordBindUniformBlock(buffer, {BINDING_TRANSFORM, transformBuffer.buffer,
+                                            static_cast<std::uint32_t>(quadNode * transformBuffer.stride),
+                                            sizeof(mat4)});
+            recordBindUniformBlock(buffer, {BINDING_DRAW, uniformRing.buffer, drawBlock.offset, sizeof(DrawBlock)});
+            if (clusterBlock.data) {
+                recordBindUniformBlock(buffer, {BINDING_CLUSTERS, uniformRing.buffer, clusterBlock.offset,
+                                                sizeof(ClusterBlock)});
+            }
+            recordDraw(buffer, RenderPass::SOLID, 0.5f, culled);
+        });
+        endUniformFrame(uniformRing);
+
+        beginRenderQueue(renderQueue);
+        submitCommandBuffers(renderQueue, commandRecorder.buffers);
+        releaseFramePacket(pipeline); // everything from the packet is in the queue now
+        sortRenderQueue(renderQueue);
+
+        // The scene renders at the dynamic resolution and is upscaled into an HDR texture at window size, the
+        // post-processing passes take it from there to the window
+        beginRenderGraph(renderGraph);
+        const GraphTexture sceneColor = createGraphTexture(renderGraph, "scene color", viewportWidth, viewportHeight,
+                                                           RenderTargetFormat::RGBA16F);
+        const GraphTexture windowTarget = importGraphTexture(renderGraph, "window",
+                                                             RenderTarget{0, 0, viewportWidth, viewportHeight});
+        const GraphPass scenePass = addGraphPass(renderGraph, "scene", [&, sceneColor](const RenderGraph &graph) {
+            beginDynamicResolution(resolution);
+            glClearColor(0.07f / 3.2f, 0.11f / 3.2f, 0.27f / 3.2f, 1.0f / 3.2f);
+            glClear(GL_COLOR_BUFFER_BIT);
+            bindClusters(clusters);
+            executeRenderQueue(renderQueue);
+            endDynamicResolution(resolution, graphTarget(graph, sceneColor).framebuffer);
+        });
+        writeGraphTexture(renderGraph, scenePass, sceneColor);
+        addPostProcessPasses(postProcess, renderGraph, sceneColor, windowTarget);
+        if (compileRenderGraph(renderGraph) == 0) {
+            executeRenderGraph(renderGraph, renderTargets, profiler);
+        }
+        trimRenderTargets(renderTargets);
+        if (capturing) {
+            captureFrame(capture, viewportWidth, viewportHeight);
+        }
 
         // Swap front and back buffers
         glfwSwapBuffers(window);
-
-        // Poll for and process events
-        glfwPollEvents();
     }
 
-    glfwTerminate();
-    return 0;
-}
-
-void framebufferSizeCallback(GLFWwindow * window, int width, int height) {
-    glViewport(0, 0, width, height);
-}
-
-void processInput(GLFWwindow * window) {
-    if (glfwGetKey(window, GLFW_KEY_ESCAPE) == GLFW_PRESS) {
-        glfwSetWindowShouldClose(window, true);
+    if (capturing) {
+        finishFrameCapture(capture);
+        const FrameCaptureStats stats = frameCaptureStats(capture);
+        const double frames = static_cast<double>(std::max<std::uint64_t>(stats.captured, 1));
+        std::cout << "Captured " << stats.captured << " frames (" << stats.dropped << " dropped), "
+                  << stats.renderThreadMilliseconds / frames << " ms per frame on the render thread, "
+                  << stats.encodeMilliseconds / frames << " ms per frame encoding, " << stats.readbackStalls
+                  << " readback stalls, " << stats.encoderStalls << " encoder stalls, " << stats.bytesWritten
+                  << " bytes written" << std::endl;
     }
-}
-
-int parseShaders(const std::string_view shaderPath, ShaderSources &sources) {
-
-    enum class ShaderType {
-        NONE = -1, VERTEX = 0, FRAGMENT = 1
-    };
-
-    if (!std::filesystem::exists(shaderPath)) {
-        std::cerr << "The file " << shaderPath.data() << " does not exist" << std::endl;
-        return -1;
-    }
-    std::ifstream file{};
-    file.open(shaderPath.data());
-
-    if ((file.rdstate() & file.fail()) != 0) {
-        std::cerr << "Failed to open " << shaderPath.data() << std::endl;
-        return -1;
+    if (occluderNodes.empty()) {
+        std::cout << "Occlusion: no occluders in the scene" << std::endl;
+    } else {
+        std::cout << "Occlusion: " << occlusionTotals.tested << " objects tested, " << occlusionTotals.occluded
+                  << " occluded, " << occlusionTotals.occluderTriangles << " occluder triangles rasterized"
+                  << std::endl;
     }
-    std::stringstream sstream[2];
-    std::string line;
-
-    ShaderType currentMode = ShaderType::NONE;
-    int lineCount = 0;
-    while (std::getline(file, line)) {
-        lineCount++;
-        if (line.find("#shader") != std::string::npos) {
-            if (line.find("vertex") != std::string::npos) {
-                currentMode = ShaderType::VERTEX;
-            } else if (line.find("fragment") != std::string::npos) {
-                currentMode = ShaderType::FRAGMENT;
-            } else {
-                std::cerr << "Shader type could not be found on line " << lineCount << std::endl;
-                return -1;
-            }
-        } else {
-            if (currentMode == ShaderType::NONE) {
-                std::cerr << "Your shader should have a descriptor on line 1 (ex: \"#shader vertex\")" << std::endl;
-                return -1;
-            }
-            sstream[(int)currentMode] << line << '\n';
-        }
+    MeshletCullStats meshletTotals;
+    for (const MeshletCullStats &stats : meshletStats) {
+        meshletTotals.tested += stats.tested;
+        meshletTotals.frustumCulled += stats.frustumCulled;
+        meshletTotals.backfaceCulled += stats.backfaceCulled;
+        meshletTotals.draws += stats.draws;
     }
-    file.close();
-
-    sources.vertex = sstream[(int)ShaderType::VERTEX].str();
-    sources.fragment = sstream[(int)ShaderType::FRAGMENT].str();
-
+    std::cout << "Meshlets: " << meshletTotals.tested << " tested, " << meshletTotals.frustumCulled
+              << " frustum culled, " << meshletTotals.backfaceCulled << " backface culled, " << meshletTotals.draws
+              << " draws" << std::endl;
+    const RenderQueueStats &queueStats = renderQueue.stats;
+    std::cout << "Render queue: " << queueStats.draws << " draws, " << queueStats.stateChanges << " state changes ("
+              << queueStats.unsortedStateChanges << " in submission order), " << queueStats.blockBinds
+              << " uniform block binds" << std::endl;
+    std::cout << "Uniform ring: " << uniformRing.frameSize / 1024 << " KiB per frame after " << uniformRing.grows
+              << " grows, " << uniformRing.overflows.load() << " allocations dropped on overflow" << std::endl;
+    const RenderGraphStats &graphStats = renderGraph.stats;
+    std::cout << "Render graph: " << graphStats.passes << " passes (" << graphStats.culledPasses << " culled), "
+              << graphStats.transientTextures << " transient textures in " << graphStats.allocations
+              << " allocations, " << (graphStats.transientBytes - graphStats.allocatedBytes) / 1024
+              << " KiB of VRAM saved by aliasing" << std::endl;
+    std::cout << "Clusters: " << clusters.stats.lights << " lights, " << clusters.stats.indices
+              << " cluster references, at most " << clusters.stats.maxClusterLights << " lights in a cluster"
+              << std::endl;
+    printProfile(profiler, std::cout);
+    destroyClusteredLighting(clusters);
+    destroyRenderGraph(renderGraph);
+    destroyPostProcess(postProcess);
+    destroyRenderTargetPool(renderTargets);
+    destroyDynamicResolution(resolution);
+    destroyUniformRing(uniformRing);
+    destroyShaderVariants(colorShaders);
+    glfwMakeContextCurrent(nullptr);
     return 0;
 }
 
-int compileAndLinkShaders(const ShaderSources& sources, unsigned int &shaderProgram) {
-    int shaderIds[2];
-    int shaderTypes[2] = {
-            GL_VERTEX_SHADER,
-            GL_FRAGMENT_SHADER
-    };
-    const char * source[2] = {
-            sources.vertex.c_str(),
-            sources.fragment.c_str()
-    };
-    shaderProgram = glCreateProgram();
 
-    for (int i = 0; i < 2; i++) {
-        shaderIds[i] = glCreateShader(shaderTypes[i]);
-        glShaderSource(shaderIds[i], 1, &source[i], nullptr);
-        glCompileShader(shaderIds[i]);
-
-        int success;
-        char log[512];
-        glGetShaderiv(shaderIds[i], GL_COMPILE_STATUS, &success);
-
-        if (!success) {
-            glGetShaderInfoLog(shaderIds[i], 512, nullptr, log);
-            std::cerr << "Shader compilation failed: " << log << std::endl;
-            return -1;
-        }
-
-        glAttachShader(shaderProgram, shaderIds[i]);
+void initLightField(LightField &field, std::size_t count) {
+    // Fixed seed, captures of the scene come out the same every run
+    std::mt19937 random(1234);
+    std::uniform_real_distribution<float> unit(0.0f, 1.0f);
+    field.lights.resize(count);
+    for (std::size_t i = 0; i < count; i++) {
+        field.anchorX.push_back(unit(random) * 2.2f - 1.1f);
+        field.anchorY.push_back(unit(random) * 2.2f - 1.1f);
+        field.orbit.push_back(0.02f + unit(random) * 0.08f);
+        field.phase.push_back(unit(random) * TWO_PI);
+        field.speed.push_back((unit(random) - 0.5f) * 4.0f);
+
+        PointLight &light = field.lights[i];
+        light.position.z = 0.02f + unit(random) * 0.1f;
+        light.radius = 0.04f + unit(random) * 0.06f;
+        // Bright saturated hues, a few overlapping lights push the surface past 1 into the bloom
+        const float hue = unit(random) * TWO_PI;
+        light.color = vec3{0.5f + 0.5f * std::cos(hue), 0.5f + 0.5f * std::cos(hue - TWO_PI / 3.0f),
+                           0.5f + 0.5f * std::cos(hue + TWO_PI / 3.0f)} * 0.6f;
     }
+    field.angles.resize(count);
+    field.sines.resize(count);
+    field.cosines.resize(count);
+}
 
-    glLinkProgram(shaderProgram);
-
-    { // Error handling
-        int success;
-        char log[512];
-        glGetProgramiv(shaderProgram, GL_LINK_STATUS, &success);
-
-        if (!success) {
-            glGetProgramInfoLog(shaderProgram, 512, nullptr, log);
-            std::cerr << "Shader program linking failed: " << log << std::endl;
-            return -1;
-        }
+void animateLights(LightField &field, float time) {
+    const std::size_t count = field.lights.size();
+    for (std::size_t i = 0; i < count; i++) {
+        field.angles[i] = field.phase[i] + field.speed[i] * time;
     }
-
-    glUseProgram(shaderProgram);
-
-    for (int shaderId : shaderIds) {
-        glDeleteShader(shaderId);
+    sinCos(field.angles.data(), field.sines.data(), field.cosines.data(), count);
+    for (std::size_t i = 0; i < count; i++) {
+        field.lights[i].position.x = field.anchorX[i] + field.cosines[i] * field.orbit[i];
+        field.lights[i].position.y = field.anchorY[i] + field.sines[i] * field.orbit[i];
     }
+}
 
-    return 0;
-}
\ No newline at end of file
+void processInput(GLFWwindow * window) {
+    if (glfwGetKey(window, GLFW_KEY_ESCAPE) == GLFW_PRESS) {
+        glfwSetWindowShouldClose(window, true);
+    }
+}
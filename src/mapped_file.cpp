@@ -0,0 +1,117 @@
+#include <mapped_file.h>
+
+#include <iostream>
+#include <string>
+#include <utility>
+
+#ifdef _WIN32
+#define WIN32_LEAN_AND_MEAN
+#define NOMINMAX
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+MappedFile::~MappedFile() {
+    close();
+}
+
+MappedFile::MappedFile(MappedFile &&other) noexcept {
+    *this = std::move(other);
+}
+
+MappedFile &MappedFile::operator=(MappedFile &&other) noexcept {
+    if (this != &other) {
+        close();
+        std::swap(m_data, other.m_data);
+        std::swap(m_size, other.m_size);
+#ifdef _WIN32
+        std::swap(m_file, other.m_file);
+        std::swap(m_mapping, other.m_mapping);
+#else
+        std::swap(m_fd, other.m_fd);
+#endif
+    }
+    return *this;
+}
+
+int MappedFile::open(std::string_view path) {
+    close();
+    const std::string filePath{path};
+
+#ifdef _WIN32
+    HANDLE file = CreateFileA(filePath.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING,
+                              FILE_ATTRIBUTE_NORMAL | FILE_FLAG_SEQUENTIAL_SCAN, nullptr);
+    if (file == INVALID_HANDLE_VALUE) {
+        std::cerr << "Failed to open " << filePath << std::endl;
+        return -1;
+    }
+    LARGE_INTEGER fileSize;
+    if (!GetFileSizeEx(file, &fileSize) || fileSize.QuadPart == 0) {
+        std::cerr << "Cannot map empty file " << filePath << std::endl;
+        CloseHandle(file);
+        return -1;
+    }
+    HANDLE mapping = CreateFileMappingA(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+    if (!mapping) {
+        std::cerr << "Failed to create a mapping for " << filePath << std::endl;
+        CloseHandle(file);
+        return -1;
+    }
+    void *view = MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0);
+    if (!view) {
+        std::cerr << "Failed to map " << filePath << std::endl;
+        CloseHandle(mapping);
+        CloseHandle(file);
+        return -1;
+    }
+    m_file = file;
+    m_mapping = mapping;
+    m_data = static_cast<const unsigned char *>(view);
+    m_size = static_cast<std::size_t>(fileSize.QuadPart);
+#else
+    int fd = ::open(filePath.c_str(), O_RDONLY);
+    if (fd < 0) {
+        std::cerr << "Failed to open " << filePath << std::endl;
+        return -1;
+    }
+    struct stat info{};
+    if (fstat(fd, &info) != 0 || info.st_size == 0) {
+        std::cerr << "Cannot map empty file " << filePath << std::endl;
+        ::close(fd);
+        return -1;
+    }
+    void *view = mmap(nullptr, static_cast<std::size_t>(info.st_size), PROT_READ, MAP_PRIVATE, fd, 0);
+    if (view == MAP_FAILED) {
+        std::cerr << "Failed to map " << filePath << std::endl;
+        ::close(fd);
+        return -1;
+    }
+    m_fd = fd;
+    m_data = static_cast<const unsigned char *>(view);
+    m_size = static_cast<std::size_t>(info.st_size);
+#endif
+    return 0;
+}
+
+void MappedFile::close() {
+    if (!m_data) {
+        return;
+    }
+#ifdef _WIN32
+    UnmapViewOfFile(m_data);
+    CloseHandle(static_cast<HANDLE>(m_mapping));
+    CloseHandle(static_cast<HANDLE>(m_file));
+    m_file = nullptr;
+    m_mapping = nullptr;
+#else
+    munmap(const_cast<unsigned char *>(m_data), m_size);
+    ::close(m_fd);
+    m_fd = -1;
+#endif
+    m_data = nullptr;
+    m_size = 0;
+}
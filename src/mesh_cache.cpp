@@ -0,0 +1,219 @@
+#include <mesh.h>
+#include <lod.h>
+#include <mesh_optimize.h>
+#include <meshlet.h>
+
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <string>
+#include <system_error>
+#include <utility>
+#include <vector>
+
+namespace {
+
+constexpr char MESH_CACHE_MAGIC[4] = {'M', 'C', 'H', 'E'};
+constexpr std::uint32_t MESH_CACHE_VERSION = 4;
+constexpr std::uint64_t MESH_CACHE_ALIGNMENT = 16;
+
+// Everything after the header is addressed by offset from the start of the file
+struct MeshCacheHeader {
+    char magic[4];
+    std::uint32_t version;
+    std::uint64_t sourceSize;
+    std::int64_t sourceTime;
+    VertexFormat format;
+    std::uint32_t vertexStride;
+    std::uint32_t vertexCount;
+    std::uint32_t indexCount;
+    MeshBounds bounds;
+    std::uint32_t meshletCount;
+    std::uint32_t lodCount;
+    std::uint64_t vertexOffset;
+    std::uint64_t indexOffset;
+    std::uint64_t meshletOffset;
+    std::uint64_t lodOffset;
+};
+
+constexpr std::uint64_t alignUp(std::uint64_t value, std::uint64_t alignment) {
+    return (value + alignment - 1) & ~(alignment - 1);
+}
+
+int sourceStamp(std::string_view sourcePath, std::uint64_t &size, std::int64_t &time) {
+    std::error_code error;
+    const std::filesystem::path path{resourceFilePath(sourcePath)};
+    size = std::filesystem::file_size(path, error);
+    if (error) {
+        return -1; // not a loose file, the source was read from the pack or the executable
+    }
+    time = std::filesystem::last_write_time(path, error).time_since_epoch().count();
+    return error ? -1 : 0;
+}
+
+// The whole cache file in memory, the same bytes writeMeshCache puts on disk
+void serializeMeshCache(std::string_view sourcePath, const MeshData &mesh, const std::vector<Meshlet> &meshlets,
+                        const std::vector<MeshLod> &lods, const VertexFormat &format, std::vector<unsigned char> &out) {
+    const VertexLayout layout = makeVertexLayout(format);
+    std::vector<unsigned char> vertexData;
+    const MeshBounds bounds = computeBounds(mesh.vertices.data(), mesh.vertices.size());
+    packVertices(mesh.vertices.data(), mesh.vertices.size(), layout, bounds, vertexData);
+
+    MeshCacheHeader header{};
+    std::memcpy(header.magic, MESH_CACHE_MAGIC, sizeof(header.magic));
+    header.version = MESH_CACHE_VERSION;
+    if (sourceStamp(sourcePath, header.sourceSize, header.sourceTime) != 0) {
+        header.sourceSize = 0; // nothing on disk the cache could go stale against
+        header.sourceTime = 0;
+    }
+    header.format = format;
+    header.vertexStride = layout.stride;
+    header.vertexCount = static_cast<std::uint32_t>(mesh.vertices.size());
+    header.indexCount = static_cast<std::uint32_t>(mesh.indices.size());
+    header.bounds = bounds;
+    header.meshletCount = static_cast<std::uint32_t>(meshlets.size());
+    header.lodCount = static_cast<std::uint32_t>(lods.size());
+    header.vertexOffset = alignUp(sizeof(MeshCacheHeader), MESH_CACHE_ALIGNMENT);
+    header.indexOffset = alignUp(header.vertexOffset + vertexData.size(), MESH_CACHE_ALIGNMENT);
+    header.meshletOffset = alignUp(header.indexOffset + mesh.indices.size() * sizeof(unsigned int),
+                                   MESH_CACHE_ALIGNMENT);
+    header.lodOffset = alignUp(header.meshletOffset + meshlets.size() * sizeof(Meshlet), MESH_CACHE_ALIGNMENT);
+
+    // Zero filled, so the padding between sections is deterministic
+    out.assign(header.lodOffset + lods.size() * sizeof(MeshLod), 0);
+    std::memcpy(out.data(), &header, sizeof(header));
+    std::memcpy(out.data() + header.vertexOffset, vertexData.data(), vertexData.size());
+    std::memcpy(out.data() + header.indexOffset, mesh.indices.data(), mesh.indices.size() * sizeof(unsigned int));
+    std::memcpy(out.data() + header.meshletOffset, meshlets.data(), meshlets.size() * sizeof(Meshlet));
+    std::memcpy(out.data() + header.lodOffset, lods.data(), lods.size() * sizeof(MeshLod));
+}
+
+int writeCacheFile(std::string_view cachePath, const std::vector<unsigned char> &bytes) {
+    // Write to a temporary file and rename so a crash never leaves a half written cache behind
+    const std::string cacheFile = resourceFilePath(cachePath);
+    const std::string temporaryFile = cacheFile + ".tmp";
+    {
+        std::ofstream file(temporaryFile, std::ios::binary | std::ios::trunc);
+        if (!file) {
+            std::cerr << "Failed to create mesh cache " << temporaryFile << std::endl;
+            return -1;
+        }
+        file.write(reinterpret_cast<const char *>(bytes.data()), static_cast<std::streamsize>(bytes.size()));
+        if (!file) {
+            std::cerr << "Failed to write mesh cache " << temporaryFile << std::endl;
+            return -1;
+        }
+    }
+
+    std::error_code error;
+    std::filesystem::rename(temporaryFile, cacheFile, error);
+    if (error) {
+        std::cerr << "Failed to move mesh cache into place: " << error.message() << std::endl;
+        std::filesystem::remove(temporaryFile, error);
+        return -1;
+    }
+    return 0;
+}
+
+// Validates the cache held by view.resource and points the view into it
+int viewMeshCache(std::string_view cachePath, std::string_view sourcePath, const VertexFormat &format,
+                  MeshCacheView &view) {
+    const unsigned char *data = view.resource.bytes.data();
+    const std::size_t size = view.resource.bytes.size();
+    if (size < sizeof(MeshCacheHeader)) {
+        return -1;
+    }
+
+    MeshCacheHeader header;
+    std::memcpy(&header, data, sizeof(header));
+    if (std::memcmp(header.magic, MESH_CACHE_MAGIC, sizeof(header.magic)) != 0 ||
+        header.version != MESH_CACHE_VERSION || header.format != format) {
+        return -1;
+    }
+
+    std::uint64_t sourceSize;
+    std::int64_t sourceTime;
+    if (sourceStamp(sourcePath, sourceSize, sourceTime) == 0 &&
+        (sourceSize != header.sourceSize || sourceTime != header.sourceTime)) {
+        return -1; // stale; a missing source is fine, we ship caches on their own too
+    }
+
+    view.layout = makeVertexLayout(header.format);
+    if (header.vertexStride != view.layout.stride ||
+        header.vertexOffset + std::uint64_t{header.vertexCount} * header.vertexStride > size ||
+        header.indexOffset + std::uint64_t{header.indexCount} * sizeof(unsigned int) > size ||
+        header.meshletOffset + std::uint64_t{header.meshletCount} * sizeof(Meshlet) > size ||
+        header.lodOffset + std::uint64_t{header.lodCount} * sizeof(MeshLod) > size) {
+        std::cerr << "Mesh cache " << cachePath << " is truncated" << std::endl;
+        return -1;
+    }
+
+    view.bounds = header.bounds;
+    view.vertexData = data + header.vertexOffset;
+    view.vertexCount = header.vertexCount;
+    view.indices = reinterpret_cast<const unsigned int *>(data + header.indexOffset);
+    view.indexCount = header.indexCount;
+    view.meshlets = reinterpret_cast<const Meshlet *>(data + header.meshletOffset);
+    view.meshletCount = header.meshletCount;
+    view.lods = reinterpret_cast<const MeshLod *>(data + header.lodOffset);
+    view.lodCount = header.lodCount;
+    return 0;
+}
+
+} // namespace
+
+int writeMeshCache(std::string_view cachePath, std::string_view sourcePath, const MeshData &mesh,
+                   const std::vector<Meshlet> &meshlets, const std::vector<MeshLod> &lods,
+                   const VertexFormat &format) {
+    std::vector<unsigned char> bytes;
+    serializeMeshCache(sourcePath, mesh, meshlets, lods, format, bytes);
+    return writeCacheFile(cachePath, bytes);
+}
+
+int openMeshCache(std::string_view cachePath, std::string_view sourcePath, const VertexFormat &format,
+                  MeshCacheView &view) {
+    view = MeshCacheView{};
+    if (openResource(cachePath, view.resource) != 0 || viewMeshCache(cachePath, sourcePath, format, view) != 0) {
+        view = MeshCacheView{};
+        return -1;
+    }
+    return 0;
+}
+
+int loadMesh(std::string_view path, const VertexFormat &format, MeshCacheView &view) {
+    const std::string cachePath = std::string(path) + ".mcache";
+    if (openMeshCache(cachePath, path, format, view) == 0) {
+        return 0;
+    }
+
+    MeshData mesh;
+    if (importMesh(path, mesh) != 0) {
+        return -1;
+    }
+
+    // Bake time is the only time we pay for the optimization passes, the cache keeps the result
+    MeshOptimizeReport report;
+    optimizeMesh(mesh, &report);
+    std::cout << "Optimized " << path << ": " << report << std::endl;
+
+    std::vector<Meshlet> meshlets;
+    buildMeshlets(mesh, meshlets);
+
+    // LODs go after LOD 0 in the same index buffer, the meshlets above only reference LOD 0
+    std::vector<MeshLod> lods;
+    buildLodChain(mesh, lods);
+
+    std::vector<unsigned char> bytes;
+    serializeMeshCache(path, mesh, meshlets, lods, format, bytes);
+    if (writeCacheFile(cachePath, bytes) == 0) {
+        return openMeshCache(cachePath, path, format, view);
+    }
+
+    // A read-only install directory only costs the next start another import
+    std::cerr << "Using " << path << " without a mesh cache" << std::endl;
+    view = MeshCacheView{};
+    view.resource.storage = std::move(bytes);
+    view.resource.bytes = view.resource.storage;
+    return viewMeshCache(cachePath, path, format, view);
+}
@@ -0,0 +1,854 @@
+#include <mesh.h>
+#include <json.h>
+#include <job_system.h>
+
+#include <algorithm>
+#include <array>
+#include <cctype>
+#include <charconv>
+#include <cmath>
+#include <cstring>
+#include <filesystem>
+#include <iostream>
+#include <span>
+#include <string>
+#include <unordered_map>
+
+namespace {
+
+constexpr std::size_t MIN_OBJ_CHUNK_SIZE = 256 * 1024;
+
+void generateNormals(MeshData &mesh) {
+    for (Vertex &vertex : mesh.vertices) {
+        vertex.normal[0] = vertex.normal[1] = vertex.normal[2] = 0.0f;
+    }
+    // Area weighted: the un-normalized cross product is twice the triangle area
+    for (std::size_t i = 0; i + 2 < mesh.indices.size(); i += 3) {
+        Vertex &a = mesh.vertices[mesh.indices[i]];
+        Vertex &b = mesh.vertices[mesh.indices[i + 1]];
+        Vertex &c = mesh.vertices[mesh.indices[i + 2]];
+        float e1[3] = {b.position[0] - a.position[0], b.position[1] - a.position[1], b.position[2] - a.position[2]};
+        float e2[3] = {c.position[0] - a.position[0], c.position[1] - a.position[1], c.position[2] - a.position[2]};
+        float n[3] = {
+                e1[1] * e2[2] - e1[2] * e2[1],
+                e1[2] * e2[0] - e1[0] * e2[2],
+                e1[0] * e2[1] - e1[1] * e2[0]
+        };
+        for (Vertex *vertex : {&a, &b, &c}) {
+            vertex->normal[0] += n[0];
+            vertex->normal[1] += n[1];
+            vertex->normal[2] += n[2];
+        }
+    }
+    for (Vertex &vertex : mesh.vertices) {
+        float length = std::sqrt(vertex.normal[0] * vertex.normal[0] + vertex.normal[1] * vertex.normal[1] +
+                                 vertex.normal[2] * vertex.normal[2]);
+        if (length > 0.0f) {
+            vertex.normal[0] /= length;
+            vertex.normal[1] /= length;
+            vertex.normal[2] /= length;
+        } else {
+            vertex.normal[0] = 0.0f;
+            vertex.normal[1] = 0.0f;
+            vertex.normal[2] = 1.0f;
+        }
+    }
+}
+
+// ---------------------------------------------------------------------------------------------------------------------
+// OBJ
+// ---------------------------------------------------------------------------------------------------------------------
+
+enum ObjRelative : unsigned char {
+    RELATIVE_POSITION = 1, RELATIVE_UV = 2, RELATIVE_NORMAL = 4
+};
+
+struct ObjCorner {
+    int position;
+    int uv;     // -1 when absent
+    int normal; // -1 when absent
+    unsigned char relative; // ObjRelative bits: negative indices are resolved against the chunk start later
+};
+
+struct ObjChunk {
+    std::vector<float> positions;
+    std::vector<float> colors;
+    std::vector<float> normals;
+    std::vector<float> uvs;
+    std::vector<ObjCorner> corners; // already triangulated, three per triangle
+    std::size_t lineCount = 0;
+    std::size_t errorLine = 0; // chunk-local, 0 when the chunk parsed cleanly
+    std::string error;
+};
+
+const char *skipSpaces(const char *cursor, const char *end) {
+    while (cursor < end && (*cursor == ' ' || *cursor == '\t' || *cursor == '\r')) {
+        cursor++;
+    }
+    return cursor;
+}
+
+// Parses up to `count` floats, returns how many were read
+int parseFloats(const char *&cursor, const char *end, float *out, int count) {
+    int parsed = 0;
+    while (parsed < count) {
+        cursor = skipSpaces(cursor, end);
+        if (cursor < end && *cursor == '+') {
+            cursor++;
+        }
+        auto result = std::from_chars(cursor, end, out[parsed]);
+        if (result.ec != std::errc{}) {
+            break;
+        }
+        cursor = result.ptr;
+        parsed++;
+    }
+    return parsed;
+}
+
+// Turns an OBJ index (1-based, or negative = relative to the current end) into a 0-based index
+bool resolveObjIndex(int raw, std::size_t localCount, unsigned char flag, int &index, unsigned char &relative) {
+    if (raw > 0) {
+        index = raw - 1;
+        return true;
+    }
+    if (raw < 0) {
+        index = static_cast<int>(localCount) + raw;
+        relative |= flag;
+        return true;
+    }
+    return false;
+}
+
+bool parseFaceCorner(const char *&cursor, const char *end, const ObjChunk &chunk, ObjCorner &corner) {
+    int raw[3] = {0, 0, 0};
+    int field = 0;
+    while (cursor < end && *cursor != ' ' && *cursor != '\t' && *cursor != '\r') {
+        if (*cursor == '/') {
+            if (++field > 2) {
+                return false;
+            }
+            cursor++;
+            continue;
+        }
+        auto result = std::from_chars(cursor, end, raw[field]);
+        if (result.ec != std::errc{}) {
+            return false;
+        }
+        cursor = result.ptr;
+    }
+
+    corner = {-1, -1, -1, 0};
+    if (!resolveObjIndex(raw[0], chunk.positions.size() / 3, RELATIVE_POSITION, corner.position, corner.relative)) {
+        return false;
+    }
+    if (raw[1] != 0) {
+        resolveObjIndex(raw[1], chunk.uvs.size() / 2, RELATIVE_UV, corner.uv, corner.relative);
+    }
+    if (raw[2] != 0) {
+        resolveObjIndex(raw[2], chunk.normals.size() / 3, RELATIVE_NORMAL, corner.normal, corner.relative);
+    }
+    return true;
+}
+
+void parseObjChunk(const char *begin, const char *end, ObjChunk &chunk) {
+    std::vector<ObjCorner> polygon;
+    const char *cursor = begin;
+
+    while (cursor < end) {
+        const char *lineEnd = static_cast<const char *>(std::memchr(cursor, '\n', static_cast<std::size_t>(end - cursor)));
+        if (!lineEnd) {
+            lineEnd = end;
+        }
+        chunk.lineCount++;
+
+        const char *c = skipSpaces(cursor, lineEnd);
+        if (lineEnd - c >= 2 && c[0] == 'v' && (c[1] == ' ' || c[1] == '\t')) {
+            c += 2;
+            // Positions may carry an extra r g b triple (common extension used by our own assets)
+            float values[6];
+            int count = parseFloats(c, lineEnd, values, 6);
+            if (count < 3) {
+                chunk.error = "vertex position needs at least 3 components";
+                chunk.errorLine = chunk.lineCount;
+                return;
+            }
+            chunk.positions.insert(chunk.positions.end(), values, values + 3);
+            if (count >= 6) {
+                chunk.colors.insert(chunk.colors.end(), values + 3, values + 6);
+            } else {
+                chunk.colors.insert(chunk.colors.end(), {1.0f, 1.0f, 1.0f});
+            }
+        } else if (lineEnd - c >= 3 && c[0] == 'v' && c[1] == 'n') {
+            c += 2;
+            float values[3];
+            if (parseFloats(c, lineEnd, values, 3) != 3) {
+                chunk.error = "normal needs 3 components";
+                chunk.errorLine = chunk.lineCount;
+                return;
+            }
+            chunk.normals.insert(chunk.normals.end(), values, values + 3);
+        } else if (lineEnd - c >= 3 && c[0] == 'v' && c[1] == 't') {
+            c += 2;
+            float values[3] = {0.0f, 0.0f, 0.0f};
+            if (parseFloats(c, lineEnd, values, 3) < 1) {
+                chunk.error = "texture coordinate needs at least 1 component";
+                chunk.errorLine = chunk.lineCount;
+                return;
+            }
+            chunk.uvs.insert(chunk.uvs.end(), values, values + 2);
+        } else if (lineEnd - c >= 2 && c[0] == 'f' && (c[1] == ' ' || c[1] == '\t')) {
+            c += 2;
+            polygon.clear();
+            while (true) {
+                c = skipSpaces(c, lineEnd);
+                if (c >= lineEnd) {
+                    break;
+                }
+                ObjCorner corner{};
+                if (!parseFaceCorner(c, lineEnd, chunk, corner)) {
+                    chunk.error = "malformed face index";
+                    chunk.errorLine = chunk.lineCount;
+                    return;
+                }
+                polygon.push_back(corner);
+            }
+            if (polygon.size() < 3) {
+                chunk.error = "face needs at least 3 vertices";
+                chunk.errorLine = chunk.lineCount;
+                return;
+            }
+            // Fan triangulation, fine for the convex polygons exporters produce
+            for (std::size_t i = 1; i + 1 < polygon.size(); i++) {
+                chunk.corners.push_back(polygon[0]);
+                chunk.corners.push_back(polygon[i]);
+                chunk.corners.push_back(polygon[i + 1]);
+            }
+        }
+
+        cursor = lineEnd + 1;
+    }
+}
+
+struct CornerKey {
+    int position, uv, normal;
+    bool operator==(const CornerKey &) const = default;
+};
+
+struct CornerKeyHash {
+    std::size_t operator()(const CornerKey &key) const {
+        std::uint64_t h = static_cast<std::uint32_t>(key.position);
+        h = h * 0x9E3779B97F4A7C15ull ^ static_cast<std::uint32_t>(key.uv);
+        h = h * 0x9E3779B97F4A7C15ull ^ static_cast<std::uint32_t>(key.normal);
+        return static_cast<std::size_t>(h ^ (h >> 29));
+    }
+};
+
+// ---------------------------------------------------------------------------------------------------------------------
+// glTF
+// ---------------------------------------------------------------------------------------------------------------------
+
+constexpr int GLTF_BYTE = 5120;
+constexpr int GLTF_UNSIGNED_BYTE = 5121;
+constexpr int GLTF_SHORT = 5122;
+constexpr int GLTF_UNSIGNED_SHORT = 5123;
+constexpr int GLTF_UNSIGNED_INT = 5125;
+constexpr int GLTF_FLOAT = 5126;
+
+using Matrix4 = std::array<float, 16>; // column major, like glTF
+
+constexpr Matrix4 IDENTITY = {1, 0, 0, 0, 0, 1, 0, 0, 0, 0, 1, 0, 0, 0, 0, 1};
+
+Matrix4 multiply(const Matrix4 &a, const Matrix4 &b) {
+    Matrix4 result{};
+    for (int column = 0; column < 4; column++) {
+        for (int row = 0; row < 4; row++) {
+            float sum = 0.0f;
+            for (int k = 0; k < 4; k++) {
+                sum += a[k * 4 + row] * b[column * 4 + k];
+            }
+            result[column * 4 + row] = sum;
+        }
+    }
+    return result;
+}
+
+Matrix4 nodeMatrix(const JsonValue &node) {
+    if (const JsonValue *matrix = node.find("matrix"); matrix && matrix->size() == 16) {
+        Matrix4 result{};
+        for (int i = 0; i < 16; i++) {
+            result[i] = static_cast<float>((*matrix)[i].asNumber());
+        }
+        return result;
+    }
+
+    float t[3] = {0, 0, 0}, r[4] = {0, 0, 0, 1}, s[3] = {1, 1, 1};
+    auto read = [&node](const char *key, float *out, std::size_t count) {
+        if (const JsonValue *value = node.find(key); value && value->size() == count) {
+            for (std::size_t i = 0; i < count; i++) {
+                out[i] = static_cast<float>((*value)[i].asNumber());
+            }
+        }
+    };
+    read("translation", t, 3);
+    read("rotation", r, 4);
+    read("scale", s, 3);
+
+    const float x = r[0], y = r[1], z = r[2], w = r[3];
+    return {
+            (1 - 2 * (y * y + z * z)) * s[0], (2 * (x * y + z * w)) * s[0], (2 * (x * z - y * w)) * s[0], 0,
+            (2 * (x * y - z * w)) * s[1], (1 - 2 * (x * x + z * z)) * s[1], (2 * (y * z + x * w)) * s[1], 0,
+            (2 * (x * z + y * w)) * s[2], (2 * (y * z - x * w)) * s[2], (1 - 2 * (x * x + y * y)) * s[2], 0,
+            t[0], t[1], t[2], 1
+    };
+}
+
+int decodeBase64(std::string_view text, std::vector<unsigned char> &out) {
+    auto value = [](char c) -> int {
+        if (c >= 'A' && c <= 'Z') return c - 'A';
+        if (c >= 'a' && c <= 'z') return c - 'a' + 26;
+        if (c >= '0' && c <= '9') return c - '0' + 52;
+        if (c == '+') return 62;
+        if (c == '/') return 63;
+        return -1;
+    };
+    out.clear();
+    out.reserve(text.size() / 4 * 3);
+    unsigned int accumulator = 0;
+    int bits = 0;
+    for (char c : text) {
+        if (c == '=') {
+            break;
+        }
+        int v = value(c);
+        if (v < 0) {
+            return -1;
+        }
+        accumulator = (accumulator << 6) | static_cast<unsigned int>(v);
+        bits += 6;
+        if (bits >= 8) {
+            bits -= 8;
+            out.push_back(static_cast<unsigned char>((accumulator >> bits) & 0xFF));
+        }
+    }
+    return 0;
+}
+
+struct GltfDocument {
+    JsonValue json;
+    std::vector<std::vector<unsigned char>> buffers;
+};
+
+int loadGltfBuffers(const std::filesystem::path &directory, const unsigned char *glbBinary, std::size_t glbBinarySize,
+                    GltfDocument &document) {
+    const JsonValue *buffers = document.json.find("buffers");
+    if (!buffers) {
+        return 0;
+    }
+    document.buffers.resize(buffers->size());
+    for (std::size_t i = 0; i < buffers->size(); i++) {
+        const JsonValue &buffer = (*buffers)[i];
+        std::string_view uri = buffer.stringMember("uri");
+        std::vector<unsigned char> &data = document.buffers[i];
+
+        if (uri.empty()) {
+            if (!glbBinary) {
+                std::cerr << "glTF buffer " << i << " has no uri and there is no GLB binary chunk" << std::endl;
+                return -1;
+            }
+            data.assign(glbBinary, glbBinary + glbBinarySize);
+        } else if (uri.starts_with("data:")) {
+            std::size_t comma = uri.find(',');
+            if (comma == std::string_view::npos || decodeBase64(uri.substr(comma + 1), data) != 0) {
+                std::cerr << "glTF buffer " << i << " has an invalid data uri" << std::endl;
+                return -1;
+            }
+        } else {
+            const std::string bufferPath = (directory / std::filesystem::path(std::string(uri))).generic_string();
+            ResourceData file;
+            if (openResource(bufferPath, file) != 0) {
+                std::cerr << "Failed to open glTF buffer " << bufferPath << std::endl;
+                return -1;
+            }
+            data.assign(file.bytes.begin(), file.bytes.end());
+        }
+
+        if (data.size() < static_cast<std::size_t>(buffer.numberMember("byteLength"))) {
+            std::cerr << "glTF buffer " << i << " is shorter than its byteLength" << std::endl;
+            return -1;
+        }
+    }
+    return 0;
+}
+
+int componentSize(int componentType) {
+    switch (componentType) {
+        case GLTF_BYTE:
+        case GLTF_UNSIGNED_BYTE: return 1;
+        case GLTF_SHORT:
+        case GLTF_UNSIGNED_SHORT: return 2;
+        case GLTF_UNSIGNED_INT:
+        case GLTF_FLOAT: return 4;
+        default: return 0;
+    }
+}
+
+int typeComponents(std::string_view type) {
+    if (type == "SCALAR") return 1;
+    if (type == "VEC2") return 2;
+    if (type == "VEC3") return 3;
+    if (type == "VEC4") return 4;
+    return 0;
+}
+
+double readComponent(const unsigned char *data, int componentType, bool normalized) {
+    switch (componentType) {
+        case GLTF_BYTE: {
+            std::int8_t v;
+            std::memcpy(&v, data, 1);
+            return normalized ? std::max(v / 127.0, -1.0) : v;
+        }
+        case GLTF_UNSIGNED_BYTE: return normalized ? data[0] / 255.0 : data[0];
+        case GLTF_SHORT: {
+            std::int16_t v;
+            std::memcpy(&v, data, 2);
+            return normalized ? std::max(v / 32767.0, -1.0) : v;
+        }
+        case GLTF_UNSIGNED_SHORT: {
+            std::uint16_t v;
+            std::memcpy(&v, data, 2);
+            return normalized ? v / 65535.0 : v;
+        }
+        case GLTF_UNSIGNED_INT: {
+            std::uint32_t v;
+            std::memcpy(&v, data, 4);
+            return v;
+        }
+        default: {
+            float v;
+            std::memcpy(&v, data, 4);
+            return v;
+        }
+    }
+}
+
+// Reads an accessor into a tightly packed double array, `components` values per element
+int readAccessor(const GltfDocument &document, int accessorIndex, std::vector<double> &out, int &components) {
+    const JsonValue *accessors = document.json.find("accessors");
+    if (!accessors || accessorIndex < 0 || static_cast<std::size_t>(accessorIndex) >= accessors->size()) {
+        std::cerr << "glTF accessor " << accessorIndex << " does not exist" << std::endl;
+        return -1;
+    }
+    const JsonValue &accessor = (*accessors)[accessorIndex];
+    if (accessor.find("sparse")) {
+        std::cerr << "Sparse glTF accessors are not supported" << std::endl;
+        return -1;
+    }
+
+    const int componentType = accessor.intMember("componentType");
+    const int size = componentSize(componentType);
+    components = typeComponents(accessor.stringMember("type"));
+    const auto count = static_cast<std::size_t>(accessor.numberMember("count"));
+    const bool normalized = accessor.find("normalized") && accessor.find("normalized")->boolean;
+    if (size == 0 || components == 0) {
+        std::cerr << "glTF accessor " << accessorIndex << " has an unsupported format" << std::endl;
+        return -1;
+    }
+
+    out.assign(count * static_cast<std::size_t>(components), 0.0);
+    const JsonValue *viewIndex = accessor.find("bufferView");
+    if (!viewIndex) {
+        return 0; // no buffer view means all zeros
+    }
+
+    const JsonValue *views = document.json.find("bufferViews");
+    const int viewNumber = viewIndex->asInt();
+    if (!views || viewNumber < 0 || static_cast<std::size_t>(viewNumber) >= views->size()) {
+        std::cerr << "glTF accessor " << accessorIndex << " references a missing buffer view" << std::endl;
+        return -1;
+    }
+    const JsonValue &view = (*views)[static_cast<std::size_t>(viewNumber)];
+    const auto bufferIndex = static_cast<std::size_t>(view.intMember("buffer"));
+    if (bufferIndex >= document.buffers.size()) {
+        std::cerr << "glTF buffer view references a missing buffer" << std::endl;
+        return -1;
+    }
+    const std::vector<unsigned char> &buffer = document.buffers[bufferIndex];
+    const auto offset = static_cast<std::size_t>(view.numberMember("byteOffset") + accessor.numberMember("byteOffset"));
+    const std::size_t elementSize = static_cast<std::size_t>(size * components);
+    const auto stride = static_cast<std::size_t>(view.numberMember("byteStride", static_cast<double>(elementSize)));
+    if (stride < elementSize) {
+        std::cerr << "glTF accessor " << accessorIndex << " has a byteStride smaller than its elements" << std::endl;
+        return -1;
+    }
+
+    if (count > 0 && offset + stride * (count - 1) + elementSize > buffer.size()) {
+        std::cerr << "glTF accessor " << accessorIndex << " reads past the end of its buffer" << std::endl;
+        return -1;
+    }
+    for (std::size_t i = 0; i < count; i++) {
+        const unsigned char *element = buffer.data() + offset + stride * i;
+        for (int c = 0; c < components; c++) {
+            out[i * static_cast<std::size_t>(components) + static_cast<std::size_t>(c)] =
+                    readComponent(element + c * size, componentType, normalized);
+        }
+    }
+    return 0;
+}
+
+struct GltfDraw {
+    const JsonValue *primitive;
+    Matrix4 transform;
+};
+
+int convertPrimitive(const GltfDocument &document, const GltfDraw &draw, MeshData &mesh) {
+    const JsonValue &primitive = *draw.primitive;
+    const JsonValue *attributes = primitive.find("attributes");
+    const JsonValue *positionAccessor = attributes ? attributes->find("POSITION") : nullptr;
+    if (!positionAccessor) {
+        std::cerr << "glTF primitive without POSITION attribute" << std::endl;
+        return -1;
+    }
+
+    std::vector<double> positions, normals, uvs, colors;
+    int positionComponents = 0, normalComponents = 0, uvComponents = 0, colorComponents = 0;
+    if (readAccessor(document, positionAccessor->asInt(), positions, positionComponents) != 0 || positionComponents != 3) {
+        return -1;
+    }
+    if (const JsonValue *a = attributes->find("NORMAL"); a && readAccessor(document, a->asInt(), normals, normalComponents) != 0) {
+        return -1;
+    }
+    if (const JsonValue *a = attributes->find("TEXCOORD_0"); a && readAccessor(document, a->asInt(), uvs, uvComponents) != 0) {
+        return -1;
+    }
+    if (const JsonValue *a = attributes->find("COLOR_0"); a && readAccessor(document, a->asInt(), colors, colorComponents) != 0) {
+        return -1;
+    }
+
+    const std::size_t vertexCount = positions.size() / 3;
+    const Matrix4 &m = draw.transform;
+    mesh.vertices.resize(vertexCount);
+    for (std::size_t i = 0; i < vertexCount; i++) {
+        Vertex &vertex = mesh.vertices[i];
+        const double *p = &positions[i * 3];
+        for (int r = 0; r < 3; r++) {
+            vertex.position[r] = static_cast<float>(m[r] * p[0] + m[4 + r] * p[1] + m[8 + r] * p[2] + m[12 + r]);
+        }
+        if (normalComponents == 3) {
+            // Upper 3x3 is good enough for the rigid and uniformly scaled nodes we get from exporters
+            const double *n = &normals[i * 3];
+            float length = 0.0f;
+            for (int r = 0; r < 3; r++) {
+                vertex.normal[r] = static_cast<float>(m[r] * n[0] + m[4 + r] * n[1] + m[8 + r] * n[2]);
+                length += vertex.normal[r] * vertex.normal[r];
+            }
+            length = length > 0.0f ? std::sqrt(length) : 1.0f;
+            for (float &component : vertex.normal) {
+                component /= length;
+            }
+        }
+        if (uvComponents == 2) {
+            vertex.uv[0] = static_cast<float>(uvs[i * 2]);
+            vertex.uv[1] = static_cast<float>(uvs[i * 2 + 1]);
+        } else {
+            vertex.uv[0] = vertex.uv[1] = 0.0f;
+        }
+        if (colorComponents >= 3) {
+            for (int c = 0; c < 3; c++) {
+                vertex.color[c] = static_cast<float>(colors[i * static_cast<std::size_t>(colorComponents) + static_cast<std::size_t>(c)]);
+            }
+        } else {
+            vertex.color[0] = vertex.color[1] = vertex.color[2] = 1.0f;
+        }
+    }
+
+    if (const JsonValue *indexAccessor = primitive.find("indices")) {
+        std::vector<double> indices;
+        int indexComponents = 0;
+        if (readAccessor(document, indexAccessor->asInt(), indices, indexComponents) != 0 || indexComponents != 1) {
+            return -1;
+        }
+        mesh.indices.resize(indices.size());
+        for (std::size_t i = 0; i < indices.size(); i++) {
+            mesh.indices[i] = static_cast<unsigned int>(indices[i]);
+            if (mesh.indices[i] >= vertexCount) {
+                std::cerr << "glTF index out of range" << std::endl;
+                return -1;
+            }
+        }
+    } else {
+        mesh.indices.resize(vertexCount);
+        for (std::size_t i = 0; i < vertexCount; i++) {
+            mesh.indices[i] = static_cast<unsigned int>(i);
+        }
+    }
+    mesh.indices.resize(mesh.indices.size() - mesh.indices.size() % 3);
+
+    if (normalComponents != 3) {
+        generateNormals(mesh);
+    }
+    return 0;
+}
+
+void collectDraws(const JsonValue &json, std::size_t nodeIndex, const Matrix4 &parent, std::vector<GltfDraw> &draws, int depth) {
+    const JsonValue *nodes = json.find("nodes");
+    if (!nodes || nodeIndex >= nodes->size() || depth > 64) {
+        return;
+    }
+    const JsonValue &node = (*nodes)[nodeIndex];
+    const Matrix4 transform = multiply(parent, nodeMatrix(node));
+
+    if (const JsonValue *meshIndex = node.find("mesh")) {
+        const JsonValue *meshes = json.find("meshes");
+        if (meshes && static_cast<std::size_t>(meshIndex->asInt()) < meshes->size()) {
+            if (const JsonValue *primitives = (*meshes)[static_cast<std::size_t>(meshIndex->asInt())].find("primitives")) {
+                for (const JsonValue &primitive : primitives->items) {
+                    if (primitive.intMember("mode", 4) == 4) { // triangles only
+                        draws.push_back({&primitive, transform});
+                    }
+                }
+            }
+        }
+    }
+    if (const JsonValue *children = node.find("children")) {
+        for (const JsonValue &child : children->items) {
+            collectDraws(json, static_cast<std::size_t>(child.asInt()), transform, draws, depth + 1);
+        }
+    }
+}
+
+} // namespace
+
+int loadObj(std::string_view path, MeshData &mesh) {
+    ResourceData file;
+    if (openResource(path, file) != 0) {
+        std::cerr << "Failed to open " << path << std::endl;
+        return -1;
+    }
+    const char *text = reinterpret_cast<const char *>(file.bytes.data());
+    const std::size_t size = file.bytes.size();
+
+    // Split on line boundaries into roughly equal chunks, one per worker
+    const std::size_t chunkCount = std::clamp<std::size_t>(size / MIN_OBJ_CHUNK_SIZE, 1, jobWorkerCount());
+    std::vector<std::size_t> boundaries{0};
+    for (std::size_t i = 1; i < chunkCount; i++) {
+        std::size_t split = std::max(size * i / chunkCount, boundaries.back());
+        const void *newline = std::memchr(text + split, '\n', size - split);
+        split = newline ? static_cast<std::size_t>(static_cast<const char *>(newline) - text) + 1 : size;
+        boundaries.push_back(split);
+    }
+    boundaries.push_back(size);
+
+    std::vector<ObjChunk> chunks(chunkCount);
+    runBatches(chunkCount, [&](std::size_t i) {
+        parseObjChunk(text + boundaries[i], text + boundaries[i + 1], chunks[i]);
+    });
+
+    // Prefix sums so chunk-relative (negative) indices can be made absolute
+    std::size_t positionBase = 0, uvBase = 0, normalBase = 0, lineBase = 0;
+    std::vector<ObjCorner> corners;
+    for (ObjChunk &chunk : chunks) {
+        if (!chunk.error.empty()) {
+            std::cerr << "OBJ parse error in " << path << " on line " << lineBase + chunk.errorLine << ": "
+                      << chunk.error << std::endl;
+            return -1;
+        }
+        for (ObjCorner &corner : chunk.corners) {
+            if (corner.relative & RELATIVE_POSITION) corner.position += static_cast<int>(positionBase);
+            if (corner.relative & RELATIVE_UV) corner.uv += static_cast<int>(uvBase);
+            if (corner.relative & RELATIVE_NORMAL) corner.normal += static_cast<int>(normalBase);
+            // A relative uv or normal reaching before the start of the file would otherwise read as absent
+            if (((corner.relative & RELATIVE_UV) && corner.uv < 0) ||
+                ((corner.relative & RELATIVE_NORMAL) && corner.normal < 0)) {
+                std::cerr << "OBJ face index out of range in " << path << std::endl;
+                return -1;
+            }
+        }
+        positionBase += chunk.positions.size() / 3;
+        uvBase += chunk.uvs.size() / 2;
+        normalBase += chunk.normals.size() / 3;
+        lineBase += chunk.lineCount;
+        corners.insert(corners.end(), chunk.corners.begin(), chunk.corners.end());
+    }
+
+    std::vector<float> positions, colors, uvs, normals;
+    positions.reserve(positionBase * 3);
+    colors.reserve(positionBase * 3);
+    uvs.reserve(uvBase * 2);
+    normals.reserve(normalBase * 3);
+    for (const ObjChunk &chunk : chunks) {
+        positions.insert(positions.end(), chunk.positions.begin(), chunk.positions.end());
+        colors.insert(colors.end(), chunk.colors.begin(), chunk.colors.end());
+        uvs.insert(uvs.end(), chunk.uvs.begin(), chunk.uvs.end());
+        normals.insert(normals.end(), chunk.normals.begin(), chunk.normals.end());
+    }
+    chunks.clear();
+
+    // Deduplicate position/uv/normal triplets into one vertex each
+    mesh.vertices.clear();
+    mesh.indices.clear();
+    mesh.indices.reserve(corners.size());
+    std::unordered_map<CornerKey, unsigned int, CornerKeyHash> unique;
+    unique.reserve(positionBase);
+    bool hasNormals = true;
+
+    for (const ObjCorner &corner : corners) {
+        if (corner.position < 0 || static_cast<std::size_t>(corner.position) >= positionBase ||
+            (corner.uv >= 0 && static_cast<std::size_t>(corner.uv) >= uvBase) ||
+            (corner.normal >= 0 && static_cast<std::size_t>(corner.normal) >= normalBase)) {
+            std::cerr << "OBJ face index out of range in " << path << std::endl;
+            return -1;
+        }
+        hasNormals = hasNormals && corner.normal >= 0;
+
+        auto [it, inserted] = unique.try_emplace(CornerKey{corner.position, corner.uv, corner.normal},
+                                                 static_cast<unsigned int>(mesh.vertices.size()));
+        if (inserted) {
+            Vertex vertex{};
+            const auto p = static_cast<std::size_t>(corner.position);
+            std::copy_n(&positions[p * 3], 3, vertex.position);
+            std::copy_n(&colors[p * 3], 3, vertex.color);
+            if (corner.uv >= 0) {
+                std::copy_n(&uvs[static_cast<std::size_t>(corner.uv) * 2], 2, vertex.uv);
+            }
+            if (corner.normal >= 0) {
+                std::copy_n(&normals[static_cast<std::size_t>(corner.normal) * 3], 3, vertex.normal);
+            }
+            mesh.vertices.push_back(vertex);
+        }
+        mesh.indices.push_back(it->second);
+    }
+
+    if (!hasNormals) {
+        generateNormals(mesh);
+    }
+    return 0;
+}
+
+int loadGltf(std::string_view path, MeshData &mesh) {
+    ResourceData resource;
+    if (openResource(path, resource) != 0) {
+        std::cerr << "Failed to open " << path << std::endl;
+        return -1;
+    }
+    const std::span<const unsigned char> file = resource.bytes;
+
+    GltfDocument document;
+    std::string_view jsonText;
+    const unsigned char *binary = nullptr;
+    std::size_t binarySize = 0;
+
+    auto readU32 = [&file](std::size_t offset) {
+        std::uint32_t value;
+        std::memcpy(&value, file.data() + offset, 4);
+        return value;
+    };
+
+    if (file.size() >= 12 && std::memcmp(file.data(), "glTF", 4) == 0) {
+        if (readU32(4) != 2) {
+            std::cerr << "Unsupported GLB version in " << path << std::endl;
+            return -1;
+        }
+        const std::size_t length = std::min<std::size_t>(readU32(8), file.size());
+        std::size_t offset = 12;
+        while (offset + 8 <= length) {
+            const std::size_t chunkLength = readU32(offset);
+            const std::uint32_t chunkType = readU32(offset + 4);
+            if (offset + 8 + chunkLength > length) {
+                std::cerr << "Truncated GLB chunk in " << path << std::endl;
+                return -1;
+            }
+            const unsigned char *chunk = file.data() + offset + 8;
+            if (chunkType == 0x4E4F534A) { // "JSON"
+                jsonText = {reinterpret_cast<const char *>(chunk), chunkLength};
+            } else if (chunkType == 0x004E4942 && !binary) { // "BIN\0"
+                binary = chunk;
+                binarySize = chunkLength;
+            }
+            offset += 8 + ((chunkLength + 3) & ~std::size_t{3});
+        }
+    } else {
+        jsonText = {reinterpret_cast<const char *>(file.data()), file.size()};
+    }
+
+    // Exporters pad the JSON chunk with spaces and occasionally with zeros
+    while (!jsonText.empty() && jsonText.back() == '\0') {
+        jsonText.remove_suffix(1);
+    }
+    if (jsonText.empty() || parseJson(jsonText, document.json) != 0) {
+        std::cerr << "Invalid glTF JSON in " << path << std::endl;
+        return -1;
+    }
+
+    const std::filesystem::path directory = std::filesystem::path(std::string(path)).parent_path();
+    if (loadGltfBuffers(directory, binary, binarySize, document) != 0) {
+        return -1;
+    }
+
+    // Walk the default scene so node transforms are baked into the vertices
+    std::vector<GltfDraw> draws;
+    const JsonValue *scenes = document.json.find("scenes");
+    if (scenes && scenes->size() > 0) {
+        const auto sceneIndex = static_cast<std::size_t>(document.json.intMember("scene", 0));
+        const JsonValue &scene = (*scenes)[std::min(sceneIndex, scenes->size() - 1)];
+        if (const JsonValue *roots = scene.find("nodes")) {
+            for (const JsonValue &root : roots->items) {
+                collectDraws(document.json, static_cast<std::size_t>(root.asInt()), IDENTITY, draws, 0);
+            }
+        }
+    } else if (const JsonValue *meshes = document.json.find("meshes")) {
+        for (const JsonValue &gltfMesh : meshes->items) {
+            if (const JsonValue *primitives = gltfMesh.find("primitives")) {
+                for (const JsonValue &primitive : primitives->items) {
+                    if (primitive.intMember("mode", 4) == 4) {
+                        draws.push_back({&primitive, IDENTITY});
+                    }
+                }
+            }
+        }
+    }
+    if (draws.empty()) {
+        std::cerr << "No triangle primitives found in " << path << std::endl;
+        return -1;
+    }
+
+    // Convert primitives in parallel, strided across the workers, then concatenate in document order
+    std::vector<MeshData> parts(draws.size());
+    std::vector<int> results(draws.size(), 0);
+    const std::size_t chunkCount = std::min(draws.size(), jobWorkerCount());
+    runBatches(chunkCount, [&](std::size_t chunk) {
+        for (std::size_t i = chunk; i < draws.size(); i += chunkCount) {
+            results[i] = convertPrimitive(document, draws[i], parts[i]);
+        }
+    });
+
+    mesh.vertices.clear();
+    mesh.indices.clear();
+    for (std::size_t i = 0; i < parts.size(); i++) {
+        if (results[i] != 0) {
+            std::cerr << "Failed to convert glTF primitive " << i << " of " << path << std::endl;
+            return -1;
+        }
+        const auto base = static_cast<unsigned int>(mesh.vertices.size());
+        mesh.vertices.insert(mesh.vertices.end(), parts[i].vertices.begin(), parts[i].vertices.end());
+        for (unsigned int index : parts[i].indices) {
+            mesh.indices.push_back(base + index);
+        }
+    }
+    return 0;
+}
+
+int importMesh(std::string_view path, MeshData &mesh) {
+    std::string extension = std::filesystem::path(std::string(path)).extension().string();
+    std::transform(extension.begin(), extension.end(), extension.begin(),
+                   [](unsigned char c) { return static_cast<char>(std::tolower(c)); });
+
+    if (extension == ".obj") {
+        return loadObj(path, mesh);
+    }
+    if (extension == ".gltf" || extension == ".glb") {
+        return loadGltf(path, mesh);
+    }
+    std::cerr << "No importer for " << path << std::endl;
+    return -1;
+}
@@ -0,0 +1,398 @@
+#include <mesh_optimize.h>
+
+#include <algorithm>
+#include <cmath>
+#include <iomanip>
+#include <ostream>
+
+namespace {
+
+// Forsyth's tuning constants
+constexpr unsigned int FORSYTH_CACHE_SIZE = 32;
+constexpr unsigned int FORSYTH_MAX_VALENCE = 32;
+constexpr float FORSYTH_DECAY_POWER = 1.5f;
+constexpr float FORSYTH_LAST_TRIANGLE_SCORE = 0.75f;
+constexpr float FORSYTH_VALENCE_BOOST_SCALE = 2.0f;
+constexpr float FORSYTH_VALENCE_BOOST_POWER = 0.5f;
+
+struct ForsythScores {
+    float cache[FORSYTH_CACHE_SIZE + 3];
+    float valence[FORSYTH_MAX_VALENCE + 1];
+
+    ForsythScores() {
+        for (unsigned int i = 0; i < FORSYTH_CACHE_SIZE + 3; i++) {
+            if (i < 3) {
+                // The vertices of the last triangle get a fixed score so we don't just repeat it
+                cache[i] = FORSYTH_LAST_TRIANGLE_SCORE;
+            } else if (i < FORSYTH_CACHE_SIZE) {
+                const float scaler = 1.0f / static_cast<float>(FORSYTH_CACHE_SIZE - 3);
+                cache[i] = std::pow(1.0f - static_cast<float>(i - 3) * scaler, FORSYTH_DECAY_POWER);
+            } else {
+                cache[i] = 0.0f;
+            }
+        }
+        valence[0] = 0.0f;
+        for (unsigned int i = 1; i <= FORSYTH_MAX_VALENCE; i++) {
+            valence[i] = FORSYTH_VALENCE_BOOST_SCALE * std::pow(static_cast<float>(i), -FORSYTH_VALENCE_BOOST_POWER);
+        }
+    }
+
+    [[nodiscard]] float vertex(int cachePosition, unsigned int remaining) const {
+        if (remaining == 0) {
+            return -1.0f;
+        }
+        const float cacheScore = cachePosition >= 0 ? cache[cachePosition] : 0.0f;
+        return cacheScore + valence[std::min(remaining, FORSYTH_MAX_VALENCE)];
+    }
+};
+
+float triangleArea(const Vertex &a, const Vertex &b, const Vertex &c, float normal[3]) {
+    const float e1[3] = {b.position[0] - a.position[0], b.position[1] - a.position[1], b.position[2] - a.position[2]};
+    const float e2[3] = {c.position[0] - a.position[0], c.position[1] - a.position[1], c.position[2] - a.position[2]};
+    normal[0] = e1[1] * e2[2] - e1[2] * e2[1];
+    normal[1] = e1[2] * e2[0] - e1[0] * e2[2];
+    normal[2] = e1[0] * e2[1] - e1[1] * e2[0];
+    return std::sqrt(normal[0] * normal[0] + normal[1] * normal[1] + normal[2] * normal[2]) * 0.5f;
+}
+
+} // namespace
+
+VertexCacheStats analyzeVertexCache(const unsigned int *indices, std::size_t indexCount, std::size_t vertexCount,
+                                    unsigned int cacheSize) {
+    VertexCacheStats stats;
+    if (indexCount < 3 || vertexCount == 0) {
+        return stats;
+    }
+
+    // FIFO cache: a vertex is resident while it was inserted less than cacheSize misses ago
+    std::vector<std::size_t> insertedAt(vertexCount, 0);
+    std::vector<bool> seen(vertexCount, false);
+    std::size_t misses = 0;
+    std::size_t uniqueVertices = 0;
+
+    for (std::size_t i = 0; i < indexCount; i++) {
+        const unsigned int index = indices[i];
+        if (!seen[index]) {
+            seen[index] = true;
+            uniqueVertices++;
+        } else if (misses - insertedAt[index] < cacheSize) {
+            continue;
+        }
+        insertedAt[index] = misses;
+        misses++;
+    }
+
+    stats.acmr = static_cast<float>(misses) / static_cast<float>(indexCount / 3);
+    stats.atvr = static_cast<float>(misses) / static_cast<float>(uniqueVertices);
+    return stats;
+}
+
+void optimizeVertexCache(std::vector<unsigned int> &indices, std::size_t vertexCount) {
+    const std::size_t triangleCount = indices.size() / 3;
+    if (triangleCount == 0) {
+        return;
+    }
+    static const ForsythScores scores;
+
+    // Vertex -> triangles adjacency, compacted as triangles get emitted
+    std::vector<unsigned int> remaining(vertexCount, 0);
+    for (unsigned int index : indices) {
+        remaining[index]++;
+    }
+    std::vector<std::size_t> adjacencyOffset(vertexCount + 1, 0);
+    for (std::size_t v = 0; v < vertexCount; v++) {
+        adjacencyOffset[v + 1] = adjacencyOffset[v] + remaining[v];
+    }
+    std::vector<unsigned int> adjacency(indices.size());
+    {
+        std::vector<std::size_t> fill(adjacencyOffset.begin(), adjacencyOffset.end() - 1);
+        for (std::size_t i = 0; i < indices.size(); i++) {
+            adjacency[fill[indices[i]]++] = static_cast<unsigned int>(i / 3);
+        }
+    }
+
+    std::vector<float> vertexScore(vertexCount);
+    for (std::size_t v = 0; v < vertexCount; v++) {
+        vertexScore[v] = scores.vertex(-1, remaining[v]);
+    }
+
+    std::vector<float> triangleScore(triangleCount);
+    std::vector<bool> emitted(triangleCount, false);
+    for (std::size_t t = 0; t < triangleCount; t++) {
+        triangleScore[t] = vertexScore[indices[t * 3]] + vertexScore[indices[t * 3 + 1]] + vertexScore[indices[t * 3 + 2]];
+    }
+
+    std::vector<unsigned int> output;
+    output.reserve(indices.size());
+    std::vector<unsigned int> cache, nextCache;
+    cache.reserve(FORSYTH_CACHE_SIZE + 3);
+    nextCache.reserve(FORSYTH_CACHE_SIZE + 3);
+
+    auto best = static_cast<std::size_t>(std::max_element(triangleScore.begin(), triangleScore.end()) - triangleScore.begin());
+    std::size_t inputCursor = 0;
+
+    while (true) {
+        emitted[best] = true;
+        const unsigned int *triangle = &indices[best * 3];
+        output.insert(output.end(), triangle, triangle + 3);
+
+        // Drop the emitted triangle from its vertices' adjacency lists
+        for (int k = 0; k < 3; k++) {
+            const unsigned int v = triangle[k];
+            unsigned int *begin = &adjacency[adjacencyOffset[v]];
+            unsigned int *end = begin + remaining[v];
+            *std::find(begin, end, static_cast<unsigned int>(best)) = *(end - 1);
+            remaining[v]--;
+        }
+
+        // Move the triangle's vertices to the front of the LRU cache
+        nextCache.clear();
+        for (int k = 0; k < 3; k++) {
+            if (std::find(nextCache.begin(), nextCache.end(), triangle[k]) == nextCache.end()) {
+                nextCache.push_back(triangle[k]);
+            }
+        }
+        for (unsigned int v : cache) {
+            if (v != triangle[0] && v != triangle[1] && v != triangle[2]) {
+                nextCache.push_back(v);
+            }
+        }
+        std::swap(cache, nextCache);
+
+        // Rescore every vertex whose cache position changed (including evicted ones) and push the difference
+        // into their remaining triangles
+        for (std::size_t i = 0; i < cache.size(); i++) {
+            const unsigned int v = cache[i];
+            const int position = i < FORSYTH_CACHE_SIZE ? static_cast<int>(i) : -1;
+            const float score = scores.vertex(position, remaining[v]);
+            const float delta = score - vertexScore[v];
+            vertexScore[v] = score;
+            for (std::size_t a = 0; a < remaining[v]; a++) {
+                triangleScore[adjacency[adjacencyOffset[v] + a]] += delta;
+            }
+        }
+        if (cache.size() > FORSYTH_CACHE_SIZE) {
+            cache.resize(FORSYTH_CACHE_SIZE);
+        }
+
+        // The next triangle is the best one touching the cache
+        float bestScore = -1.0f;
+        std::size_t bestCandidate = triangleCount;
+        for (unsigned int v : cache) {
+            for (std::size_t a = 0; a < remaining[v]; a++) {
+                const unsigned int t = adjacency[adjacencyOffset[v] + a];
+                if (triangleScore[t] > bestScore) {
+                    bestScore = triangleScore[t];
+                    bestCandidate = t;
+                }
+            }
+        }
+
+        if (bestCandidate == triangleCount) {
+            // Dead end: nothing in the cache has triangles left, continue in input order
+            while (inputCursor < triangleCount && emitted[inputCursor]) {
+                inputCursor++;
+            }
+            if (inputCursor == triangleCount) {
+                break;
+            }
+            bestCandidate = inputCursor;
+        }
+        best = bestCandidate;
+    }
+
+    indices.swap(output);
+}
+
+void optimizeOverdraw(std::vector<unsigned int> &indices, const std::vector<Vertex> &vertices, float threshold) {
+    const std::size_t triangleCount = indices.size() / 3;
+    if (triangleCount < 2) {
+        return;
+    }
+
+    // Hard boundaries: triangles where the simulated cache misses all three vertices, the cache has effectively
+    // been flushed so a cluster starting there costs nothing. Soft boundaries: split a hard cluster once its
+    // running ACMR gets within `threshold` of the whole cluster's ACMR.
+    std::vector<std::size_t> hardClusters{0};
+    {
+        std::vector<std::size_t> insertedAt(vertices.size(), 0);
+        std::vector<bool> seen(vertices.size(), false);
+        std::size_t misses = 0;
+        for (std::size_t t = 0; t < triangleCount; t++) {
+            int triangleMisses = 0;
+            for (int k = 0; k < 3; k++) {
+                const unsigned int v = indices[t * 3 + k];
+                if (seen[v] && misses - insertedAt[v] < DEFAULT_CACHE_SIZE) {
+                    continue;
+                }
+                seen[v] = true;
+                insertedAt[v] = misses++;
+                triangleMisses++;
+            }
+            if (t > 0 && triangleMisses == 3) {
+                hardClusters.push_back(t);
+            }
+        }
+        hardClusters.push_back(triangleCount);
+    }
+
+    // Cache simulation state shared by all clusters, reset through the list of touched vertices so the cost
+    // stays proportional to the cluster size
+    std::vector<std::size_t> insertedAt(vertices.size(), 0);
+    std::vector<bool> seen(vertices.size(), false);
+    std::vector<unsigned int> touched;
+    std::size_t misses = 0;
+
+    auto resetCache = [&] {
+        for (unsigned int v : touched) {
+            seen[v] = false;
+        }
+        touched.clear();
+        misses = 0;
+    };
+    auto simulateTriangle = [&](std::size_t t) {
+        for (int k = 0; k < 3; k++) {
+            const unsigned int v = indices[t * 3 + k];
+            if (seen[v] && misses - insertedAt[v] < DEFAULT_CACHE_SIZE) {
+                continue;
+            }
+            if (!seen[v]) {
+                seen[v] = true;
+                touched.push_back(v);
+            }
+            insertedAt[v] = misses++;
+        }
+    };
+
+    std::vector<std::size_t> clusters;
+    for (std::size_t c = 0; c + 1 < hardClusters.size(); c++) {
+        const std::size_t begin = hardClusters[c];
+        const std::size_t end = hardClusters[c + 1];
+
+        resetCache();
+        for (std::size_t t = begin; t < end; t++) {
+            simulateTriangle(t);
+        }
+        const float clusterAcmr = static_cast<float>(misses) / static_cast<float>(end - begin);
+
+        clusters.push_back(begin);
+        std::size_t start = begin;
+        resetCache();
+        for (std::size_t t = begin; t < end; t++) {
+            simulateTriangle(t);
+            const std::size_t clusterTriangles = t + 1 - start;
+            const float runningAcmr = static_cast<float>(misses) / static_cast<float>(clusterTriangles);
+            if (t + 1 < end && clusterTriangles >= 8 && runningAcmr <= clusterAcmr * threshold) {
+                clusters.push_back(t + 1);
+                start = t + 1;
+                resetCache();
+            }
+        }
+    }
+    clusters.push_back(triangleCount);
+
+    // Sort clusters by how much they face away from the mesh centre: outer shells occlude inner ones
+    float meshCentroid[3] = {0.0f, 0.0f, 0.0f};
+    float meshArea = 0.0f;
+    struct ClusterSort {
+        std::size_t begin, end;
+        float key;
+    };
+    std::vector<ClusterSort> sorted;
+    std::vector<float> clusterData((clusters.size() - 1) * 7, 0.0f); // centroid, normal, area
+
+    for (std::size_t c = 0; c + 1 < clusters.size(); c++) {
+        float *data = &clusterData[c * 7];
+        for (std::size_t t = clusters[c]; t < clusters[c + 1]; t++) {
+            const Vertex &a = vertices[indices[t * 3]];
+            const Vertex &b = vertices[indices[t * 3 + 1]];
+            const Vertex &cv = vertices[indices[t * 3 + 2]];
+            float normal[3];
+            const float area = triangleArea(a, b, cv, normal);
+            for (int axis = 0; axis < 3; axis++) {
+                const float centre = (a.position[axis] + b.position[axis] + cv.position[axis]) / 3.0f;
+                data[axis] += centre * area;
+                data[3 + axis] += normal[axis];
+            }
+            data[6] += area;
+        }
+        for (int axis = 0; axis < 3; axis++) {
+            meshCentroid[axis] += data[axis];
+        }
+        meshArea += data[6];
+    }
+    if (meshArea <= 0.0f) {
+        return;
+    }
+    for (float &axis : meshCentroid) {
+        axis /= meshArea;
+    }
+
+    for (std::size_t c = 0; c + 1 < clusters.size(); c++) {
+        const float *data = &clusterData[c * 7];
+        float key = 0.0f;
+        if (data[6] > 0.0f) {
+            const float length = std::sqrt(data[3] * data[3] + data[4] * data[4] + data[5] * data[5]);
+            for (int axis = 0; axis < 3; axis++) {
+                const float direction = data[axis] / data[6] - meshCentroid[axis];
+                key += direction * (length > 0.0f ? data[3 + axis] / length : 0.0f);
+            }
+        }
+        sorted.push_back({clusters[c], clusters[c + 1], key});
+    }
+    std::stable_sort(sorted.begin(), sorted.end(), [](const ClusterSort &a, const ClusterSort &b) {
+        return a.key > b.key;
+    });
+
+    std::vector<unsigned int> output;
+    output.reserve(indices.size());
+    for (const ClusterSort &cluster : sorted) {
+        output.insert(output.end(), indices.begin() + static_cast<std::ptrdiff_t>(cluster.begin * 3),
+                      indices.begin() + static_cast<std::ptrdiff_t>(cluster.end * 3));
+    }
+    indices.swap(output);
+}
+
+void optimizeVertexFetch(MeshData &mesh) {
+    constexpr unsigned int UNUSED = ~0u;
+    std::vector<unsigned int> remap(mesh.vertices.size(), UNUSED);
+    std::vector<Vertex> vertices;
+    vertices.reserve(mesh.vertices.size());
+
+    for (unsigned int &index : mesh.indices) {
+        if (remap[index] == UNUSED) {
+            remap[index] = static_cast<unsigned int>(vertices.size());
+            vertices.push_back(mesh.vertices[index]);
+        }
+        index = remap[index];
+    }
+    mesh.vertices.swap(vertices);
+}
+
+void optimizeMesh(MeshData &mesh, MeshOptimizeReport *report) {
+    if (report) {
+        report->triangleCount = mesh.indices.size() / 3;
+        report->before = analyzeVertexCache(mesh.indices.data(), mesh.indices.size(), mesh.vertices.size());
+    }
+
+    optimizeVertexCache(mesh.indices, mesh.vertices.size());
+    optimizeOverdraw(mesh.indices, mesh.vertices);
+    optimizeVertexFetch(mesh);
+
+    if (report) {
+        report->vertexCount = mesh.vertices.size();
+        report->after = analyzeVertexCache(mesh.indices.data(), mesh.indices.size(), mesh.vertices.size());
+    }
+}
+
+std::ostream &operator<<(std::ostream &stream, const MeshOptimizeReport &report) {
+    const auto flags = stream.flags();
+    const auto precision = stream.precision();
+    stream << std::fixed << std::setprecision(3)
+           << report.triangleCount << " triangles, " << report.vertexCount << " vertices, ACMR "
+           << report.before.acmr << " -> " << report.after.acmr << ", ATVR "
+           << report.before.atvr << " -> " << report.after.atvr;
+    stream.flags(flags);
+    stream.precision(precision);
+    return stream;
+}
@@ -0,0 +1,182 @@
+#include <meshlet.h>
+
+#include <algorithm>
+#include <cmath>
+
+namespace {
+
+float distanceSquared(const float a[3], const float b[3]) {
+    const float dx = a[0] - b[0], dy = a[1] - b[1], dz = a[2] - b[2];
+    return dx * dx + dy * dy + dz * dz;
+}
+
+void computeBounds(const MeshData &mesh, const std::vector<unsigned int> &vertices, std::size_t firstIndex,
+                   std::size_t indexCount, Meshlet &meshlet) {
+    // Ritter's sphere: start from two far apart points, then grow to include stragglers
+    const float *start = mesh.vertices[vertices[0]].position;
+    const float *a = start;
+    for (unsigned int v : vertices) {
+        if (distanceSquared(mesh.vertices[v].position, start) > distanceSquared(a, start)) {
+            a = mesh.vertices[v].position;
+        }
+    }
+    const float *b = a;
+    for (unsigned int v : vertices) {
+        if (distanceSquared(mesh.vertices[v].position, a) > distanceSquared(b, a)) {
+            b = mesh.vertices[v].position;
+        }
+    }
+    float center[3] = {(a[0] + b[0]) * 0.5f, (a[1] + b[1]) * 0.5f, (a[2] + b[2]) * 0.5f};
+    float radius = std::sqrt(distanceSquared(a, b)) * 0.5f;
+    for (unsigned int v : vertices) {
+        const float *p = mesh.vertices[v].position;
+        const float distance = std::sqrt(distanceSquared(p, center));
+        if (distance > radius) {
+            const float grownRadius = (radius + distance) * 0.5f;
+            const float shift = (grownRadius - radius) / distance;
+            for (int axis = 0; axis < 3; axis++) {
+                center[axis] += (p[axis] - center[axis]) * shift;
+            }
+            radius = grownRadius;
+        }
+    }
+    std::copy_n(center, 3, meshlet.center);
+    meshlet.radius = radius;
+
+    // Normal cone from the face normals
+    std::vector<float> normals;
+    normals.reserve(indexCount);
+    float axis[3] = {0.0f, 0.0f, 0.0f};
+    for (std::size_t i = firstIndex; i < firstIndex + indexCount; i += 3) {
+        const float *p0 = mesh.vertices[mesh.indices[i]].position;
+        const float *p1 = mesh.vertices[mesh.indices[i + 1]].position;
+        const float *p2 = mesh.vertices[mesh.indices[i + 2]].position;
+        const float e1[3] = {p1[0] - p0[0], p1[1] - p0[1], p1[2] - p0[2]};
+        const float e2[3] = {p2[0] - p0[0], p2[1] - p0[1], p2[2] - p0[2]};
+        float n[3] = {e1[1] * e2[2] - e1[2] * e2[1], e1[2] * e2[0] - e1[0] * e2[2], e1[0] * e2[1] - e1[1] * e2[0]};
+        const float length = std::sqrt(n[0] * n[0] + n[1] * n[1] + n[2] * n[2]);
+        if (length <= 0.0f) {
+            continue;
+        }
+        for (int k = 0; k < 3; k++) {
+            n[k] /= length;
+            axis[k] += n[k];
+        }
+        normals.insert(normals.end(), n, n + 3);
+    }
+
+    meshlet.coneCutoff = 1.0f;
+    const float axisLength = std::sqrt(axis[0] * axis[0] + axis[1] * axis[1] + axis[2] * axis[2]);
+    for (int k = 0; k < 3; k++) {
+        meshlet.coneAxis[k] = axisLength > 0.0f ? axis[k] / axisLength : 0.0f;
+    }
+    if (axisLength <= 0.0f || normals.empty()) {
+        return;
+    }
+    float minDot = 1.0f;
+    for (std::size_t i = 0; i < normals.size(); i += 3) {
+        minDot = std::min(minDot, normals[i] * meshlet.coneAxis[0] + normals[i + 1] * meshlet.coneAxis[1] +
+                                  normals[i + 2] * meshlet.coneAxis[2]);
+    }
+    // Cones wider than ~84 degrees hardly ever cull anything, don't bother testing them
+    if (minDot > 0.1f) {
+        meshlet.coneCutoff = std::sqrt(1.0f - minDot * minDot);
+    }
+}
+
+bool isVisible(const Meshlet &meshlet, const Frustum &frustum, const float cameraPosition[3], bool &backface) {
+    backface = false;
+    for (const float *plane : frustum.planes) {
+        const float distance = plane[0] * meshlet.center[0] + plane[1] * meshlet.center[1] +
+                               plane[2] * meshlet.center[2] + plane[3];
+        if (distance < -meshlet.radius) {
+            return false;
+        }
+    }
+
+    if (meshlet.coneCutoff < 1.0f) {
+        const float toCenter[3] = {
+                meshlet.center[0] - cameraPosition[0],
+                meshlet.center[1] - cameraPosition[1],
+                meshlet.center[2] - cameraPosition[2]
+        };
+        const float distance = std::sqrt(toCenter[0] * toCenter[0] + toCenter[1] * toCenter[1] + toCenter[2] * toCenter[2]);
+        const float facing = toCenter[0] * meshlet.coneAxis[0] + toCenter[1] * meshlet.coneAxis[1] +
+                             toCenter[2] * meshlet.coneAxis[2];
+        if (facing >= meshlet.coneCutoff * distance + meshlet.radius) {
+            backface = true;
+            return false;
+        }
+    }
+    return true;
+}
+
+} // namespace
+
+void buildMeshlets(const MeshData &mesh, std::vector<Meshlet> &meshlets) {
+    meshlets.clear();
+    const std::size_t triangleCount = mesh.indices.size() / 3;
+    if (triangleCount == 0) {
+        return;
+    }
+
+    // The index buffer keeps its order, we only need to cut it: a new meshlet starts whenever the next triangle
+    // would exceed either limit. `owner` tells in O(1) whether a vertex is already in the current meshlet.
+    std::vector<std::uint32_t> owner(mesh.vertices.size(), ~0u);
+    std::vector<unsigned int> vertices;
+    vertices.reserve(MESHLET_MAX_VERTICES);
+    std::size_t first = 0;
+
+    auto flush = [&](std::size_t end) {
+        Meshlet meshlet{};
+        meshlet.firstIndex = static_cast<std::uint32_t>(first * 3);
+        meshlet.indexCount = static_cast<std::uint32_t>((end - first) * 3);
+        meshlet.vertexCount = static_cast<std::uint32_t>(vertices.size());
+        computeBounds(mesh, vertices, meshlet.firstIndex, meshlet.indexCount, meshlet);
+        meshlets.push_back(meshlet);
+        vertices.clear();
+        first = end;
+    };
+
+    for (std::size_t t = 0; t < triangleCount; t++) {
+        const unsigned int *triangle = &mesh.indices[t * 3];
+        const auto current = static_cast<std::uint32_t>(meshlets.size());
+        unsigned int newVertices = 0;
+        for (int k = 0; k < 3; k++) {
+            const bool repeated = (k > 0 && triangle[k] == triangle[0]) || (k > 1 && triangle[k] == triangle[1]);
+            newVertices += owner[triangle[k]] != current && !repeated;
+        }
+        if (vertices.size() + newVertices > MESHLET_MAX_VERTICES || t - first >= MESHLET_MAX_TRIANGLES) {
+            flush(t);
+        }
+
+        const auto id = static_cast<std::uint32_t>(meshlets.size());
+        for (int k = 0; k < 3; k++) {
+            if (owner[triangle[k]] != id) {
+                owner[triangle[k]] = id;
+                vertices.push_back(triangle[k]);
+            }
+        }
+    }
+    flush(triangleCount);
+}
+
+void cullMeshlets(const Meshlet *meshlets, std::size_t begin, std::size_t end, const Frustum &frustum,
+                  const float cameraPosition[3], std::vector<DrawElementsIndirectCommand> &commands,
+                  MeshletCullStats &stats) {
+    for (std::size_t i = begin; i < end; i++) {
+        const Meshlet &meshlet = meshlets[i];
+        stats.tested++;
+        bool backface;
+        if (!isVisible(meshlet, frustum, cameraPosition, backface)) {
+            (backface ? stats.backfaceCulled : stats.frustumCulled)++;
+            continue;
+        }
+        // Neighbouring survivors are contiguous in the index buffer, so they fold into a single draw
+        if (!commands.empty() && commands.back().firstIndex + commands.back().count == meshlet.firstIndex) {
+            commands.back().count += meshlet.indexCount;
+        } else {
+            commands.push_back({meshlet.indexCount, 1, meshlet.firstIndex, 0, 0});
+        }
+    }
+}
@@ -0,0 +1,185 @@
+#include <occlusion.h>
+
+#include <algorithm>
+#include <cmath>
+
+namespace {
+
+// Clip space w below which a vertex counts as behind the eye
+constexpr float NEAR_W = 1e-5f;
+// Flat objects sit exactly at their box's near depth; the bias keeps them from hiding behind themselves
+constexpr float DEPTH_BIAS = 1e-4f;
+
+struct ScreenVertex {
+    float x, y, depth;
+};
+
+// Window coordinates of a clip space point, false when it is behind the eye
+bool toScreen(const vec4 &clip, int width, int height, ScreenVertex &out) {
+    if (clip.w < NEAR_W) {
+        return false;
+    }
+    const float inverseW = 1.0f / clip.w;
+    out.x = (clip.x * inverseW * 0.5f + 0.5f) * static_cast<float>(width);
+    out.y = (clip.y * inverseW * 0.5f + 0.5f) * static_cast<float>(height);
+    out.depth = clip.z * inverseW * 0.5f + 0.5f;
+    return true;
+}
+
+// Pixel under a window coordinate, clamped to the buffer (clamping as floats first, vertices can be far off screen)
+int pixelIndex(float coordinate, int size) {
+    return static_cast<int>(std::clamp(coordinate, 0.0f, static_cast<float>(size - 1)));
+}
+
+float edge(const ScreenVertex &a, const ScreenVertex &b, float x, float y) {
+    return (b.x - a.x) * (y - a.y) - (b.y - a.y) * (x - a.x);
+}
+
+void rasterizeTriangle(OcclusionBuffer &buffer, ScreenVertex v0, ScreenVertex v1, ScreenVertex v2) {
+    float area = edge(v0, v1, v2.x, v2.y);
+    if (area == 0.0f) {
+        return;
+    }
+    if (area < 0.0f) {
+        std::swap(v1, v2); // occluders are two sided
+        area = -area;
+    }
+
+    const int minX = pixelIndex(std::min({v0.x, v1.x, v2.x}), buffer.width);
+    const int maxX = pixelIndex(std::max({v0.x, v1.x, v2.x}), buffer.width);
+    const int minY = pixelIndex(std::min({v0.y, v1.y, v2.y}), buffer.height);
+    const int maxY = pixelIndex(std::max({v0.y, v1.y, v2.y}), buffer.height);
+
+    // Window depth is affine in screen space, plain barycentrics interpolate it
+    const float inverseArea = 1.0f / area;
+    float *depth = buffer.levels[0].data();
+    for (int y = minY; y <= maxY; y++) {
+        const float py = static_cast<float>(y) + 0.5f;
+        for (int x = minX; x <= maxX; x++) {
+            const float px = static_cast<float>(x) + 0.5f;
+            const float w0 = edge(v1, v2, px, py);
+            const float w1 = edge(v2, v0, px, py);
+            const float w2 = edge(v0, v1, px, py);
+            if (w0 < 0.0f || w1 < 0.0f || w2 < 0.0f) {
+                continue;
+            }
+            const float z = (w0 * v0.depth + w1 * v1.depth + w2 * v2.depth) * inverseArea;
+            float &stored = depth[y * buffer.width + x];
+            if (z >= 0.0f && z < stored) {
+                stored = z;
+            }
+        }
+    }
+}
+
+} // namespace
+
+void beginOcclusionBuffer(OcclusionBuffer &buffer, int width, int height) {
+    if (buffer.width != width || buffer.height != height) {
+        buffer.width = width;
+        buffer.height = height;
+        buffer.levels.clear();
+        buffer.levelWidths.clear();
+        buffer.levelHeights.clear();
+        int levelWidth = width, levelHeight = height;
+        while (true) {
+            buffer.levels.emplace_back(static_cast<std::size_t>(levelWidth) * static_cast<std::size_t>(levelHeight));
+            buffer.levelWidths.push_back(levelWidth);
+            buffer.levelHeights.push_back(levelHeight);
+            if (levelWidth == 1 && levelHeight == 1) {
+                break;
+            }
+            levelWidth = std::max(1, (levelWidth + 1) / 2);
+            levelHeight = std::max(1, (levelHeight + 1) / 2);
+        }
+    }
+    std::fill(buffer.levels[0].begin(), buffer.levels[0].end(), 1.0f);
+    buffer.stats = {};
+}
+
+void rasterizeOccluder(OcclusionBuffer &buffer, const mat4 &modelViewProjection, const float *positions,
+                       const unsigned int *indices, std::size_t indexCount) {
+    for (std::size_t i = 0; i + 2 < indexCount; i += 3) {
+        ScreenVertex vertices[3];
+        bool inFront = true;
+        for (int k = 0; k < 3; k++) {
+            const float *p = positions + static_cast<std::size_t>(indices[i + k]) * 3;
+            inFront &= toScreen(modelViewProjection * vec4{p[0], p[1], p[2], 1.0f}, buffer.width, buffer.height,
+                                vertices[k]);
+        }
+        if (inFront) {
+            rasterizeTriangle(buffer, vertices[0], vertices[1], vertices[2]);
+            buffer.stats.occluderTriangles++;
+        }
+    }
+}
+
+void buildDepthPyramid(OcclusionBuffer &buffer) {
+    for (std::size_t level = 1; level < buffer.levels.size(); level++) {
+        const std::vector<float> &source = buffer.levels[level - 1];
+        std::vector<float> &target = buffer.levels[level];
+        const int sourceWidth = buffer.levelWidths[level - 1], sourceHeight = buffer.levelHeights[level - 1];
+        const int width = buffer.levelWidths[level], height = buffer.levelHeights[level];
+        for (int y = 0; y < height; y++) {
+            // Odd sizes: the last texel also covers the source's last row/column
+            const int y0 = y * 2, y1 = std::min(y * 2 + 1, sourceHeight - 1);
+            for (int x = 0; x < width; x++) {
+                const int x0 = x * 2, x1 = std::min(x * 2 + 1, sourceWidth - 1);
+                target[y * width + x] = std::max({source[y0 * sourceWidth + x0], source[y0 * sourceWidth + x1],
+                                                  source[y1 * sourceWidth + x0], source[y1 * sourceWidth + x1]});
+            }
+        }
+    }
+}
+
+bool isOccluded(OcclusionBuffer &buffer, const mat4 &viewProjection, const Aabb &box) {
+    buffer.stats.tested++;
+
+    float minX = 0.0f, maxX = 0.0f, minY = 0.0f, maxY = 0.0f, nearest = 0.0f;
+    for (int corner = 0; corner < 8; corner++) {
+        const vec4 clip = viewProjection * vec4{
+                corner & 1 ? box.max.x : box.min.x,
+                corner & 2 ? box.max.y : box.min.y,
+                corner & 4 ? box.max.z : box.min.z,
+                1.0f
+        };
+        ScreenVertex vertex;
+        if (!toScreen(clip, buffer.width, buffer.height, vertex)) {
+            return false;
+        }
+        minX = corner ? std::min(minX, vertex.x) : vertex.x;
+        maxX = corner ? std::max(maxX, vertex.x) : vertex.x;
+        minY = corner ? std::min(minY, vertex.y) : vertex.y;
+        maxY = corner ? std::max(maxY, vertex.y) : vertex.y;
+        nearest = corner ? std::min(nearest, vertex.depth) : vertex.depth;
+    }
+    if (maxX < 0.0f || maxY < 0.0f || minX >= static_cast<float>(buffer.width) ||
+        minY >= static_cast<float>(buffer.height)) {
+        return false; // off screen, that is for frustum culling to decide
+    }
+
+    int x0 = pixelIndex(minX, buffer.width), x1 = pixelIndex(maxX, buffer.width);
+    int y0 = pixelIndex(minY, buffer.height), y1 = pixelIndex(maxY, buffer.height);
+    std::size_t level = 0;
+    while (std::max(x1 - x0, y1 - y0) > 1 && level + 1 < buffer.levels.size()) {
+        level++;
+        x0 >>= 1;
+        x1 >>= 1;
+        y0 >>= 1;
+        y1 >>= 1;
+    }
+
+    const std::vector<float> &depth = buffer.levels[level];
+    const int width = buffer.levelWidths[level];
+    float farthest = 0.0f;
+    for (int y = y0; y <= y1; y++) {
+        for (int x = x0; x <= x1; x++) {
+            farthest = std::max(farthest, depth[y * width + x]);
+        }
+    }
+    if (nearest > farthest + DEPTH_BIAS) {
+        buffer.stats.occluded++;
+        return true;
+    }
+    return false;
+}
@@ -0,0 +1,193 @@
+#include <post_process.h>
+
+#include <GLEW/glew.h>
+
+#include <algorithm>
+#include <iostream>
+
+namespace {
+
+enum PostUniform {
+    TEXEL_SIZE,
+    DIRECTION,
+    THRESHOLD,
+    EXPOSURE,
+    BLOOM_INTENSITY,
+    LIFT,
+    GAMMA,
+    GAIN,
+    GRADE
+};
+
+constexpr const char *POST_UNIFORM_NAMES[PostProgram::UNIFORM_COUNT] = {
+        "texelSize", "direction", "threshold", "exposure", "bloomIntensity", "lift", "gamma", "gain", "grade"
+};
+
+// Texture units of the passes' samplers
+constexpr int SOURCE_UNIT = 0;
+constexpr int BLOOM_UNIT = 1;
+
+int resolveProgram(ShaderVariants &variants, std::initializer_list<std::string_view> keywords, PostProgram &pass) {
+    pass.program = getShaderVariant(variants, keywordMask(variants.sources, keywords));
+    if (pass.program == 0) {
+        return -1;
+    }
+    for (std::size_t i = 0; i < PostProgram::UNIFORM_COUNT; i++) {
+        pass.uniforms[i] = glGetUniformLocation(pass.program, POST_UNIFORM_NAMES[i]);
+    }
+    glUseProgram(pass.program);
+    glUniform1i(glGetUniformLocation(pass.program, "source"), SOURCE_UNIT);
+    glUniform1i(glGetUniformLocation(pass.program, "bloom"), BLOOM_UNIT);
+    glUseProgram(0);
+    return 0;
+}
+
+// The graph has bound the pass's target, draws the fullscreen triangle with source on unit 0
+void drawFullscreen(const PostProcess &post, unsigned int source) {
+    glDisable(GL_DEPTH_TEST);
+    glBindVertexArray(post.vertexArray);
+    glActiveTexture(GL_TEXTURE0 + SOURCE_UNIT);
+    glBindTexture(GL_TEXTURE_2D, source);
+    glDrawArrays(GL_TRIANGLES, 0, 3);
+    glBindVertexArray(0);
+}
+
+void setTexelSize(const PostProgram &pass, PostUniform uniform, int width, int height) {
+    glUniform2f(pass.uniforms[uniform], 1.0f / static_cast<float>(width), 1.0f / static_cast<float>(height));
+}
+
+// Bright pass into half size, then again into quarter size when asked, then a horizontal and a vertical blur
+GraphTexture addBloomPasses(PostProcess &post, RenderGraph &graph, GraphTexture scene) {
+    const int width = graph.textures[scene].width;
+    const int height = graph.textures[scene].height;
+    const GraphTexture half = createGraphTexture(graph, "bloom half", width / 2, height / 2,
+                                                 RenderTargetFormat::R11F_G11F_B10F);
+    const GraphPass brightPass = addGraphPass(graph, "bloom: bright pass",
+                                              [&post, scene](const RenderGraph &frameGraph) {
+        const PostProcessSettings &settings = post.settings;
+        const float knee = std::max(settings.bloomKnee, 1e-4f);
+        const RenderTarget &source = graphTarget(frameGraph, scene);
+        glUseProgram(post.brightPass.program);
+        setTexelSize(post.brightPass, TEXEL_SIZE, source.width, source.height);
+        glUniform4f(post.brightPass.uniforms[THRESHOLD], settings.bloomThreshold, knee, 2.0f * knee, 0.25f / knee);
+        drawFullscreen(post, source.texture);
+    });
+    readGraphTexture(graph, brightPass, scene);
+    writeGraphTexture(graph, brightPass, half);
+
+    GraphTexture bloom = half;
+    if (post.settings.bloomDivisor >= 4) {
+        bloom = createGraphTexture(graph, "bloom quarter", width / 4, height / 4,
+                                   RenderTargetFormat::R11F_G11F_B10F);
+        const GraphPass downsample = addGraphPass(graph, "bloom: downsample",
+                                                  [&post, half](const RenderGraph &frameGraph) {
+            const RenderTarget &source = graphTarget(frameGraph, half);
+            glUseProgram(post.downsample.program);
+            setTexelSize(post.downsample, TEXEL_SIZE, source.width, source.height);
+            drawFullscreen(post, source.texture);
+        });
+        readGraphTexture(graph, downsample, half);
+        writeGraphTexture(graph, downsample, bloom);
+    }
+
+    // Each blur direction writes a texture of its own, the graph puts the second one where the unblurred input was
+    const int bloomWidth = graph.textures[bloom].width;
+    const int bloomHeight = graph.textures[bloom].height;
+    GraphTexture source = bloom;
+    const char *names[2][2] = {{"bloom blur x", "bloom: blur x"}, {"bloom", "bloom: blur y"}};
+    for (int axis = 0; axis < 2; axis++) {
+        const GraphTexture blurred = createGraphTexture(graph, names[axis][0], bloomWidth, bloomHeight,
+                                                        RenderTargetFormat::R11F_G11F_B10F);
+        const GraphPass blur = addGraphPass(graph, names[axis][1],
+                                            [&post, source, axis](const RenderGraph &frameGraph) {
+            const RenderTarget &input = graphTarget(frameGraph, source);
+            glUseProgram(post.blur.program);
+            glUniform2f(post.blur.uniforms[DIRECTION], axis == 0 ? 1.0f / static_cast<float>(input.width) : 0.0f,
+                        axis == 1 ? 1.0f / static_cast<float>(input.height) : 0.0f);
+            drawFullscreen(post, input.texture);
+        });
+        readGraphTexture(graph, blur, source);
+        writeGraphTexture(graph, blur, blurred);
+        source = blurred;
+    }
+    return source;
+}
+
+} // namespace
+
+int initPostProcess(PostProcess &post, ShaderIncludeCache &includes) {
+    if (loadShaderVariants("res/shaders/post/downsample.shader", post.downsampleShaders, includes) != 0 ||
+        loadShaderVariants("res/shaders/post/blur.shader", post.blurShaders, includes) != 0 ||
+        loadShaderVariants("res/shaders/post/tonemap.shader", post.tonemapShaders, includes) != 0 ||
+        loadShaderVariants("res/shaders/post/fxaa.shader", post.fxaaShaders, includes) != 0) {
+        std::cerr << "Could not parse post-processing shaders" << std::endl;
+        return -1;
+    }
+    if (resolveProgram(post.downsampleShaders, {"THRESHOLD"}, post.brightPass) != 0 ||
+        resolveProgram(post.downsampleShaders, {}, post.downsample) != 0 ||
+        resolveProgram(post.blurShaders, {}, post.blur) != 0 ||
+        resolveProgram(post.tonemapShaders, {}, post.tonemap) != 0 ||
+        resolveProgram(post.tonemapShaders, {"BLOOM"}, post.tonemapBloom) != 0 ||
+        resolveProgram(post.fxaaShaders, {}, post.fxaa) != 0) {
+        std::cerr << "Could not compile post-processing shaders" << std::endl;
+        return -1;
+    }
+
+    glGenVertexArrays(1, &post.vertexArray);
+    return 0;
+}
+
+void destroyPostProcess(PostProcess &post) {
+    glDeleteVertexArrays(1, &post.vertexArray);
+    post.vertexArray = 0;
+    destroyShaderVariants(post.downsampleShaders);
+    destroyShaderVariants(post.blurShaders);
+    destroyShaderVariants(post.tonemapShaders);
+    destroyShaderVariants(post.fxaaShaders);
+}
+
+void addPostProcessPasses(PostProcess &post, RenderGraph &graph, GraphTexture scene, GraphTexture output) {
+    const PostProcessSettings &settings = post.settings;
+    const GraphTexture bloom = addBloomPasses(post, graph, scene);
+
+    // Without FXAA the tonemapped image goes straight to the output
+    const GraphTexture display = settings.fxaa
+            ? createGraphTexture(graph, "display", graph.textures[output].width, graph.textures[output].height,
+                                 RenderTargetFormat::RGBA8)
+            : output;
+    const bool useBloom = settings.bloom;
+    const GraphPass tonemap = addGraphPass(graph, "tonemap",
+                                           [&post, scene, bloom, useBloom](const RenderGraph &frameGraph) {
+        const PostProcessSettings &settings = post.settings;
+        const PostProgram &program = useBloom ? post.tonemapBloom : post.tonemap;
+        glUseProgram(program.program);
+        glUniform1f(program.uniforms[EXPOSURE], settings.exposure);
+        glUniform1f(program.uniforms[BLOOM_INTENSITY], settings.bloomIntensity);
+        glUniform3fv(program.uniforms[LIFT], 1, settings.lift);
+        glUniform3fv(program.uniforms[GAMMA], 1, settings.gamma);
+        glUniform3fv(program.uniforms[GAIN], 1, settings.gain);
+        glUniform2f(program.uniforms[GRADE], settings.saturation, settings.contrast);
+        glActiveTexture(GL_TEXTURE0 + BLOOM_UNIT);
+        glBindTexture(GL_TEXTURE_2D, useBloom ? graphTarget(frameGraph, bloom).texture : 0);
+        drawFullscreen(post, graphTarget(frameGraph, scene).texture);
+        glActiveTexture(GL_TEXTURE0 + BLOOM_UNIT);
+        glBindTexture(GL_TEXTURE_2D, 0);
+        glActiveTexture(GL_TEXTURE0);
+    });
+    readGraphTexture(graph, tonemap, scene);
+    if (useBloom) {
+        readGraphTexture(graph, tonemap, bloom);
+    }
+    writeGraphTexture(graph, tonemap, display);
+
+    if (settings.fxaa) {
+        const GraphPass fxaa = addGraphPass(graph, "fxaa", [&post, display](const RenderGraph &frameGraph) {
+            const RenderTarget &source = graphTarget(frameGraph, display);
+            glUseProgram(post.fxaa.program);
+            setTexelSize(post.fxaa, TEXEL_SIZE, source.width, source.height);
+            drawFullscreen(post, source.texture);
+        });
+        readGraphTexture(graph, fxaa, display);
+        writeGraphTexture(graph, fxaa, output);
+    }
+}
@@ -0,0 +1,27 @@
+#include <profiler.h>
+
+#include <algorithm>
+
+void recordProfileSample(Profiler &profiler, std::string_view name, double milliseconds) {
+    auto counter = std::ranges::find(profiler.counters, name, &ProfileCounter::name);
+    if (counter == profiler.counters.end()) {
+        counter = profiler.counters.insert(counter, ProfileCounter{std::string(name)});
+    }
+    counter->last = milliseconds;
+    counter->total += milliseconds;
+    counter->max = std::max(counter->max, milliseconds);
+    counter->samples++;
+}
+
+const ProfileCounter *findProfileCounter(const Profiler &profiler, std::string_view name) {
+    const auto counter = std::ranges::find(profiler.counters, name, &ProfileCounter::name);
+    return counter == profiler.counters.end() ? nullptr : &*counter;
+}
+
+void printProfile(const Profiler &profiler, std::ostream &out) {
+    for (const ProfileCounter &counter : profiler.counters) {
+        const double average = counter.samples ? counter.total / static_cast<double>(counter.samples) : 0.0;
+        out << counter.name << ": " << average << " ms average, " << counter.max << " ms max, " << counter.last
+            << " ms last (" << counter.samples << " samples)" << std::endl;
+    }
+}
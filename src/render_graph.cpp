@@ -0,0 +1,254 @@
+#include <render_graph.h>
+
+#include <GLEW/glew.h>
+
+#include <algorithm>
+#include <functional>
+#include <iostream>
+#include <queue>
+
+namespace {
+
+GpuTimer &passTimer(RenderGraph &graph, const std::string &name) {
+    const auto timer = std::ranges::find(graph.timers, name, &std::pair<std::string, GpuTimer>::first);
+    if (timer != graph.timers.end()) {
+        return timer->second;
+    }
+    graph.timers.emplace_back(name, GpuTimer{});
+    initGpuTimer(graph.timers.back().second);
+    return graph.timers.back().second;
+}
+
+// Finds every texture's producer and keeps the passes something visible depends on
+int cullPasses(RenderGraph &graph) {
+    for (GraphPass pass = 0; pass < graph.passes.size(); pass++) {
+        for (const GraphTexture texture : graph.passes[pass].writes) {
+            RenderGraphTextureNode &node = graph.textures[texture];
+            if (node.producer != GRAPH_NONE) {
+                std::cerr << "Render graph texture " << node.name << " is written by both "
+                          << graph.passes[node.producer].name << " and " << graph.passes[pass].name << std::endl;
+                return -1;
+            }
+            node.producer = pass;
+        }
+    }
+
+    std::vector<GraphPass> pending;
+    for (GraphPass pass = 0; pass < graph.passes.size(); pass++) {
+        RenderGraphPassNode &node = graph.passes[pass];
+        node.culled = !node.sideEffects && std::ranges::none_of(node.writes, [&](GraphTexture texture) {
+            return graph.textures[texture].imported;
+        });
+        if (!node.culled) {
+            pending.push_back(pass);
+        }
+    }
+    while (!pending.empty()) {
+        const GraphPass pass = pending.back();
+        pending.pop_back();
+        for (const GraphTexture texture : graph.passes[pass].reads) {
+            const RenderGraphTextureNode &node = graph.textures[texture];
+            if (node.producer == GRAPH_NONE) {
+                if (!node.imported) {
+                    std::cerr << "Render graph texture " << node.name << " is read by " << graph.passes[pass].name
+                              << " but never written" << std::endl;
+                    return -1;
+                }
+                continue;
+            }
+            if (graph.passes[node.producer].culled) {
+                graph.passes[node.producer].culled = false;
+                pending.push_back(node.producer);
+            }
+        }
+    }
+    return 0;
+}
+
+// Kahn's algorithm over the surviving passes, declaration order among the ready ones
+int orderPasses(RenderGraph &graph) {
+    std::vector<std::uint32_t> waiting(graph.passes.size(), 0);
+    std::vector<std::vector<GraphPass>> dependents(graph.passes.size());
+    std::priority_queue<GraphPass, std::vector<GraphPass>, std::greater<>> ready;
+    std::size_t alive = 0;
+    for (GraphPass pass = 0; pass < graph.passes.size(); pass++) {
+        const RenderGraphPassNode &node = graph.passes[pass];
+        if (node.culled) {
+            continue;
+        }
+        alive++;
+        for (const GraphTexture texture : node.reads) {
+            const GraphPass producer = graph.textures[texture].producer;
+            if (producer != GRAPH_NONE && std::ranges::find(dependents[producer], pass) == dependents[producer].end()) {
+                dependents[producer].push_back(pass);
+                waiting[pass]++;
+            }
+        }
+        if (waiting[pass] == 0) {
+            ready.push(pass);
+        }
+    }
+
+    while (!ready.empty()) {
+        const GraphPass pass = ready.top();
+        ready.pop();
+        graph.order.push_back(pass);
+        for (const GraphPass dependent : dependents[pass]) {
+            if (--waiting[dependent] == 0) {
+                ready.push(dependent);
+            }
+        }
+    }
+    if (graph.order.size() != alive) {
+        std::cerr << "Render graph passes depend on each other in a cycle" << std::endl;
+        return -1;
+    }
+    return 0;
+}
+
+// Transients sorted by first use take the first allocation of their size and format that was last used before
+void aliasTextures(RenderGraph &graph) {
+    std::vector<GraphTexture> transients;
+    for (std::uint32_t position = 0; position < graph.order.size(); position++) {
+        const RenderGraphPassNode &pass = graph.passes[graph.order[position]];
+        for (const GraphTexture texture : pass.writes) {
+            RenderGraphTextureNode &node = graph.textures[texture];
+            node.firstUse = position;
+            node.lastUse = position;
+            if (!node.imported) {
+                transients.push_back(texture);
+            }
+        }
+        for (const GraphTexture texture : pass.reads) {
+            RenderGraphTextureNode &node = graph.textures[texture];
+            node.lastUse = std::max(node.lastUse, position);
+        }
+    }
+    std::ranges::stable_sort(transients, {}, [&](GraphTexture texture) { return graph.textures[texture].firstUse; });
+
+    for (const GraphTexture texture : transients) {
+        RenderGraphTextureNode &node = graph.textures[texture];
+        auto allocation = std::ranges::find_if(graph.allocations, [&](const RenderGraph::Allocation &candidate) {
+            return candidate.width == node.width && candidate.height == node.height &&
+                   candidate.format == node.format && candidate.lastUse < node.firstUse;
+        });
+        if (allocation == graph.allocations.end()) {
+            graph.allocations.push_back({node.width, node.height, node.format, 0, {}});
+            allocation = graph.allocations.end() - 1;
+            graph.stats.allocatedBytes += renderTargetBytes(node.width, node.height, node.format);
+        }
+        allocation->lastUse = node.lastUse;
+        node.physical = static_cast<std::uint32_t>(allocation - graph.allocations.begin());
+        graph.stats.transientBytes += renderTargetBytes(node.width, node.height, node.format);
+    }
+    graph.stats.transientTextures = transients.size();
+    graph.stats.allocations = graph.allocations.size();
+}
+
+} // namespace
+
+void beginRenderGraph(RenderGraph &graph) {
+    graph.textures.clear();
+    graph.passes.clear();
+    graph.order.clear();
+    graph.allocations.clear();
+    graph.stats = RenderGraphStats{};
+    graph.compiled = false;
+}
+
+void destroyRenderGraph(RenderGraph &graph) {
+    for (auto &[name, timer] : graph.timers) {
+        destroyGpuTimer(timer);
+    }
+    graph = RenderGraph{};
+}
+
+GraphTexture createGraphTexture(RenderGraph &graph, std::string_view name, int width, int height,
+                                RenderTargetFormat format) {
+    RenderGraphTextureNode &node = graph.textures.emplace_back();
+    node.name = name;
+    node.width = std::max(width, 1);
+    node.height = std::max(height, 1);
+    node.format = format;
+    return static_cast<GraphTexture>(graph.textures.size() - 1);
+}
+
+GraphTexture importGraphTexture(RenderGraph &graph, std::string_view name, const RenderTarget &target) {
+    RenderGraphTextureNode &node = graph.textures.emplace_back();
+    node.name = name;
+    node.width = target.width;
+    node.height = target.height;
+    node.format = target.format;
+    node.imported = true;
+    node.target = target;
+    return static_cast<GraphTexture>(graph.textures.size() - 1);
+}
+
+GraphPass addGraphPass(RenderGraph &graph, std::string_view name, GraphPassFunction execute) {
+    RenderGraphPassNode &node = graph.passes.emplace_back();
+    node.name = name;
+    node.execute = std::move(execute);
+    return static_cast<GraphPass>(graph.passes.size() - 1);
+}
+
+void readGraphTexture(RenderGraph &graph, GraphPass pass, GraphTexture texture) {
+    graph.passes[pass].reads.push_back(texture);
+}
+
+void writeGraphTexture(RenderGraph &graph, GraphPass pass, GraphTexture texture) {
+    graph.passes[pass].writes.push_back(texture);
+}
+
+void markGraphSideEffects(RenderGraph &graph, GraphPass pass) {
+    graph.passes[pass].sideEffects = true;
+}
+
+int compileRenderGraph(RenderGraph &graph) {
+    if (cullPasses(graph) != 0 || orderPasses(graph) != 0) {
+        return -1;
+    }
+    aliasTextures(graph);
+    graph.stats.passes = graph.passes.size();
+    graph.stats.culledPasses = graph.passes.size() - graph.order.size();
+    graph.compiled = true;
+    return 0;
+}
+
+void executeRenderGraph(RenderGraph &graph, RenderTargetPool &targets, Profiler &profiler) {
+    if (!graph.compiled) {
+        return;
+    }
+    for (RenderGraph::Allocation &allocation : graph.allocations) {
+        allocation.target = acquireRenderTarget(targets, allocation.width, allocation.height, allocation.format);
+    }
+    for (RenderGraphTextureNode &node : graph.textures) {
+        if (node.physical != GRAPH_NONE) {
+            node.target = graph.allocations[node.physical].target;
+        }
+    }
+
+    for (const GraphPass pass : graph.order) {
+        const RenderGraphPassNode &node = graph.passes[pass];
+        if (!node.writes.empty()) {
+            const RenderTarget &target = graph.textures[node.writes.front()].target;
+            glBindFramebuffer(GL_FRAMEBUFFER, target.framebuffer);
+            glViewport(0, 0, target.width, target.height);
+        }
+        GpuTimer &timer = passTimer(graph, node.name);
+        beginGpuTimer(timer);
+        node.execute(graph);
+        endGpuTimer(timer);
+        if (double milliseconds; pollGpuTimer(timer, milliseconds)) {
+            recordProfileSample(profiler, node.name, milliseconds);
+        }
+    }
+    glBindFramebuffer(GL_FRAMEBUFFER, 0);
+
+    for (const RenderGraph::Allocation &allocation : graph.allocations) {
+        releaseRenderTarget(targets, allocation.target);
+    }
+}
+
+const RenderTarget &graphTarget(const RenderGraph &graph, GraphTexture texture) {
+    return graph.textures[texture].target;
+}
@@ -0,0 +1,241 @@
+#include <render_queue.h>
+
+#include <GLEW/glew.h>
+
+#include <algorithm>
+#include <bit>
+#include <iostream>
+#include <utility>
+
+namespace {
+
+constexpr std::uint64_t PROGRAM_MASK = (1u << 10) - 1;
+constexpr std::uint64_t MATERIAL_MASK = (1u << 12) - 1;
+constexpr std::uint64_t TEXTURE_MASK = (1u << 12) - 1;
+constexpr std::uint64_t DEPTH_MASK = (1u << 24) - 1;
+
+constexpr unsigned int NO_STATE = ~0u;
+
+void setUniform(const DrawUniform &uniform) {
+    switch (uniform.components) {
+        case 1: glUniform1f(uniform.location, uniform.value[0]); break;
+        case 2: glUniform2f(uniform.location, uniform.value[0], uniform.value[1]); break;
+        case 3: glUniform3f(uniform.location, uniform.value[0], uniform.value[1], uniform.value[2]); break;
+        default: glUniform4f(uniform.location, uniform.value[0], uniform.value[1], uniform.value[2], uniform.value[3]); break;
+    }
+}
+
+// Counts the binds a sequence of items needs, used for both the sorted and the submission order
+struct StateTracker {
+    unsigned int program = NO_STATE;
+    unsigned int vertexArray = NO_STATE;
+    unsigned int texture = NO_STATE;
+    unsigned int material = NO_STATE;
+
+    // Bitmask of what changed: 1 program, 2 vertex array, 4 texture, 8 material
+    unsigned int update(const DrawItem &item) {
+        unsigned int changed = 0;
+        if (item.program != program) {
+            program = item.program;
+            material = NO_STATE; // uniforms are per program, a new program needs its material again
+            changed |= 1;
+        }
+        if (item.vertexArray != vertexArray) {
+            vertexArray = item.vertexArray;
+            changed |= 2;
+        }
+        if (item.texture != texture) {
+            texture = item.texture;
+            changed |= 4;
+        }
+        if (item.material != material) {
+            material = item.material;
+            changed |= 8;
+        }
+        return changed;
+    }
+};
+
+} // namespace
+
+std::uint64_t makeSortKey(RenderPass pass, unsigned int program, unsigned int material, unsigned int texture,
+                          float depth) {
+    const auto passBits = static_cast<std::uint64_t>(pass) & 0xF;
+    const std::uint64_t state = ((program & PROGRAM_MASK) << 24) | ((material & MATERIAL_MASK) << 12) |
+                                (texture & TEXTURE_MASK);
+    auto depthBits = static_cast<std::uint64_t>(std::clamp(depth, 0.0f, 1.0f) * static_cast<float>(DEPTH_MASK));
+
+    if (pass == RenderPass::TRANSLUCENT) {
+        depthBits = DEPTH_MASK - depthBits; // far first
+        return (passBits << 60) | (depthBits << 36) | (state << 2);
+    }
+    return (passBits << 60) | (state << 26) | (depthBits << 2);
+}
+
+void initRenderQueue(RenderQueue &queue) {
+    queue.multiDrawIndirect = GLEW_VERSION_4_3 || (GLEW_ARB_draw_indirect && GLEW_ARB_multi_draw_indirect);
+    if (queue.multiDrawIndirect) {
+        glGenBuffers(1, &queue.indirectBuffer);
+    }
+}
+
+unsigned int addMaterial(RenderQueue &queue, Material material) {
+    queue.materials.push_back(std::move(material));
+    return static_cast<unsigned int>(queue.materials.size() - 1);
+}
+
+void beginRenderQueue(RenderQueue &queue) {
+    queue.keys.clear();
+    queue.order.clear();
+    queue.items.clear();
+    queue.uniforms.clear();
+    queue.blocks.clear();
+    queue.commands.clear();
+    queue.stats = {};
+}
+
+void submitDraw(RenderQueue &queue, RenderPass pass, float depth, unsigned int program, unsigned int vertexArray,
+                unsigned int texture, unsigned int material, std::span<const DrawUniform> drawUniforms,
+                std::span<const UniformBlockRange> drawBlocks,
+                std::span<const DrawElementsIndirectCommand> drawCommands) {
+    if (drawCommands.empty()) {
+        return;
+    }
+    for (const UniformBlockRange &block : drawBlocks) {
+        if (block.binding >= MAX_BLOCK_BINDINGS) {
+            std::cerr << "Uniform block binding " << block.binding << " is not below " << MAX_BLOCK_BINDINGS
+                      << ", draw dropped" << std::endl;
+            return;
+        }
+    }
+    DrawItem item{
+            program, vertexArray, texture, material,
+            static_cast<std::uint32_t>(queue.uniforms.size()), static_cast<std::uint32_t>(drawUniforms.size()),
+            static_cast<std::uint32_t>(queue.blocks.size()), static_cast<std::uint32_t>(drawBlocks.size()),
+            static_cast<std::uint32_t>(queue.commands.size()), static_cast<std::uint32_t>(drawCommands.size())
+    };
+    queue.uniforms.insert(queue.uniforms.end(), drawUniforms.begin(), drawUniforms.end());
+    queue.blocks.insert(queue.blocks.end(), drawBlocks.begin(), drawBlocks.end());
+    queue.commands.insert(queue.commands.end(), drawCommands.begin(), drawCommands.end());
+
+    queue.keys.push_back(makeSortKey(pass, program, material, texture, depth));
+    queue.order.push_back(static_cast<std::uint32_t>(queue.items.size()));
+    queue.items.push_back(item);
+}
+
+void sortRenderQueue(RenderQueue &queue) {
+    const std::size_t count = queue.keys.size();
+    queue.scratchKeys.resize(count);
+    queue.scratchOrder.resize(count);
+
+    for (int shift = 0; shift < 64; shift += 8) {
+        std::size_t histogram[256] = {};
+        for (std::uint64_t key : queue.keys) {
+            histogram[(key >> shift) & 0xFF]++;
+        }
+        // Every key has the same digit: this pass would not move anything
+        if (std::find(std::begin(histogram), std::end(histogram), count) != std::end(histogram)) {
+            continue;
+        }
+
+        std::size_t offset = 0;
+        for (std::size_t &bucket : histogram) {
+            const std::size_t size = bucket;
+            bucket = offset;
+            offset += size;
+        }
+        for (std::size_t i = 0; i < count; i++) {
+            const std::size_t destination = histogram[(queue.keys[i] >> shift) & 0xFF]++;
+            queue.scratchKeys[destination] = queue.keys[i];
+            queue.scratchOrder[destination] = queue.order[i];
+        }
+        queue.keys.swap(queue.scratchKeys);
+        queue.order.swap(queue.scratchOrder);
+    }
+}
+
+void executeRenderQueue(RenderQueue &queue) {
+    RenderQueueStats &stats = queue.stats;
+    stats.draws = queue.items.size();
+    if (queue.items.empty()) {
+        return;
+    }
+
+    {
+        StateTracker unsorted;
+        for (const DrawItem &item : queue.items) {
+            stats.unsortedStateChanges += static_cast<std::size_t>(std::popcount(unsorted.update(item)));
+        }
+    }
+
+    // One upload for every command of the frame, draws then point into it
+    if (queue.multiDrawIndirect) {
+        glBindBuffer(GL_DRAW_INDIRECT_BUFFER, queue.indirectBuffer);
+        const auto size = static_cast<GLsizeiptr>(queue.commands.size() * sizeof(DrawElementsIndirectCommand));
+        glBufferData(GL_DRAW_INDIRECT_BUFFER, size, nullptr, GL_STREAM_DRAW);
+        glBufferSubData(GL_DRAW_INDIRECT_BUFFER, 0, size, queue.commands.data());
+    }
+
+    StateTracker state;
+    UniformBlockRange boundBlocks[MAX_BLOCK_BINDINGS] = {};
+    std::vector<GLsizei> counts;
+    std::vector<const void *> offsets;
+    for (std::uint32_t index : queue.order) {
+        const DrawItem &item = queue.items[index];
+        const unsigned int changed = state.update(item);
+
+        if (changed & 1) {
+            glUseProgram(item.program);
+            stats.programChanges++;
+        }
+        if (changed & 2) {
+            glBindVertexArray(item.vertexArray);
+            stats.vertexArrayChanges++;
+        }
+        if (changed & 4) {
+            glBindTexture(GL_TEXTURE_2D, item.texture);
+            stats.textureChanges++;
+        }
+        if (changed & 8) {
+            if (item.material < queue.materials.size()) {
+                for (const DrawUniform &uniform : queue.materials[item.material].uniforms) {
+                    setUniform(uniform);
+                }
+            }
+            stats.materialChanges++;
+        }
+        for (std::uint32_t b = item.firstBlock; b < item.firstBlock + item.blockCount; b++) {
+            const UniformBlockRange &block = queue.blocks[b];
+            UniformBlockRange &bound = boundBlocks[block.binding];
+            if (block.buffer != bound.buffer || block.offset != bound.offset || block.size != bound.size) {
+                glBindBufferRange(GL_UNIFORM_BUFFER, block.binding, block.buffer, block.offset, block.size);
+                bound = block;
+                stats.blockBinds++;
+            }
+        }
+        for (std::uint32_t u = item.firstUniform; u < item.firstUniform + item.uniformCount; u++) {
+            setUniform(queue.uniforms[u]);
+        }
+
+        if (queue.multiDrawIndirect) {
+            const auto offset = static_cast<std::uintptr_t>(item.firstCommand) * sizeof(DrawElementsIndirectCommand);
+            glMultiDrawElementsIndirect(GL_TRIANGLES, GL_UNSIGNED_INT, reinterpret_cast<const void *>(offset),
+                                        static_cast<GLsizei>(item.commandCount), 0);
+        } else {
+            counts.clear();
+            offsets.clear();
+            for (std::uint32_t c = item.firstCommand; c < item.firstCommand + item.commandCount; c++) {
+                counts.push_back(static_cast<GLsizei>(queue.commands[c].count));
+                offsets.push_back(reinterpret_cast<const void *>(
+                        static_cast<std::uintptr_t>(queue.commands[c].firstIndex) * sizeof(unsigned int)));
+            }
+            glMultiDrawElements(GL_TRIANGLES, counts.data(), GL_UNSIGNED_INT, offsets.data(),
+                                static_cast<GLsizei>(item.commandCount));
+        }
+    }
+    stats.stateChanges = stats.programChanges + stats.vertexArrayChanges + stats.textureChanges + stats.materialChanges;
+
+    if (queue.multiDrawIndirect) {
+        glBindBuffer(GL_DRAW_INDIRECT_BUFFER, 0);
+    }
+}
@@ -0,0 +1,113 @@
+#include <render_target.h>
+
+#include <GLEW/glew.h>
+
+#include <algorithm>
+#include <iostream>
+
+namespace {
+
+struct TextureFormat {
+    GLenum internalFormat;
+    GLenum format;
+    GLenum type;
+    std::size_t bytesPerPixel;
+};
+
+TextureFormat textureFormat(RenderTargetFormat format) {
+    switch (format) {
+        case RenderTargetFormat::RGBA16F:
+            return {GL_RGBA16F, GL_RGBA, GL_HALF_FLOAT, 8};
+        case RenderTargetFormat::R11F_G11F_B10F:
+            return {GL_R11F_G11F_B10F, GL_RGB, GL_UNSIGNED_INT_10F_11F_11F_REV, 4};
+        case RenderTargetFormat::RGBA8:
+        default:
+            return {GL_RGBA8, GL_RGBA, GL_UNSIGNED_BYTE, 4};
+    }
+}
+
+RenderTarget createTarget(int width, int height, RenderTargetFormat format) {
+    RenderTarget target{0, 0, width, height, format};
+    const TextureFormat texture = textureFormat(format);
+    glGenTextures(1, &target.texture);
+    glBindTexture(GL_TEXTURE_2D, target.texture);
+    glTexImage2D(GL_TEXTURE_2D, 0, static_cast<GLint>(texture.internalFormat), width, height, 0, texture.format,
+                 texture.type, nullptr);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+    glBindTexture(GL_TEXTURE_2D, 0);
+
+    glGenFramebuffers(1, &target.framebuffer);
+    glBindFramebuffer(GL_FRAMEBUFFER, target.framebuffer);
+    glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, target.texture, 0);
+    if (glCheckFramebufferStatus(GL_FRAMEBUFFER) != GL_FRAMEBUFFER_COMPLETE) {
+        std::cerr << "Render target " << width << "x" << height << " is incomplete" << std::endl;
+    }
+    glBindFramebuffer(GL_FRAMEBUFFER, 0);
+    return target;
+}
+
+void deleteTarget(RenderTarget &target) {
+    glDeleteFramebuffers(1, &target.framebuffer);
+    glDeleteTextures(1, &target.texture);
+    target = RenderTarget{};
+}
+
+} // namespace
+
+RenderTarget acquireRenderTarget(RenderTargetPool &pool, int width, int height, RenderTargetFormat format) {
+    width = std::max(width, 1);
+    height = std::max(height, 1);
+    for (RenderTargetPool::Slot &slot : pool.slots) {
+        if (!slot.inUse && slot.target.width == width && slot.target.height == height &&
+            slot.target.format == format) {
+            slot.inUse = true;
+            slot.lastUsedFrame = pool.frame;
+            return slot.target;
+        }
+    }
+    pool.slots.push_back({createTarget(width, height, format), true, pool.frame});
+    pool.created++;
+    return pool.slots.back().target;
+}
+
+void releaseRenderTarget(RenderTargetPool &pool, const RenderTarget &target) {
+    for (RenderTargetPool::Slot &slot : pool.slots) {
+        if (slot.target.texture == target.texture) {
+            slot.inUse = false;
+            return;
+        }
+    }
+}
+
+void trimRenderTargets(RenderTargetPool &pool, std::uint64_t idleFrames) {
+    std::erase_if(pool.slots, [&](RenderTargetPool::Slot &slot) {
+        if (slot.inUse || pool.frame - slot.lastUsedFrame < idleFrames) {
+            return false;
+        }
+        deleteTarget(slot.target);
+        return true;
+    });
+    pool.frame++;
+}
+
+void destroyRenderTargetPool(RenderTargetPool &pool) {
+    for (RenderTargetPool::Slot &slot : pool.slots) {
+        deleteTarget(slot.target);
+    }
+    pool.slots.clear();
+}
+
+std::size_t renderTargetBytes(int width, int height, RenderTargetFormat format) {
+    return static_cast<std::size_t>(width) * static_cast<std::size_t>(height) * textureFormat(format).bytesPerPixel;
+}
+
+std::size_t renderTargetPoolBytes(const RenderTargetPool &pool) {
+    std::size_t bytes = 0;
+    for (const RenderTargetPool::Slot &slot : pool.slots) {
+        bytes += renderTargetBytes(slot.target.width, slot.target.height, slot.target.format);
+    }
+    return bytes;
+}
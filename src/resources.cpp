@@ -0,0 +1,157 @@
+#include <resources.h>
+
+#include <asset_pack.h>
+
+#include <algorithm>
+#include <filesystem>
+#include <iostream>
+#include <system_error>
+#include <vector>
+
+#ifdef _WIN32
+#define WIN32_LEAN_AND_MEAN
+#define NOMINMAX
+#include <windows.h>
+#endif
+
+namespace {
+
+AssetPack mountedPack;
+std::filesystem::path resourceRoot;
+
+} // namespace
+
+#ifndef LEARN_OPENGL_EMBED_RESOURCES
+// Otherwise defined by the generated embedded_resources.cpp
+std::span<const EmbeddedResource> embeddedResources() {
+    return {};
+}
+#endif
+
+const EmbeddedResource *findEmbeddedResource(std::string_view path) {
+    const std::span<const EmbeddedResource> resources = embeddedResources();
+    const auto found = std::ranges::lower_bound(resources, path, {}, &EmbeddedResource::path);
+    return found != resources.end() && found->path == path ? &*found : nullptr;
+}
+
+std::string normalizeResourcePath(std::string_view path) {
+    std::vector<std::string_view> parts;
+    std::size_t start = 0;
+    while (start <= path.size()) {
+        std::size_t end = path.find_first_of("/\\", start);
+        if (end == std::string_view::npos) {
+            end = path.size();
+        }
+        const std::string_view part = path.substr(start, end - start);
+        if (part == "..") {
+            if (!parts.empty() && parts.back() != "..") {
+                parts.pop_back();
+            } else {
+                parts.push_back(part); // escapes the root, leave it to the file system
+            }
+        } else if (!part.empty() && part != ".") {
+            parts.push_back(part);
+        }
+        start = end + 1;
+    }
+
+    std::string normalized = !path.empty() && (path.front() == '/' || path.front() == '\\') ? "/" : "";
+    for (std::size_t i = 0; i < parts.size(); i++) {
+        normalized += i == 0 ? "" : "/";
+        normalized += parts[i];
+    }
+    return normalized;
+}
+
+std::string executableDirectory() {
+#ifdef _WIN32
+    wchar_t path[MAX_PATH];
+    const DWORD length = GetModuleFileNameW(nullptr, path, MAX_PATH);
+    return length > 0 && length < MAX_PATH ? std::filesystem::path(path).parent_path().generic_string() : "";
+#else
+    std::error_code error;
+    const std::filesystem::path path = std::filesystem::read_symlink("/proc/self/exe", error);
+    return error ? "" : path.parent_path().generic_string();
+#endif
+}
+
+void setResourceRoot(std::string_view directory) {
+    resourceRoot = std::filesystem::path(std::string(directory));
+}
+
+std::string resourceFilePath(std::string_view path) {
+    const std::string normalized = normalizeResourcePath(path);
+    if (std::filesystem::path(normalized).is_absolute() || resourceRoot.empty()) {
+        return normalized;
+    }
+
+    const std::filesystem::path candidates[] = {resourceRoot / normalized, std::filesystem::path(normalized)};
+    std::error_code error;
+    for (const std::filesystem::path &candidate : candidates) {
+        if (std::filesystem::exists(candidate, error)) {
+            return candidate.generic_string();
+        }
+    }
+    for (const std::filesystem::path &candidate : candidates) {
+        if (std::filesystem::is_directory(candidate.parent_path().empty() ? "." : candidate.parent_path(), error)) {
+            return candidate.generic_string();
+        }
+    }
+    return candidates[0].generic_string();
+}
+
+int mountResourcePack(std::string_view packPath) {
+    return openAssetPack(resourceFilePath(packPath), mountedPack);
+}
+
+int openResource(std::string_view path, ResourceData &data) {
+    closeResource(data);
+    const std::string normalized = normalizeResourcePath(path);
+    if (const EmbeddedResource *resource = findEmbeddedResource(normalized)) {
+        data.bytes = {resource->data, resource->size};
+        return 0;
+    }
+    if (const AssetPackEntry *entry = findAsset(mountedPack, normalized)) {
+        if (const unsigned char *stored = assetData(mountedPack, *entry)) {
+            data.bytes = {stored, static_cast<std::size_t>(entry->size)};
+            return 0;
+        }
+        data.storage.resize(entry->size);
+        if (readAsset(mountedPack, *entry, data.storage.data()) != 0) {
+            closeResource(data);
+            return -1;
+        }
+        data.bytes = data.storage;
+        return 0;
+    }
+
+    const std::string filePath = resourceFilePath(normalized);
+    std::error_code error;
+    const std::uintmax_t size = std::filesystem::file_size(filePath, error);
+    if (error) {
+        return -1;
+    }
+    if (size > 0) { // empty files cannot be mapped
+        if (data.file.open(filePath) != 0) {
+            return -1;
+        }
+        data.bytes = {data.file.data(), data.file.size()};
+    }
+    return 0;
+}
+
+void closeResource(ResourceData &data) {
+    data.bytes = {};
+    data.storage = {};
+    data.file.close();
+}
+
+int readResource(std::string_view path, std::string &contents) {
+    ResourceData data;
+    if (openResource(path, data) != 0) {
+        std::cerr << "Failed to open " << normalizeResourcePath(path) << std::endl;
+        return -1;
+    }
+    contents.assign(reinterpret_cast<const char *>(data.bytes.data()), data.bytes.size());
+    return 0;
+}
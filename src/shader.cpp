@@ -0,0 +1,244 @@
+#include <shader.h>
+
+#include <GLEW/glew.h>
+
+#include <algorithm>
+#include <iostream>
+#include <vector>
+
+namespace {
+
+// Indexed by ShaderStage
+constexpr GLenum STAGE_TYPES[SHADER_STAGE_COUNT] = {
+        GL_VERTEX_SHADER,
+        GL_TESS_CONTROL_SHADER,
+        GL_TESS_EVALUATION_SHADER,
+        GL_GEOMETRY_SHADER,
+        GL_FRAGMENT_SHADER,
+        GL_COMPUTE_SHADER
+};
+
+bool isStageSupported(ShaderStage stage) {
+    switch (stage) {
+        case ShaderStage::TESS_CONTROL:
+        case ShaderStage::TESS_EVALUATION:
+            return GLEW_VERSION_4_0 || GLEW_ARB_tessellation_shader;
+        case ShaderStage::COMPUTE:
+            return isComputeSupported();
+        default:
+            return true; // geometry shaders are core since 3.2
+    }
+}
+
+// Inserts `#define KEYWORD 1` for every enabled keyword after the #version line, which has to stay first
+std::string applyKeywords(const std::string &source, const std::vector<std::string> &keywords, std::uint64_t mask) {
+    std::string defines;
+    for (std::size_t i = 0; i < keywords.size(); i++) {
+        if (mask & (std::uint64_t{1} << i)) {
+            defines += "#define " + keywords[i] + " 1\n";
+        }
+    }
+    if (defines.empty()) {
+        return source;
+    }
+    std::size_t insertAt = 0;
+    if (const std::size_t version = source.find("#version"); version != std::string::npos) {
+        const std::size_t lineEnd = source.find('\n', version);
+        insertAt = lineEnd == std::string::npos ? source.size() : lineEnd + 1;
+    }
+    std::string result = source;
+    result.insert(insertAt, defines);
+    return result;
+}
+
+// std140 fixes the layout, so any difference to the struct is a mismatched declaration
+int checkBlockLayout(unsigned int program, unsigned int index, const UniformBlockBinding &block) {
+    GLint size = 0;
+    glGetActiveUniformBlockiv(program, index, GL_UNIFORM_BLOCK_DATA_SIZE, &size);
+    int result = 0;
+    if (static_cast<std::size_t>(size) != block.size) {
+        std::cerr << "Block " << block.name << " is " << size << " bytes in GLSL, " << block.size << " in C++"
+                  << std::endl;
+        result = -1;
+    }
+
+    std::vector<const char *> names;
+    for (const auto &[name, offset] : block.members) {
+        names.push_back(name.c_str());
+    }
+    std::vector<GLuint> indices(names.size());
+    std::vector<GLint> offsets(names.size(), -1);
+    glGetUniformIndices(program, static_cast<GLsizei>(names.size()), names.data(), indices.data());
+    for (std::size_t i = 0; i < names.size(); i++) {
+        if (indices[i] != GL_INVALID_INDEX) {
+            glGetActiveUniformsiv(program, 1, &indices[i], GL_UNIFORM_OFFSET, &offsets[i]);
+        }
+        if (offsets[i] < 0) {
+            std::cerr << "Block " << block.name << " has no member " << names[i] << " in GLSL" << std::endl;
+            result = -1;
+        } else if (static_cast<std::size_t>(offsets[i]) != block.members[i].second) {
+            std::cerr << "Member " << names[i] << " of block " << block.name << " is at offset " << offsets[i]
+                      << " in GLSL, " << block.members[i].second << " in C++" << std::endl;
+            result = -1;
+        }
+    }
+    return result;
+}
+
+} // namespace
+
+int compileAndLinkShaders(const ShaderSources &sources, unsigned int &shaderProgram, std::uint64_t keywordMask) {
+    if (validateShaderStages(sources) != 0) {
+        return -1;
+    }
+    for (int i = 0; i < SHADER_STAGE_COUNT; i++) {
+        if (!sources.stages[i].empty() && !isStageSupported(static_cast<ShaderStage>(i))) {
+            std::cerr << SHADER_STAGE_NAMES[i] << " shaders are not supported by this context" << std::endl;
+            return -1;
+        }
+    }
+
+    unsigned int shaderIds[SHADER_STAGE_COUNT] = {};
+    shaderProgram = glCreateProgram();
+
+    auto fail = [&] {
+        for (unsigned int shaderId : shaderIds) {
+            glDeleteShader(shaderId);
+        }
+        glDeleteProgram(shaderProgram);
+        shaderProgram = 0;
+        return -1;
+    };
+
+    for (int i = 0; i < SHADER_STAGE_COUNT; i++) {
+        if (sources.stages[i].empty()) {
+            continue;
+        }
+        const std::string variant = applyKeywords(sources.stages[i], sources.keywords, keywordMask);
+        const char *source = variant.c_str();
+        shaderIds[i] = glCreateShader(STAGE_TYPES[i]);
+        glShaderSource(shaderIds[i], 1, &source, nullptr);
+        glCompileShader(shaderIds[i]);
+
+        int success;
+        char log[512];
+        glGetShaderiv(shaderIds[i], GL_COMPILE_STATUS, &success);
+
+        if (!success) {
+            glGetShaderInfoLog(shaderIds[i], 512, nullptr, log);
+            std::cerr << SHADER_STAGE_NAMES[i] << " shader compilation failed: " << log << std::endl;
+            return fail();
+        }
+
+        glAttachShader(shaderProgram, shaderIds[i]);
+    }
+
+    glLinkProgram(shaderProgram);
+
+    { // Error handling
+        int success;
+        char log[512];
+        glGetProgramiv(shaderProgram, GL_LINK_STATUS, &success);
+
+        if (!success) {
+            glGetProgramInfoLog(shaderProgram, 512, nullptr, log);
+            std::cerr << "Shader program linking failed: " << log << std::endl;
+            return fail();
+        }
+    }
+
+    glUseProgram(shaderProgram);
+
+    for (unsigned int shaderId : shaderIds) {
+        glDeleteShader(shaderId); // 0 for missing stages, which GL ignores
+    }
+
+    return 0;
+}
+
+int loadShaderVariants(std::string_view shaderPath, ShaderVariants &variants, ShaderIncludeCache &includes) {
+    destroyShaderVariants(variants);
+    return parseShaders(shaderPath, variants.sources, includes);
+}
+
+unsigned int getShaderVariant(ShaderVariants &variants, std::uint64_t keywordMask) {
+    const auto [slot, inserted] = variants.programs.try_emplace(keywordMask, 0);
+    if (!inserted) {
+        return slot->second;
+    }
+    unsigned int program;
+    if (compileAndLinkShaders(variants.sources, program, keywordMask) != 0) {
+        std::cerr << "Could not build shader variant " << keywordMask << std::endl;
+        return 0;
+    }
+    for (const UniformBlockBinding &block : variants.blockBindings) {
+        const unsigned int index = glGetUniformBlockIndex(program, block.name.c_str());
+        if (index == GL_INVALID_INDEX) {
+            continue; // blocks can be compiled out by a keyword
+        }
+        if (checkBlockLayout(program, index, block) != 0) {
+            std::cerr << "Shader variant " << keywordMask << " does not match the C++ layout of block " << block.name
+                      << std::endl;
+            glDeleteProgram(program);
+            return 0;
+        }
+        glUniformBlockBinding(program, index, block.binding);
+    }
+    slot->second = program;
+    return program;
+}
+
+void destroyShaderVariants(ShaderVariants &variants) {
+    for (const auto &[mask, program] : variants.programs) {
+        glDeleteProgram(program);
+    }
+    variants.programs.clear();
+}
+
+bool isComputeSupported() {
+    return GLEW_VERSION_4_3 || GLEW_ARB_compute_shader;
+}
+
+int initComputeProgram(ComputeProgram &compute, unsigned int program) {
+    if (program == 0 || !isComputeSupported()) {
+        std::cerr << "Compute programs are not supported by this context" << std::endl;
+        return -1;
+    }
+    while (glGetError() != GL_NO_ERROR) {
+        // only the query below should be judged
+    }
+    GLint size[3] = {1, 1, 1};
+    glGetProgramiv(program, GL_COMPUTE_WORK_GROUP_SIZE, size);
+    if (glGetError() != GL_NO_ERROR) {
+        std::cerr << "Program " << program << " is not a compute program" << std::endl;
+        return -1;
+    }
+    compute.program = program;
+    for (int i = 0; i < 3; i++) {
+        compute.localSize[i] = static_cast<unsigned int>(std::max(size[i], 1));
+    }
+    return 0;
+}
+
+int dispatchCompute(const ComputeProgram &compute, unsigned int groupsX, unsigned int groupsY, unsigned int groupsZ,
+                    unsigned int barriers) {
+    if (compute.program == 0) {
+        return -1;
+    }
+    if (groupsX == 0 || groupsY == 0 || groupsZ == 0) {
+        return 0;
+    }
+    glUseProgram(compute.program);
+    glDispatchCompute(groupsX, groupsY, groupsZ);
+    if (barriers != 0 && glMemoryBarrier) { // ARB_compute_shader alone may come without image load/store
+        glMemoryBarrier(barriers);
+    }
+    return 0;
+}
+
+int dispatchComputeThreads(const ComputeProgram &compute, unsigned int threadsX, unsigned int threadsY,
+                           unsigned int threadsZ, unsigned int barriers) {
+    auto groups = [](unsigned int threads, unsigned int localSize) { return (threads + localSize - 1) / localSize; };
+    return dispatchCompute(compute, groups(threadsX, compute.localSize[0]), groups(threadsY, compute.localSize[1]),
+                           groups(threadsZ, compute.localSize[2]), barriers);
+}
@@ -0,0 +1,205 @@
+#include <shader.h>
+
+#include <resources.h>
+
+#include <algorithm>
+#include <iostream>
+#include <sstream>
+
+// Parsing and preprocessing of .shader files. Nothing here talks to GL, so the resource embedding tool links it to
+// expand includes at build time.
+
+namespace {
+
+// The directive a line starts with (ignoring indentation), and what follows it
+bool isDirective(std::string_view line, std::string_view directive, std::string_view &rest) {
+    const std::size_t start = line.find_first_not_of(" \t");
+    if (start == std::string_view::npos || line.substr(start, directive.size()) != directive) {
+        return false;
+    }
+    rest = line.substr(start + directive.size());
+    // "#include" must not match "#includes"
+    return rest.empty() || rest.front() == ' ' || rest.front() == '\t' || rest.front() == '"' || rest.front() == '\r';
+}
+
+// Resource path `#include "name"` refers to from `includer`
+int resolveInclude(std::string_view includer, std::string_view arguments, std::string &resolved) {
+    const std::size_t open = arguments.find('"');
+    const std::size_t close = open == std::string_view::npos ? open : arguments.find('"', open + 1);
+    if (close == std::string_view::npos) {
+        std::cerr << "Expected #include \"file\" in " << includer << std::endl;
+        return -1;
+    }
+    const std::size_t slash = includer.rfind('/');
+    const std::string_view directory = slash == std::string_view::npos ? "" : includer.substr(0, slash + 1);
+    const std::string_view name = arguments.substr(open + 1, close - open - 1);
+    resolved = normalizeResourcePath(std::string(directory) + std::string(name));
+    return 0;
+}
+
+// Appends the expansion of an included file. `stack` holds the files currently being expanded: meeting one of them
+// again means the include graph has a cycle.
+int expandInclude(const std::string &path, ShaderIncludeCache &includes, std::vector<std::string> &stack,
+                  std::string &out) {
+    if (const auto cached = includes.files.find(path); cached != includes.files.end()) {
+        out += cached->second;
+        return 0;
+    }
+    if (std::ranges::find(stack, path) != stack.end()) {
+        std::cerr << "Include cycle:";
+        for (auto it = std::ranges::find(stack, path); it != stack.end(); ++it) {
+            std::cerr << ' ' << *it << " ->";
+        }
+        std::cerr << ' ' << path << std::endl;
+        return -1;
+    }
+
+    std::string contents;
+    if (readResource(path, contents) != 0) {
+        return -1;
+    }
+    stack.push_back(path);
+    std::istringstream file{contents};
+    std::string expanded, line;
+    std::string_view rest;
+    while (std::getline(file, line)) {
+        if (isDirective(line, "#include", rest)) {
+            std::string included;
+            if (resolveInclude(path, rest, included) != 0 || expandInclude(included, includes, stack, expanded) != 0) {
+                return -1;
+            }
+        } else if (isDirective(line, "#shader", rest) || isDirective(line, "#keywords", rest)) {
+            std::cerr << "Included file " << path << " cannot declare stages or keywords" << std::endl;
+            return -1;
+        } else {
+            expanded += line;
+            expanded += '\n';
+        }
+    }
+    stack.pop_back();
+
+    out += expanded;
+    includes.files.emplace(path, std::move(expanded));
+    return 0;
+}
+
+} // namespace
+
+int parseShaders(const std::string_view shaderPath, ShaderSources &sources, ShaderIncludeCache &includes) {
+    const std::string path = normalizeResourcePath(shaderPath);
+    std::string contents;
+    if (readResource(path, contents) != 0) {
+        return -1;
+    }
+    std::istringstream file{contents};
+    std::string stages[SHADER_STAGE_COUNT];
+    std::vector<std::string> keywords;
+    std::vector<std::string> includeStack{path};
+    std::string line;
+    std::string_view rest;
+
+    int currentStage = -1;
+    int lineCount = 0;
+    while (std::getline(file, line)) {
+        lineCount++;
+        if (isDirective(line, "#shader", rest)) {
+            std::istringstream arguments{std::string(rest)};
+            std::string name;
+            arguments >> name;
+            const auto stage = std::ranges::find(SHADER_STAGE_NAMES, name);
+            if (stage == std::end(SHADER_STAGE_NAMES)) {
+                std::cerr << "Shader type could not be found on line " << lineCount << std::endl;
+                return -1;
+            }
+            currentStage = static_cast<int>(stage - std::begin(SHADER_STAGE_NAMES));
+        } else if (isDirective(line, "#keywords", rest)) {
+            std::istringstream names{std::string(rest)};
+            std::string name;
+            while (names >> name) {
+                if (std::ranges::find(keywords, name) == keywords.end()) {
+                    keywords.push_back(name);
+                }
+            }
+            if (keywords.size() > MAX_SHADER_KEYWORDS) {
+                std::cerr << "More than " << MAX_SHADER_KEYWORDS << " keywords on line " << lineCount << std::endl;
+                return -1;
+            }
+        } else {
+            if (currentStage < 0) {
+                std::cerr << "Your shader should have a descriptor on line 1 (ex: \"#shader vertex\")" << std::endl;
+                return -1;
+            }
+            std::string &stage = stages[currentStage];
+            if (isDirective(line, "#include", rest)) {
+                std::string included;
+                if (resolveInclude(path, rest, included) != 0 ||
+                    expandInclude(included, includes, includeStack, stage) != 0) {
+                    std::cerr << "Included from " << shaderPath << " line " << lineCount << std::endl;
+                    return -1;
+                }
+            } else {
+                stage += line;
+                stage += '\n';
+            }
+        }
+    }
+
+    for (int i = 0; i < SHADER_STAGE_COUNT; i++) {
+        sources.stages[i] = std::move(stages[i]);
+    }
+    sources.keywords = std::move(keywords);
+
+    return validateShaderStages(sources);
+}
+
+int parseShaders(const std::string_view shaderPath, ShaderSources &sources) {
+    ShaderIncludeCache includes;
+    return parseShaders(shaderPath, sources, includes);
+}
+
+std::string serializeShaders(const ShaderSources &sources) {
+    std::string text;
+    if (!sources.keywords.empty()) {
+        text += "#keywords";
+        for (const std::string &keyword : sources.keywords) {
+            text += ' ' + keyword;
+        }
+        text += '\n';
+    }
+    for (int i = 0; i < SHADER_STAGE_COUNT; i++) {
+        if (!sources.stages[i].empty()) {
+            text += "#shader " + std::string(SHADER_STAGE_NAMES[i]) + '\n' + sources.stages[i];
+        }
+    }
+    return text;
+}
+
+int validateShaderStages(const ShaderSources &sources) {
+    const bool compute = !sources.stages[static_cast<int>(ShaderStage::COMPUTE)].empty();
+    bool graphics = false;
+    for (int i = 0; i < SHADER_STAGE_COUNT; i++) {
+        graphics |= i != static_cast<int>(ShaderStage::COMPUTE) && !sources.stages[i].empty();
+    }
+    if (compute && graphics) {
+        std::cerr << "A compute shader cannot be linked with other stages" << std::endl;
+        return -1;
+    }
+    if (!compute && sources.stages[static_cast<int>(ShaderStage::VERTEX)].empty()) {
+        std::cerr << "The shader has no vertex stage" << std::endl;
+        return -1;
+    }
+    return 0;
+}
+
+std::uint64_t keywordMask(const ShaderSources &sources, std::initializer_list<std::string_view> keywords) {
+    std::uint64_t mask = 0;
+    for (std::string_view keyword : keywords) {
+        const auto found = std::ranges::find(sources.keywords, keyword);
+        if (found == sources.keywords.end()) {
+            std::cerr << "Unknown shader keyword " << keyword << std::endl;
+            continue;
+        }
+        mask |= std::uint64_t{1} << (found - sources.keywords.begin());
+    }
+    return mask;
+}
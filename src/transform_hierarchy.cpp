@@ -0,0 +1,158 @@
+#include <transform_hierarchy.h>
+
+#include <GLEW/glew.h>
+
+#include <algorithm>
+#include <cstring>
+
+namespace {
+
+// Counting sort of the nodes by depth, stable so each level stays in memory order
+void rebuildLevels(TransformHierarchy &hierarchy) {
+    const std::size_t count = hierarchy.parents.size();
+    const std::uint32_t levelCount = count ? *std::max_element(hierarchy.depths.begin(), hierarchy.depths.end()) + 1 : 0;
+
+    hierarchy.levelStarts.assign(levelCount + 1, 0);
+    for (std::uint32_t depth : hierarchy.depths) {
+        hierarchy.levelStarts[depth + 1]++;
+    }
+    for (std::uint32_t level = 0; level < levelCount; level++) {
+        hierarchy.levelStarts[level + 1] += hierarchy.levelStarts[level];
+    }
+
+    hierarchy.levelNodes.resize(count);
+    std::vector<std::uint32_t> cursor(hierarchy.levelStarts.begin(), hierarchy.levelStarts.end() - 1);
+    for (std::uint32_t node = 0; node < count; node++) {
+        hierarchy.levelNodes[cursor[hierarchy.depths[node]]++] = node;
+    }
+    hierarchy.levelsValid = true;
+}
+
+} // namespace
+
+std::uint32_t addTransform(TransformHierarchy &hierarchy, std::uint32_t parent, vec3 position, const quat &rotation,
+                           vec3 scale) {
+    const auto node = static_cast<std::uint32_t>(hierarchy.parents.size());
+    hierarchy.parents.push_back(parent);
+    hierarchy.depths.push_back(parent == NO_PARENT ? 0 : hierarchy.depths[parent] + 1);
+    hierarchy.positions.push_back(position);
+    hierarchy.rotations.push_back(rotation);
+    hierarchy.scales.push_back(scale);
+    hierarchy.worldMatrices.push_back(identity());
+    hierarchy.dirty.push_back(1);
+    hierarchy.levelsValid = false;
+    return node;
+}
+
+void setLocalTransform(TransformHierarchy &hierarchy, std::uint32_t node, vec3 position, const quat &rotation,
+                       vec3 scale) {
+    hierarchy.positions[node] = position;
+    hierarchy.rotations[node] = rotation;
+    hierarchy.scales[node] = scale;
+    hierarchy.dirty[node] = 1;
+}
+
+void setLocalPosition(TransformHierarchy &hierarchy, std::uint32_t node, vec3 position) {
+    hierarchy.positions[node] = position;
+    hierarchy.dirty[node] = 1;
+}
+
+std::size_t updateWorldMatrices(TransformHierarchy &hierarchy) {
+    const std::size_t count = hierarchy.parents.size();
+    hierarchy.changedBegin = 0;
+    hierarchy.changedEnd = 0;
+    if (!hierarchy.levelsValid) {
+        rebuildLevels(hierarchy);
+    }
+
+    // Parents come first, so a node's dirty state is final by the time its children look at it
+    hierarchy.worldDirty.resize(count);
+    bool anyDirty = false;
+    for (std::size_t node = 0; node < count; node++) {
+        const std::uint32_t parent = hierarchy.parents[node];
+        hierarchy.worldDirty[node] = hierarchy.dirty[node] | (parent != NO_PARENT ? hierarchy.worldDirty[parent] : 0);
+        anyDirty |= hierarchy.worldDirty[node] != 0;
+    }
+    if (!anyDirty) {
+        return 0;
+    }
+
+    std::size_t updated = 0;
+    std::uint32_t changedBegin = static_cast<std::uint32_t>(count), changedEnd = 0;
+    for (std::size_t level = 0; level + 1 < hierarchy.levelStarts.size(); level++) {
+        hierarchy.batchNodes.clear();
+        for (std::uint32_t i = hierarchy.levelStarts[level]; i < hierarchy.levelStarts[level + 1]; i++) {
+            const std::uint32_t node = hierarchy.levelNodes[i];
+            if (hierarchy.worldDirty[node]) {
+                hierarchy.batchNodes.push_back(node);
+            }
+        }
+        const std::size_t batchSize = hierarchy.batchNodes.size();
+        if (batchSize == 0) {
+            continue;
+        }
+
+        // Gather, one batched product for the whole level, scatter
+        hierarchy.localMatrices.resize(batchSize);
+        hierarchy.parentMatrices.resize(batchSize);
+        for (std::size_t b = 0; b < batchSize; b++) {
+            const std::uint32_t node = hierarchy.batchNodes[b];
+            const std::uint32_t parent = hierarchy.parents[node];
+            hierarchy.localMatrices[b] = composeTransform(hierarchy.positions[node], hierarchy.rotations[node],
+                                                          hierarchy.scales[node]);
+            hierarchy.parentMatrices[b] = parent != NO_PARENT ? hierarchy.worldMatrices[parent] : identity();
+        }
+        multiplyMatrices(hierarchy.parentMatrices.data(), hierarchy.localMatrices.data(),
+                         hierarchy.localMatrices.data(), batchSize);
+        for (std::size_t b = 0; b < batchSize; b++) {
+            const std::uint32_t node = hierarchy.batchNodes[b];
+            hierarchy.worldMatrices[node] = hierarchy.localMatrices[b];
+            hierarchy.dirty[node] = 0;
+            changedBegin = std::min(changedBegin, node);
+            changedEnd = std::max(changedEnd, node + 1);
+        }
+        updated += batchSize;
+    }
+
+    hierarchy.changedBegin = changedBegin;
+    hierarchy.changedEnd = changedEnd;
+    return updated;
+}
+
+void initTransformBuffer(TransformBuffer &transforms) {
+    GLint alignment = 256;
+    glGetIntegerv(GL_UNIFORM_BUFFER_OFFSET_ALIGNMENT, &alignment);
+    const auto slotAlignment = static_cast<std::size_t>(std::max(alignment, 1));
+    transforms.stride = (sizeof(mat4) + slotAlignment - 1) / slotAlignment * slotAlignment;
+    transforms.capacity = 0;
+    glGenBuffers(1, &transforms.buffer);
+}
+
+void uploadTransforms(TransformBuffer &transforms, const TransformHierarchy &hierarchy) {
+    const std::size_t count = hierarchy.worldMatrices.size();
+    std::size_t begin = hierarchy.changedBegin, end = hierarchy.changedEnd;
+
+    glBindBuffer(GL_UNIFORM_BUFFER, transforms.buffer);
+    if (count > transforms.capacity) {
+        transforms.capacity = std::max(count, transforms.capacity * 2);
+        glBufferData(GL_UNIFORM_BUFFER, static_cast<GLsizeiptr>(transforms.capacity * transforms.stride), nullptr,
+                     GL_DYNAMIC_DRAW);
+        begin = 0; // the old contents are gone
+        end = count;
+    }
+    if (begin < end) {
+        // Every node of the range is rewritten, clean ones included, since the whole range is invalidated; the
+        // padding between slots is never read
+        const std::size_t size = (end - begin - 1) * transforms.stride + sizeof(mat4);
+        auto *mapped = static_cast<std::byte *>(glMapBufferRange(
+                GL_UNIFORM_BUFFER, static_cast<GLintptr>(begin * transforms.stride), static_cast<GLsizeiptr>(size),
+                GL_MAP_WRITE_BIT | GL_MAP_INVALIDATE_RANGE_BIT));
+        if (mapped) {
+            for (std::size_t node = begin; node < end; node++) {
+                std::memcpy(mapped + (node - begin) * transforms.stride, &hierarchy.worldMatrices[node], sizeof(mat4));
+            }
+            glUnmapBuffer(GL_UNIFORM_BUFFER);
+        }
+    }
+    glBindBuffer(GL_UNIFORM_BUFFER, 0);
+}
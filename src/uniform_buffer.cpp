@@ -0,0 +1,120 @@
+#include <uniform_buffer.h>
+
+#include <GLEW/glew.h>
+
+#include <algorithm>
+#include <iostream>
+
+namespace {
+
+constexpr GLuint64 FENCE_TIMEOUT = 1'000'000'000; // 1 s, in nanoseconds
+
+void waitFence(void *&fence) {
+    if (!fence) {
+        return;
+    }
+    const auto sync = static_cast<GLsync>(fence);
+    GLbitfield flags = 0;
+    while (true) {
+        const GLenum result = glClientWaitSync(sync, flags, FENCE_TIMEOUT);
+        if (result == GL_ALREADY_SIGNALED || result == GL_CONDITION_SATISFIED || result == GL_WAIT_FAILED) {
+            break;
+        }
+        flags = GL_SYNC_FLUSH_COMMANDS_BIT; // make sure the fence actually reaches the GPU
+    }
+    glDeleteSync(sync);
+    fence = nullptr;
+}
+
+} // namespace
+
+void initUniformRing(UniformRing &ring, std::size_t frameSize) {
+    GLint alignment = 256;
+    glGetIntegerv(GL_UNIFORM_BUFFER_OFFSET_ALIGNMENT, &alignment);
+    ring.alignment = static_cast<std::size_t>(std::max(alignment, 16));
+    ring.frameSize = (frameSize + ring.alignment - 1) / ring.alignment * ring.alignment;
+    ring.persistent = GLEW_VERSION_4_4 || GLEW_ARB_buffer_storage;
+
+    const auto totalSize = static_cast<GLsizeiptr>(ring.frameSize * UniformRing::FRAMES);
+    glGenBuffers(1, &ring.buffer);
+    glBindBuffer(GL_UNIFORM_BUFFER, ring.buffer);
+    if (ring.persistent) {
+        const GLbitfield flags = GL_MAP_WRITE_BIT | GL_MAP_PERSISTENT_BIT | GL_MAP_COHERENT_BIT;
+        glBufferStorage(GL_UNIFORM_BUFFER, totalSize, nullptr, flags);
+        ring.persistentData = static_cast<std::byte *>(glMapBufferRange(GL_UNIFORM_BUFFER, 0, totalSize, flags));
+        if (!ring.persistentData) {
+            std::cerr << "Could not map the uniform ring persistently" << std::endl;
+        }
+    } else {
+        glBufferData(GL_UNIFORM_BUFFER, totalSize, nullptr, GL_STREAM_DRAW);
+    }
+    glBindBuffer(GL_UNIFORM_BUFFER, 0);
+}
+
+void destroyUniformRing(UniformRing &ring) {
+    for (void *&fence : ring.fences) {
+        waitFence(fence);
+    }
+    if (ring.persistentData) {
+        glBindBuffer(GL_UNIFORM_BUFFER, ring.buffer);
+        glUnmapBuffer(GL_UNIFORM_BUFFER);
+        glBindBuffer(GL_UNIFORM_BUFFER, 0);
+    }
+    glDeleteBuffers(1, &ring.buffer);
+    ring.buffer = 0;
+    ring.persistentData = nullptr;
+    ring.frameData = nullptr;
+    ring.started = false;
+}
+
+void beginUniformFrame(UniformRing &ring) {
+    if (ring.started) {
+        // Everything that reads the previous region has been issued by now
+        ring.fences[ring.frame] = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+        ring.frame = (ring.frame + 1) % UniformRing::FRAMES;
+    }
+    const std::size_t lastUsed = ring.used.load(std::memory_order_relaxed);
+    if (ring.started && lastUsed > ring.frameSize) {
+        const std::size_t overflows = ring.overflows.load(std::memory_order_relaxed);
+        const std::size_t grows = ring.grows + 1;
+        const std::size_t frameSize = std::max(lastUsed, ring.frameSize * 2);
+        destroyUniformRing(ring);
+        initUniformRing(ring, frameSize);
+        ring.overflows.store(overflows, std::memory_order_relaxed);
+        ring.grows = grows;
+    }
+    ring.started = true;
+    waitFence(ring.fences[ring.frame]);
+    ring.used.store(0, std::memory_order_relaxed);
+
+    const std::size_t regionOffset = ring.frame * ring.frameSize;
+    if (ring.persistent) {
+        ring.frameData = ring.persistentData ? ring.persistentData + regionOffset : nullptr;
+    } else {
+        // The fence already guarantees the GPU is done with the region, no need for the driver to synchronize
+        glBindBuffer(GL_UNIFORM_BUFFER, ring.buffer);
+        ring.frameData = static_cast<std::byte *>(glMapBufferRange(
+                GL_UNIFORM_BUFFER, static_cast<GLintptr>(regionOffset), static_cast<GLsizeiptr>(ring.frameSize),
+                GL_MAP_WRITE_BIT | GL_MAP_INVALIDATE_RANGE_BIT | GL_MAP_UNSYNCHRONIZED_BIT));
+        glBindBuffer(GL_UNIFORM_BUFFER, 0);
+    }
+}
+
+UniformAllocation allocateUniforms(UniformRing &ring, std::size_t size) {
+    const std::size_t aligned = (size + ring.alignment - 1) / ring.alignment * ring.alignment;
+    const std::size_t offset = ring.used.fetch_add(aligned, std::memory_order_relaxed);
+    if (!ring.frameData || offset + aligned > ring.frameSize) {
+        ring.overflows.fetch_add(1, std::memory_order_relaxed);
+        return {nullptr, 0};
+    }
+    return {ring.frameData + offset, static_cast<std::uint32_t>(ring.frame * ring.frameSize + offset)};
+}
+
+void endUniformFrame(UniformRing &ring) {
+    if (!ring.persistent && ring.frameData) {
+        glBindBuffer(GL_UNIFORM_BUFFER, ring.buffer);
+        glUnmapBuffer(GL_UNIFORM_BUFFER);
+        glBindBuffer(GL_UNIFORM_BUFFER, 0);
+    }
+    ring.frameData = nullptr;
+}
@@ -0,0 +1,301 @@
+#include <vector_math.h>
+
+namespace {
+
+// Column c of a * b is a * b.columns[c]: the columns of a weighted by the components of b's column
+float4 multiplyColumn(const float4 a[4], float4 column) {
+    float4 result = a[0] * broadcast<0>(column);
+    result = madd(a[1], broadcast<1>(column), result);
+    result = madd(a[2], broadcast<2>(column), result);
+    return madd(a[3], broadcast<3>(column), result);
+}
+
+void loadColumns(const mat4 &m, float4 columns[4]) {
+    for (int c = 0; c < 4; c++) {
+        columns[c] = toFloat4(m.columns[c]);
+    }
+}
+
+template<typename T>
+void transformPointsKernel(const mat4 &m, const float *x, const float *y, const float *z, float *outX, float *outY,
+                           float *outZ, std::size_t begin, std::size_t end) {
+    const vec4 *c = m.columns;
+    const T m00 = T::splat(c[0].x), m01 = T::splat(c[1].x), m02 = T::splat(c[2].x), m03 = T::splat(c[3].x);
+    const T m10 = T::splat(c[0].y), m11 = T::splat(c[1].y), m12 = T::splat(c[2].y), m13 = T::splat(c[3].y);
+    const T m20 = T::splat(c[0].z), m21 = T::splat(c[1].z), m22 = T::splat(c[2].z), m23 = T::splat(c[3].z);
+    for (std::size_t i = begin; i < end; i += T::WIDTH) {
+        const T px = T::load(x + i), py = T::load(y + i), pz = T::load(z + i);
+        madd(m02, pz, madd(m01, py, madd(m00, px, m03))).store(outX + i);
+        madd(m12, pz, madd(m11, py, madd(m10, px, m13))).store(outY + i);
+        madd(m22, pz, madd(m21, py, madd(m20, px, m23))).store(outZ + i);
+    }
+}
+
+template<typename T>
+void sinCosKernel(const float *angles, float *sines, float *cosines, std::size_t begin, std::size_t end) {
+    for (std::size_t i = begin; i < end; i += T::WIDTH) {
+        const T angle = T::load(angles + i);
+        if (sines) {
+            fastSin(angle).store(sines + i);
+        }
+        if (cosines) {
+            fastCos(angle).store(cosines + i);
+        }
+    }
+}
+
+} // namespace
+
+mat4 identity() {
+    return {{{1, 0, 0, 0}, {0, 1, 0, 0}, {0, 0, 1, 0}, {0, 0, 0, 1}}};
+}
+
+mat4 translation(vec3 t) {
+    mat4 m = identity();
+    m.columns[3] = {t.x, t.y, t.z, 1.0f};
+    return m;
+}
+
+mat4 scaling(vec3 s) {
+    return {{{s.x, 0, 0, 0}, {0, s.y, 0, 0}, {0, 0, s.z, 0}, {0, 0, 0, 1}}};
+}
+
+mat4 rotation(const quat &q) {
+    const float xx = q.x * q.x, yy = q.y * q.y, zz = q.z * q.z;
+    const float xy = q.x * q.y, xz = q.x * q.z, yz = q.y * q.z;
+    const float wx = q.w * q.x, wy = q.w * q.y, wz = q.w * q.z;
+    return {{
+            {1 - 2 * (yy + zz), 2 * (xy + wz), 2 * (xz - wy), 0},
+            {2 * (xy - wz), 1 - 2 * (xx + zz), 2 * (yz + wx), 0},
+            {2 * (xz + wy), 2 * (yz - wx), 1 - 2 * (xx + yy), 0},
+            {0, 0, 0, 1}
+    }};
+}
+
+mat4 composeTransform(vec3 t, const quat &r, vec3 s) {
+    mat4 m = rotation(r);
+    m.columns[0] = m.columns[0] * s.x;
+    m.columns[1] = m.columns[1] * s.y;
+    m.columns[2] = m.columns[2] * s.z;
+    m.columns[3] = {t.x, t.y, t.z, 1.0f};
+    return m;
+}
+
+mat4 perspective(float fovY, float aspect, float near, float far) {
+    const float f = 1.0f / std::tan(fovY * 0.5f);
+    mat4 m{};
+    m.columns[0].x = f / aspect;
+    m.columns[1].y = f;
+    m.columns[2].z = (far + near) / (near - far);
+    m.columns[2].w = -1.0f;
+    m.columns[3].z = 2.0f * far * near / (near - far);
+    return m;
+}
+
+mat4 orthographic(float left, float right, float bottom, float top, float near, float far) {
+    mat4 m = identity();
+    m.columns[0].x = 2.0f / (right - left);
+    m.columns[1].y = 2.0f / (top - bottom);
+    m.columns[2].z = -2.0f / (far - near);
+    m.columns[3] = {-(right + left) / (right - left), -(top + bottom) / (top - bottom), -(far + near) / (far - near), 1};
+    return m;
+}
+
+mat4 lookAt(vec3 eye, vec3 target, vec3 up) {
+    const vec3 f = normalize(target - eye);
+    const vec3 s = normalize(cross(f, up));
+    const vec3 u = cross(s, f);
+    return {{
+            {s.x, u.x, -f.x, 0},
+            {s.y, u.y, -f.y, 0},
+            {s.z, u.z, -f.z, 0},
+            {-dot(s, eye), -dot(u, eye), dot(f, eye), 1}
+    }};
+}
+
+mat4 operator*(const mat4 &a, const mat4 &b) {
+    float4 columns[4];
+    loadColumns(a, columns);
+    mat4 result;
+    for (int c = 0; c < 4; c++) {
+        result.columns[c] = toVec4(multiplyColumn(columns, toFloat4(b.columns[c])));
+    }
+    return result;
+}
+
+vec4 operator*(const mat4 &m, const vec4 &v) {
+    float4 columns[4];
+    loadColumns(m, columns);
+    return toVec4(multiplyColumn(columns, toFloat4(v)));
+}
+
+vec3 transformPoint(const mat4 &m, vec3 p) {
+    const vec4 r = m * vec4{p.x, p.y, p.z, 1.0f};
+    return {r.x, r.y, r.z};
+}
+
+vec3 transformDirection(const mat4 &m, vec3 d) {
+    const vec4 r = m * vec4{d.x, d.y, d.z, 0.0f};
+    return {r.x, r.y, r.z};
+}
+
+mat4 transpose(const mat4 &m) {
+    const vec4 *c = m.columns;
+    return {{
+            {c[0].x, c[1].x, c[2].x, c[3].x},
+            {c[0].y, c[1].y, c[2].y, c[3].y},
+            {c[0].z, c[1].z, c[2].z, c[3].z},
+            {c[0].w, c[1].w, c[2].w, c[3].w}
+    }};
+}
+
+mat4 inverse(const mat4 &m) {
+    // 2x2 sub-determinants of the bottom and top halves, then the adjugate
+    const float *a = &m.columns[0].x;
+    const float s0 = a[0] * a[5] - a[4] * a[1];
+    const float s1 = a[0] * a[6] - a[4] * a[2];
+    const float s2 = a[0] * a[7] - a[4] * a[3];
+    const float s3 = a[1] * a[6] - a[5] * a[2];
+    const float s4 = a[1] * a[7] - a[5] * a[3];
+    const float s5 = a[2] * a[7] - a[6] * a[3];
+    const float c5 = a[10] * a[15] - a[14] * a[11];
+    const float c4 = a[9] * a[15] - a[13] * a[11];
+    const float c3 = a[9] * a[14] - a[13] * a[10];
+    const float c2 = a[8] * a[15] - a[12] * a[11];
+    const float c1 = a[8] * a[14] - a[12] * a[10];
+    const float c0 = a[8] * a[13] - a[12] * a[9];
+
+    const float determinant = s0 * c5 - s1 * c4 + s2 * c3 + s3 * c2 - s4 * c1 + s5 * c0;
+    if (std::fabs(determinant) < 1e-20f) {
+        return identity();
+    }
+    const float d = 1.0f / determinant;
+    mat4 r;
+    float *o = &r.columns[0].x;
+    o[0] = (a[5] * c5 - a[6] * c4 + a[7] * c3) * d;
+    o[1] = (-a[1] * c5 + a[2] * c4 - a[3] * c3) * d;
+    o[2] = (a[13] * s5 - a[14] * s4 + a[15] * s3) * d;
+    o[3] = (-a[9] * s5 + a[10] * s4 - a[11] * s3) * d;
+    o[4] = (-a[4] * c5 + a[6] * c2 - a[7] * c1) * d;
+    o[5] = (a[0] * c5 - a[2] * c2 + a[3] * c1) * d;
+    o[6] = (-a[12] * s5 + a[14] * s2 - a[15] * s1) * d;
+    o[7] = (a[8] * s5 - a[10] * s2 + a[11] * s1) * d;
+    o[8] = (a[4] * c4 - a[5] * c2 + a[7] * c0) * d;
+    o[9] = (-a[0] * c4 + a[1] * c2 - a[3] * c0) * d;
+    o[10] = (a[12] * s4 - a[13] * s2 + a[15] * s0) * d;
+    o[11] = (-a[8] * s4 + a[9] * s2 - a[11] * s0) * d;
+    o[12] = (-a[4] * c3 + a[5] * c1 - a[6] * c0) * d;
+    o[13] = (a[0] * c3 - a[1] * c1 + a[2] * c0) * d;
+    o[14] = (-a[12] * s3 + a[13] * s1 - a[14] * s0) * d;
+    o[15] = (a[8] * s3 - a[9] * s1 + a[10] * s0) * d;
+    return r;
+}
+
+mat3 normalMatrix(const mat4 &m) {
+    const vec4 *c = m.columns;
+    const vec3 a{c[0].x, c[0].y, c[0].z}, b{c[1].x, c[1].y, c[1].z}, e{c[2].x, c[2].y, c[2].z};
+    // The inverse transpose of [a b e] has the cross products of its columns as columns, over the determinant
+    const vec3 bc = cross(b, e), ca = cross(e, a), ab = cross(a, b);
+    const float determinant = dot(a, bc);
+    const float d = std::fabs(determinant) > 1e-20f ? 1.0f / determinant : 0.0f;
+    return {{bc * d, ca * d, ab * d}};
+}
+
+quat quatIdentity() {
+    return {0, 0, 0, 1};
+}
+
+quat axisAngle(vec3 axis, float angle) {
+    const vec3 n = normalize(axis);
+    const float s = std::sin(angle * 0.5f);
+    return {n.x * s, n.y * s, n.z * s, std::cos(angle * 0.5f)};
+}
+
+quat operator*(const quat &a, const quat &b) {
+    return {
+            a.w * b.x + a.x * b.w + a.y * b.z - a.z * b.y,
+            a.w * b.y - a.x * b.z + a.y * b.w + a.z * b.x,
+            a.w * b.z + a.x * b.y - a.y * b.x + a.z * b.w,
+            a.w * b.w - a.x * b.x - a.y * b.y - a.z * b.z
+    };
+}
+
+quat normalize(const quat &q) {
+    const float len = std::sqrt(q.x * q.x + q.y * q.y + q.z * q.z + q.w * q.w);
+    if (len <= 0.0f) {
+        return quatIdentity();
+    }
+    const float s = 1.0f / len;
+    return {q.x * s, q.y * s, q.z * s, q.w * s};
+}
+
+quat conjugate(const quat &q) {
+    return {-q.x, -q.y, -q.z, q.w};
+}
+
+vec3 rotate(const quat &q, vec3 v) {
+    // v + 2w(u x v) + 2u x (u x v), u the vector part
+    const vec3 u{q.x, q.y, q.z};
+    const vec3 t = cross(u, v) * 2.0f;
+    return v + t * q.w + cross(u, t);
+}
+
+quat slerp(const quat &a, const quat &b, float t) {
+    float cosine = a.x * b.x + a.y * b.y + a.z * b.z + a.w * b.w;
+    quat end = b;
+    if (cosine < 0.0f) {
+        cosine = -cosine;
+        end = {-b.x, -b.y, -b.z, -b.w};
+    }
+    float wa = 1.0f - t, wb = t;
+    if (cosine < 0.9995f) {
+        const float angle = std::acos(cosine);
+        const float s = 1.0f / std::sin(angle);
+        wa = std::sin(wa * angle) * s;
+        wb = std::sin(wb * angle) * s;
+    }
+    return normalize({a.x * wa + end.x * wb, a.y * wa + end.y * wb, a.z * wa + end.z * wb, a.w * wa + end.w * wb});
+}
+
+void transformPointsSoA(const mat4 &m, const float *x, const float *y, const float *z, float *outX, float *outY,
+                        float *outZ, std::size_t count) {
+    const std::size_t wide = count - count % floatN::WIDTH;
+    transformPointsKernel<floatN>(m, x, y, z, outX, outY, outZ, 0, wide);
+    for (std::size_t i = wide; i < count; i++) {
+        const vec3 p = transformPoint(m, {x[i], y[i], z[i]});
+        outX[i] = p.x;
+        outY[i] = p.y;
+        outZ[i] = p.z;
+    }
+}
+
+void multiplyMatrices(const mat4 *a, const mat4 *b, mat4 *out, std::size_t count) {
+    for (std::size_t i = 0; i < count; i++) {
+        float4 columns[4];
+        loadColumns(a[i], columns);
+        float4 result[4];
+        for (int c = 0; c < 4; c++) {
+            result[c] = multiplyColumn(columns, toFloat4(b[i].columns[c]));
+        }
+        for (int c = 0; c < 4; c++) {
+            result[c].store(&out[i].columns[c].x);
+        }
+    }
+}
+
+void sinCos(const float *angles, float *sines, float *cosines, std::size_t count) {
+    const std::size_t wide = count - count % floatN::WIDTH;
+    sinCosKernel<floatN>(angles, sines, cosines, 0, wide);
+    for (std::size_t i = wide; i < count; i++) {
+        float lane[4] = {angles[i]};
+        const float4 angle = float4::load(lane);
+        if (sines) {
+            fastSin(angle).store(lane);
+            sines[i] = lane[0];
+        }
+        if (cosines) {
+            fastCos(angle).store(lane);
+            cosines[i] = lane[0];
+        }
+    }
+}
@@ -0,0 +1,240 @@
+#include <vertex_layout.h>
+#include <mesh.h>
+
+#include <GLEW/glew.h>
+
+#include <algorithm>
+#include <bit>
+#include <cmath>
+#include <cstring>
+#include <limits>
+
+namespace {
+
+void addAttribute(VertexLayout &layout, unsigned int location, int components, unsigned int type, bool normalized,
+                  unsigned int size) {
+    layout.attributes.push_back({location, components, type, normalized, layout.stride});
+    layout.stride += (size + 3) & ~3u; // keep every attribute 4 byte aligned
+}
+
+std::uint16_t quantizeUnorm16(float value) {
+    return static_cast<std::uint16_t>(std::lround(std::clamp(value, 0.0f, 1.0f) * 65535.0f));
+}
+
+std::uint8_t quantizeUnorm8(float value) {
+    return static_cast<std::uint8_t>(std::lround(std::clamp(value, 0.0f, 1.0f) * 255.0f));
+}
+
+} // namespace
+
+VertexLayout makeVertexLayout(const VertexFormat &format) {
+    VertexLayout layout;
+    layout.format = format;
+
+    switch (format.position) {
+        case PositionFormat::FLOAT32: addAttribute(layout, LOCATION_POSITION, 3, GL_FLOAT, false, 12); break;
+        case PositionFormat::HALF: addAttribute(layout, LOCATION_POSITION, 3, GL_HALF_FLOAT, false, 8); break;
+        case PositionFormat::UNORM16: addAttribute(layout, LOCATION_POSITION, 3, GL_UNSIGNED_SHORT, true, 8); break;
+    }
+    switch (format.normal) {
+        case NormalFormat::NONE: break;
+        case NormalFormat::FLOAT32: addAttribute(layout, LOCATION_NORMAL, 3, GL_FLOAT, false, 12); break;
+        case NormalFormat::OCTAHEDRAL16: addAttribute(layout, LOCATION_NORMAL, 2, GL_SHORT, true, 4); break;
+    }
+    switch (format.uv) {
+        case UvFormat::NONE: break;
+        case UvFormat::FLOAT32: addAttribute(layout, LOCATION_UV, 2, GL_FLOAT, false, 8); break;
+        case UvFormat::HALF: addAttribute(layout, LOCATION_UV, 2, GL_HALF_FLOAT, false, 4); break;
+    }
+    switch (format.color) {
+        case ColorFormat::NONE: break;
+        case ColorFormat::FLOAT32: addAttribute(layout, LOCATION_COLOR, 3, GL_FLOAT, false, 12); break;
+        case ColorFormat::UNORM8: addAttribute(layout, LOCATION_COLOR, 4, GL_UNSIGNED_BYTE, true, 4); break;
+    }
+    return layout;
+}
+
+MeshBounds computeBounds(const Vertex *vertices, std::size_t count) {
+    MeshBounds bounds{};
+    if (count == 0) {
+        return bounds;
+    }
+    for (int axis = 0; axis < 3; axis++) {
+        bounds.min[axis] = std::numeric_limits<float>::max();
+        bounds.max[axis] = std::numeric_limits<float>::lowest();
+    }
+    for (std::size_t i = 0; i < count; i++) {
+        for (int axis = 0; axis < 3; axis++) {
+            bounds.min[axis] = std::min(bounds.min[axis], vertices[i].position[axis]);
+            bounds.max[axis] = std::max(bounds.max[axis], vertices[i].position[axis]);
+        }
+    }
+    return bounds;
+}
+
+PositionDecode positionDecode(PositionFormat format, const MeshBounds &bounds) {
+    PositionDecode decode{{1.0f, 1.0f, 1.0f}, {0.0f, 0.0f, 0.0f}};
+    if (format == PositionFormat::UNORM16) {
+        for (int axis = 0; axis < 3; axis++) {
+            decode.scale[axis] = bounds.max[axis] - bounds.min[axis];
+            decode.bias[axis] = bounds.min[axis];
+        }
+    }
+    return decode;
+}
+
+void packVertices(const Vertex *vertices, std::size_t count, const VertexLayout &layout, const MeshBounds &bounds,
+                  std::vector<unsigned char> &out) {
+    out.assign(count * layout.stride, 0);
+
+    float inverseExtent[3];
+    for (int axis = 0; axis < 3; axis++) {
+        const float extent = bounds.max[axis] - bounds.min[axis];
+        inverseExtent[axis] = extent > 0.0f ? 1.0f / extent : 0.0f;
+    }
+
+    for (std::size_t i = 0; i < count; i++) {
+        const Vertex &vertex = vertices[i];
+        unsigned char *base = out.data() + i * layout.stride;
+
+        for (const VertexAttribute &attribute : layout.attributes) {
+            unsigned char *dst = base + attribute.offset;
+            switch (attribute.location) {
+                case LOCATION_POSITION:
+                    if (layout.format.position == PositionFormat::FLOAT32) {
+                        std::memcpy(dst, vertex.position, 12);
+                    } else if (layout.format.position == PositionFormat::HALF) {
+                        std::uint16_t packed[3];
+                        for (int axis = 0; axis < 3; axis++) {
+                            packed[axis] = floatToHalf(vertex.position[axis]);
+                        }
+                        std::memcpy(dst, packed, sizeof(packed));
+                    } else {
+                        std::uint16_t packed[3];
+                        for (int axis = 0; axis < 3; axis++) {
+                            packed[axis] = quantizeUnorm16((vertex.position[axis] - bounds.min[axis]) * inverseExtent[axis]);
+                        }
+                        std::memcpy(dst, packed, sizeof(packed));
+                    }
+                    break;
+                case LOCATION_NORMAL:
+                    if (layout.format.normal == NormalFormat::FLOAT32) {
+                        std::memcpy(dst, vertex.normal, 12);
+                    } else {
+                        std::int16_t packed[2];
+                        encodeOctahedral(vertex.normal, packed);
+                        std::memcpy(dst, packed, sizeof(packed));
+                    }
+                    break;
+                case LOCATION_UV:
+                    if (layout.format.uv == UvFormat::FLOAT32) {
+                        std::memcpy(dst, vertex.uv, 8);
+                    } else {
+                        std::uint16_t packed[2] = {floatToHalf(vertex.uv[0]), floatToHalf(vertex.uv[1])};
+                        std::memcpy(dst, packed, sizeof(packed));
+                    }
+                    break;
+                case LOCATION_COLOR:
+                    if (layout.format.color == ColorFormat::FLOAT32) {
+                        std::memcpy(dst, vertex.color, 12);
+                    } else {
+                        dst[0] = quantizeUnorm8(vertex.color[0]);
+                        dst[1] = quantizeUnorm8(vertex.color[1]);
+                        dst[2] = quantizeUnorm8(vertex.color[2]);
+                        dst[3] = 255;
+                    }
+                    break;
+                default:
+                    break;
+            }
+        }
+    }
+}
+
+void unpackPositions(const unsigned char *vertexData, std::size_t count, const VertexLayout &layout,
+                     const MeshBounds &bounds, std::vector<float> &out) {
+    out.assign(count * 3, 0.0f);
+    const auto position = std::find_if(layout.attributes.begin(), layout.attributes.end(),
+                                       [](const VertexAttribute &a) { return a.location == LOCATION_POSITION; });
+    if (position == layout.attributes.end()) {
+        return;
+    }
+    const PositionDecode decode = positionDecode(layout.format.position, bounds);
+
+    for (std::size_t i = 0; i < count; i++) {
+        const unsigned char *src = vertexData + i * layout.stride + position->offset;
+        float *dst = &out[i * 3];
+        if (layout.format.position == PositionFormat::FLOAT32) {
+            std::memcpy(dst, src, 12);
+            continue;
+        }
+        std::uint16_t packed[3];
+        std::memcpy(packed, src, sizeof(packed));
+        for (int axis = 0; axis < 3; axis++) {
+            dst[axis] = layout.format.position == PositionFormat::HALF
+                        ? halfToFloat(packed[axis])
+                        : static_cast<float>(packed[axis]) / 65535.0f * decode.scale[axis] + decode.bias[axis];
+        }
+    }
+}
+
+void applyVertexLayout(const VertexLayout &layout) {
+    for (const VertexAttribute &attribute : layout.attributes) {
+        glVertexAttribPointer(attribute.location, attribute.components, attribute.type,
+                              attribute.normalized ? GL_TRUE : GL_FALSE, static_cast<GLsizei>(layout.stride),
+                              reinterpret_cast<const void *>(static_cast<std::uintptr_t>(attribute.offset)));
+        glEnableVertexAttribArray(attribute.location);
+    }
+}
+
+std::uint16_t floatToHalf(float value) {
+    const auto bits = std::bit_cast<std::uint32_t>(value);
+    const std::uint32_t sign = (bits >> 16) & 0x8000;
+    const std::uint32_t magnitude = bits & 0x7FFFFFFF;
+
+    // Rebias the exponent (127 -> 15) and round the dropped mantissa bits to nearest
+    std::uint32_t half = (magnitude - (112u << 23) + (1u << 12)) >> 13;
+    if (magnitude < (113u << 23)) {
+        half = 0; // too small for a normal half, flush to zero
+    }
+    if (magnitude >= (143u << 23)) {
+        half = 0x7C00; // overflow to infinity
+    }
+    if (magnitude > (255u << 23)) {
+        half = 0x7E00; // NaN
+    }
+    return static_cast<std::uint16_t>(sign | half);
+}
+
+float halfToFloat(std::uint16_t value) {
+    const std::uint32_t sign = static_cast<std::uint32_t>(value & 0x8000) << 16;
+    const std::uint32_t exponent = (value >> 10) & 0x1F;
+    const std::uint32_t mantissa = value & 0x3FF;
+
+    if (exponent == 0) {
+        // Zero or subnormal: mantissa * 2^-24
+        const float magnitude = static_cast<float>(mantissa) * (1.0f / 16777216.0f);
+        return sign ? -magnitude : magnitude;
+    }
+    if (exponent == 31) {
+        return std::bit_cast<float>(sign | 0x7F800000 | (mantissa << 13));
+    }
+    return std::bit_cast<float>(sign | ((exponent + 112) << 23) | (mantissa << 13));
+}
+
+void encodeOctahedral(const float normal[3], std::int16_t out[2]) {
+    const float sum = std::abs(normal[0]) + std::abs(normal[1]) + std::abs(normal[2]);
+    float x = sum > 0.0f ? normal[0] / sum : 0.0f;
+    float y = sum > 0.0f ? normal[1] / sum : 0.0f;
+    const float z = sum > 0.0f ? normal[2] / sum : 1.0f;
+
+    // Fold the lower hemisphere over the diagonals
+    if (z < 0.0f) {
+        const float foldedX = (1.0f - std::abs(y)) * (x >= 0.0f ? 1.0f : -1.0f);
+        const float foldedY = (1.0f - std::abs(x)) * (y >= 0.0f ? 1.0f : -1.0f);
+        x = foldedX;
+        y = foldedY;
+    }
+    out[0] = static_cast<std::int16_t>(std::lround(std::clamp(x, -1.0f, 1.0f) * 32767.0f));
+    out[1] = static_cast<std::int16_t>(std::lround(std::clamp(y, -1.0f, 1.0f) * 32767.0f));
+}
@@ -0,0 +1,74 @@
+// Build step packing loose resources into one archive (see asset_pack.h), read at run time through the resource
+// lookup once mounted with mountResourcePack.
+//
+// usage: asset_packer [--store] <output.pack> <resource>...   (resource paths relative to the working directory;
+//                                                              --store disables compression)
+
+#include <asset_pack.h>
+#include <resources.h>
+
+#include <cstring>
+#include <iostream>
+#include <string>
+#include <string_view>
+#include <vector>
+
+int main(int argc, char **argv) {
+    int argument = 1;
+    bool compress = true;
+    if (argument < argc && std::string_view(argv[argument]) == "--store") {
+        compress = false;
+        argument++;
+    }
+    if (argument >= argc) {
+        std::cerr << "usage: asset_packer [--store] <output.pack> <resource>..." << std::endl;
+        return 1;
+    }
+    const std::string_view packPath = argv[argument++];
+
+    std::vector<AssetSource> assets;
+    std::size_t totalSize = 0;
+    for (; argument < argc; argument++) {
+        AssetSource asset{normalizeResourcePath(argv[argument]), {}};
+        std::string contents;
+        if (readResource(asset.path, contents) != 0) {
+            return 1;
+        }
+        asset.data.assign(contents.begin(), contents.end());
+        totalSize += asset.data.size();
+        assets.push_back(std::move(asset));
+    }
+    if (writeAssetPack(packPath, assets, compress) != 0) {
+        return 1;
+    }
+
+    AssetPack pack;
+    if (openAssetPack(packPath, pack) != 0) {
+        return 1;
+    }
+    // Every compressed entry must decompress back to its source, a broken pack fails the build here instead of at
+    // run time
+    std::size_t storedSize = 0, compressed = 0;
+    std::vector<unsigned char> decompressed;
+    for (const AssetSource &asset : assets) {
+        const AssetPackEntry *entry = findAsset(pack, asset.path);
+        if (!entry) {
+            std::cerr << "Asset " << asset.path << " is missing from " << packPath << std::endl;
+            return 1;
+        }
+        storedSize += entry->storedSize;
+        if (entry->compression == AssetCompression::NONE) {
+            continue;
+        }
+        compressed++;
+        decompressed.resize(entry->size);
+        if (entry->size != asset.data.size() || readAsset(pack, *entry, decompressed.data()) != 0 ||
+            std::memcmp(decompressed.data(), asset.data.data(), asset.data.size()) != 0) {
+            std::cerr << "Asset " << asset.path << " does not round trip through " << packPath << std::endl;
+            return 1;
+        }
+    }
+    std::cout << "Packed " << pack.entryCount << " assets (" << compressed << " compressed), " << totalSize
+              << " bytes stored in " << storedSize << ", archive " << pack.file.size() << " bytes" << std::endl;
+    return 0;
+}
@@ -0,0 +1,106 @@
+// Build step turning files under res/ into a C++ source of constexpr byte arrays, served at run time by
+// embeddedResources(). .shader files are stored preprocessed, includes expanded, so loading one reads nothing else.
+//
+// usage: embed_resources <output.cpp> <resource>...   (resource paths relative to the working directory)
+
+#include <resources.h>
+#include <shader.h>
+
+#include <algorithm>
+#include <fstream>
+#include <iostream>
+#include <iterator>
+#include <sstream>
+#include <string>
+#include <vector>
+
+namespace {
+
+// Anything bigger stays on disk, the executable is not meant to carry whole asset packs
+constexpr std::size_t MAX_EMBEDDED_SIZE = 1 << 20;
+
+struct Resource {
+    std::string path;
+    std::string contents;
+};
+
+void writeBytes(std::ostream &out, const std::string &bytes) {
+    constexpr std::size_t BYTES_PER_LINE = 24;
+    for (std::size_t i = 0; i < bytes.size(); i++) {
+        out << (i % BYTES_PER_LINE == 0 ? "\n        " : " ") << static_cast<unsigned int>(
+                static_cast<unsigned char>(bytes[i])) << ',';
+    }
+}
+
+} // namespace
+
+int main(int argc, char **argv) {
+    if (argc < 2) {
+        std::cerr << "usage: embed_resources <output.cpp> <resource>..." << std::endl;
+        return 1;
+    }
+
+    std::vector<Resource> resources;
+    ShaderIncludeCache includes;
+    for (int i = 2; i < argc; i++) {
+        Resource resource{normalizeResourcePath(argv[i]), {}};
+        if (resource.path.ends_with(".shader")) {
+            ShaderSources sources;
+            if (parseShaders(resource.path, sources, includes) != 0) {
+                std::cerr << "Could not preprocess " << resource.path << std::endl;
+                return 1;
+            }
+            resource.contents = serializeShaders(sources);
+        } else if (readResource(resource.path, resource.contents) != 0) {
+            return 1;
+        }
+        if (resource.contents.size() > MAX_EMBEDDED_SIZE) {
+            std::cout << "Not embedding " << resource.path << ", " << resource.contents.size() << " bytes" << std::endl;
+            continue;
+        }
+        resources.push_back(std::move(resource));
+    }
+    // findEmbeddedResource binary searches the table
+    std::ranges::sort(resources, {}, &Resource::path);
+    const auto duplicate = std::ranges::adjacent_find(resources, {}, &Resource::path);
+    if (duplicate != resources.end()) {
+        std::cerr << duplicate->path << " is listed twice" << std::endl;
+        return 1;
+    }
+
+    std::ostringstream out;
+    out << "// Generated by tools/embed_resources.cpp, do not edit\n\n#include <resources.h>\n\nnamespace {\n";
+    for (std::size_t i = 0; i < resources.size(); i++) {
+        // Zero sized arrays are not allowed, empty files get a padding byte that their size leaves out. Aligned
+        // like pack entries so binary resources such as mesh caches can be read in place.
+        out << "\nalignas(16) constexpr unsigned char RESOURCE_" << i << "[] = {";
+        writeBytes(out, resources[i].contents.empty() ? std::string(1, '\0') : resources[i].contents);
+        out << "\n};\n";
+    }
+    out << "\nconstexpr EmbeddedResource RESOURCES[] = {\n";
+    for (std::size_t i = 0; i < resources.size(); i++) {
+        out << "        {\"" << resources[i].path << "\", RESOURCE_" << i << ", " << resources[i].contents.size()
+            << "},\n";
+    }
+    if (resources.empty()) {
+        out << "        {\"\", nullptr, 0},\n";
+    }
+    out << "};\n\n} // namespace\n\nstd::span<const EmbeddedResource> embeddedResources() {\n"
+        << "    return std::span(RESOURCES).first(" << resources.size() << ");\n}\n";
+
+    // Leave an unchanged file alone so the executable is not relinked for nothing
+    const std::string generated = out.str();
+    std::string previous;
+    if (std::ifstream existing{argv[1], std::ios::binary}) {
+        previous.assign(std::istreambuf_iterator<char>(existing), std::istreambuf_iterator<char>());
+    }
+    if (previous != generated) {
+        std::ofstream file{argv[1], std::ios::binary};
+        if (!(file << generated)) {
+            std::cerr << "Failed to write " << argv[1] << std::endl;
+            return 1;
+        }
+    }
+    std::cout << "Embedded " << resources.size() << " resources" << std::endl;
+    return 0;
+}